@@ -78,7 +78,10 @@ int main(int _argc, char *_argv[])
   {
     uv::file f(uv::loop::Default(), _argv[i], O_CREAT|O_TRUNC|O_WRONLY, mode);
     if (f)
+    {
+      f.coalesce_writes(true);  // merge the adjacent chunk writes into single vectored writes
       files.emplace_back(std::move(f));
+    }
     else
       PRINT_UV_ERR(f.uv_status(), "file open (%s)", f.path());
   }
@@ -6,6 +6,17 @@
 #include "uvcc/loop.hpp"
 #include "uvcc/handle.hpp"
 #include "uvcc/request.hpp"
+#include "uvcc/mapped-file.hpp"
+#include "uvcc/stat-cache.hpp"
+#include "uvcc/file-tailer.hpp"
+#include "uvcc/dir-walker.hpp"
+#include "uvcc/future.hpp"
+#include "uvcc/parallel.hpp"
+#include "uvcc/executor.hpp"
+#include "uvcc/fs-ring.hpp"
+#include "uvcc/timer-wheel.hpp"
+#include "uvcc/session-table.hpp"
+#include "uvcc/coroutine.hpp"
 #include "uvcc/threading.hpp"
 #include "uvcc/endian.hpp"
 #include "uvcc/netstruct.hpp"
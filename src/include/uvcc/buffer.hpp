@@ -9,9 +9,13 @@
 #include <uv.h>
 
 #include <type_traits>       // is_standard_layout
-#include <utility>           // swap()
+#include <utility>           // swap() move()
 #include <initializer_list>  // initializer_list
 #include <functional>        // function
+#include <memory>            // shared_ptr make_shared() weak_ptr
+#include <mutex>             // lock_guard
+#include <new>               // placement new
+#include <vector>            // vector
 
 
 namespace uv
@@ -32,7 +36,9 @@ class buffer
   friend class write;
   friend class udp;
   friend class udp_send;
+  friend class udp_send_batch;
   friend class fs;
+  friend class slab_allocator;
   //! \endcond
 
 public: /*types*/
@@ -51,6 +57,7 @@ private: /*types*/
   public: /*data*/
     ref_count refs;
     type_storage< sink_cb_t > sink_cb_storage;
+    instance *slab = nullptr;  // the buffer which memory this one is carved out of by the slab_allocator
     std::size_t buf_count;
     uv_t uv_buf_struct;
 
@@ -94,6 +101,13 @@ private: /*types*/
       }
     }
 
+    /* construct a buffer placed at the beginning of the memory chunk carved out of the `_slab` buffer */
+    instance(instance *_slab, const std::size_t _len) : slab(_slab), buf_count(1)
+    {
+      uv_buf_struct.base = reinterpret_cast< char* >(&uv_buf_struct + 1) + alignment_padding(0);
+      uv_buf_struct.len = _len;
+    }
+
   public: /*constructors*/
     ~instance() = default;
 
@@ -123,9 +137,21 @@ private: /*types*/
         if (b.uv_buf)  // if not moved-form
         {
           b.uv_buf = nullptr;
-          if (refs.dec() == 0)  delete this;
+          if (refs.dec() == 0)  release();
         }
       }
+      else
+        release();
+    }
+
+    void release()
+    {
+      if (slab)
+      {
+        auto s = slab;
+        this->~instance();
+        s->unref();
+      }
       else
         delete this;
     }
@@ -134,6 +160,11 @@ private: /*types*/
     static uv_t* create(const std::initializer_list< std::size_t > &_len_values)
     { return &(new(_len_values) instance(_len_values))->uv_buf_struct; }
     static uv_t* create()  { return create({}); }
+    static uv_t* create(void *_place, instance *_slab, const std::size_t _len)
+    { return &(::new(_place) instance(_slab, _len))->uv_buf_struct; }
+
+    /* the size of the space taken by the instance preceding the buffer memory chunk */
+    static std::size_t header_size() noexcept  { return offsetof(instance, uv_buf_struct) + sizeof(uv_t) + alignment_padding(0); }
 
     constexpr static instance* from(uv_t *_uv_buf) noexcept
     {
@@ -266,6 +297,145 @@ public: /*conversion operators*/
 using on_buffer_alloc_t = std::function< buffer(handle _handle, std::size_t _suggested_size) >;
 
 
+
+/*! \ingroup doxy_group__buffer
+    \brief The input buffer allocator carving successive buffers out of large memory slabs.
+    \details Intended to be used as an `on_buffer_alloc_t` callback for `io::read_start()`/`udp::recv_start()`
+    instead of allocating a separate (and usually 64 KiB) buffer for every datagram or chunk of data:
+    ```
+    udp.recv_start(uv::slab_allocator(2048), recv_cb);
+    ```
+    Each allocated buffer has the length of `max_size()` and is placed in the current slab right after the previous
+    one. After the read callback, the next buffer starts right after the bytes actually having been read into the
+    previous one, so the slab memory is densely packed with the received data. When the rest of the slab is shorter
+    than `max_size()`, a new slab is taken.
+
+    The allocated buffers are usual reference counted `uv::buffer` instances, and each of them holds a reference to
+    its slab. A slab is recycled when all the buffers carved out of it have been released (up to `max_free()` slabs are
+    kept for reuse), so keeping a single buffer alive holds the whole slab in memory.
+
+    The allocator object can be copied; the copies share the same state.
+    \note The allocation is not thread-safe and should be performed on the loop thread, while the buffers can be
+    released on any thread. */
+class slab_allocator
+{
+private: /*types*/
+  struct state
+  {
+    std::size_t max_size;
+    std::size_t slab_size;
+    std::size_t max_free;
+    std::size_t slab_count = 0;
+    spinlock free_slabs_lock;
+    std::vector< buffer > free_slabs;
+    buffer slab;
+    std::size_t offset = 0;
+    buffer::uv_t *last = nullptr;  // the last allocated buffer, keep it until the next allocation to know how much of it has been used
+
+    ~state()  { if (last)  buffer::instance::from(last)->unref(); }
+  };
+
+private: /*data*/
+  std::shared_ptr< state > s;
+
+public: /*constructors*/
+  ~slab_allocator() = default;
+
+  /*! \brief Create an allocator providing buffers of `_max_size` bytes from the slabs of `_slab_size` bytes. */
+  explicit slab_allocator(std::size_t _max_size = 2048, std::size_t _slab_size = 256*1024, std::size_t _max_free = 4)
+    : s(std::make_shared< state >())
+  {
+    s->max_size = _max_size;
+    s->slab_size = greatest(_slab_size, buffer::instance::header_size() + _max_size);
+    s->max_free = _max_free;
+  }
+
+  slab_allocator(const slab_allocator&) = default;
+  slab_allocator& operator =(const slab_allocator&) = default;
+
+  slab_allocator(slab_allocator&&) noexcept = default;
+  slab_allocator& operator =(slab_allocator&&) noexcept = default;
+
+private: /*functions*/
+  static std::size_t align(std::size_t _size) noexcept
+  { return (_size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1); }
+
+  void next_slab() const
+  {
+    buffer slab;
+    {
+      std::lock_guard< decltype(s->free_slabs_lock) > lk(s->free_slabs_lock);
+      if (!s->free_slabs.empty())
+      {
+        slab = std::move(s->free_slabs.back());
+        s->free_slabs.pop_back();
+      }
+    }
+
+    if (!slab)
+    {
+      slab = buffer{ s->slab_size };
+      {
+        std::lock_guard< decltype(s->free_slabs_lock) > lk(s->free_slabs_lock);
+        ++s->slab_count;
+      }
+
+      std::weak_ptr< state > w(s);
+      slab.sink_cb() = [w](buffer &_slab)
+      {
+        auto st = w.lock();
+        if (!st)  return;
+
+        std::lock_guard< decltype(st->free_slabs_lock) > lk(st->free_slabs_lock);
+        if (st->free_slabs.size() < st->max_free)  st->free_slabs.push_back(std::move(_slab));
+        else  --st->slab_count;
+      };
+    }
+
+    s->slab = std::move(slab);
+    s->offset = 0;
+  }
+
+public: /*interface*/
+  /*! \brief Allocate a buffer. */
+  buffer allocate() const
+  {
+    if (s->last)
+    {
+      s->offset += align(buffer::instance::header_size() + s->last->len);
+      buffer::instance::from(s->last)->unref();
+      s->last = nullptr;
+    }
+
+    if (!s->slab or s->offset + buffer::instance::header_size() + s->max_size > s->slab_size)  next_slab();
+
+    auto slab_instance = buffer::instance::from(static_cast< buffer::uv_t* >(s->slab));
+    slab_instance->ref();
+    auto uv_buf = buffer::instance::create(s->slab.base() + s->offset, slab_instance, s->max_size);
+
+    buffer::instance::from(uv_buf)->ref();
+    s->last = uv_buf;
+    return buffer(uv_buf, adopt_ref);
+  }
+
+  /*! \brief The `on_buffer_alloc_t` callback interface. The suggested size is ignored. */
+  buffer operator ()(const handle&, std::size_t) const  { return allocate(); }
+
+  /*! \brief The size of the allocated buffers. */
+  std::size_t max_size() const noexcept  { return s->max_size; }
+  /*! \brief The size of the slabs. */
+  std::size_t slab_size() const noexcept  { return s->slab_size; }
+  /*! \brief The maximum number of the released slabs kept for reuse. */
+  std::size_t max_free() const noexcept  { return s->max_free; }
+  /*! \brief The number of the slabs currently existing (in use or kept for reuse). */
+  std::size_t slab_count() const noexcept
+  {
+    std::lock_guard< decltype(s->free_slabs_lock) > lk(s->free_slabs_lock);
+    return s->slab_count;
+  }
+};
+
+
 }
 
 
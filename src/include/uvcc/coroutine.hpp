@@ -0,0 +1,358 @@
+
+#ifndef UVCC_COROUTINE__HPP
+#define UVCC_COROUTINE__HPP
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include "uvcc/utility.hpp"
+#include "uvcc/loop.hpp"
+#include "uvcc/request-base.hpp"
+
+#include <uv.h>
+
+#include <coroutine>    // coroutine_handle suspend_never noop_coroutine
+#include <exception>    // exception_ptr current_exception() rethrow_exception()
+#include <functional>   // function
+#include <optional>     // optional
+#include <stdexcept>    // logic_error
+#include <tuple>        // tuple apply()
+#include <type_traits>  // is_void_v
+#include <utility>      // forward() move() exchange()
+
+
+namespace uv
+{
+/*! \defgroup doxy_group__coroutine  Coroutines
+    \brief C++20 coroutine support: the task type and awaitable wrappers for requests.
+    \details The definitions are only available when the compiler supports C++20 coroutines
+    (i.e. `__cpp_impl_coroutine` is defined), otherwise this header is empty. */
+//! \{
+
+
+template< typename _T_ = void > class task;
+
+
+using on_detached_exception_t = std::function< void(std::exception_ptr _exception) >;
+/*!< \brief The function type of the callback called with an exception escaped from a detached coroutine. */
+
+/*! \brief The process-wide callback called with an exception escaped from a detached coroutine (see `task`).
+    \details It is called on the thread that has resumed the coroutine, after the coroutine frame has been destroyed.
+    If the callback is empty, `std::terminate()` is called with the exception as the current one, so that
+    the terminate handler can report it. The callback must not throw.
+    \note The callback should be set before any coroutine is started. */
+inline on_detached_exception_t& on_detached_exception() noexcept
+{
+  static on_detached_exception_t cb;
+  return cb;
+}
+
+
+//! \cond internals
+//! \addtogroup doxy_group__internals
+//! \{
+
+class task_promise_base
+{
+  template< typename > friend class task;
+
+protected: /*data*/
+  std::coroutine_handle<> continuation;
+  std::exception_ptr exception;
+  std::optional< uv::loop > task_loop;
+  bool detached = false;
+
+public: /*constructors*/
+  task_promise_base() = default;
+  /*! \brief Catch the loop the coroutine is running on if it is passed as the first coroutine parameter. */
+  template< typename... _Args_ > task_promise_base(uv::loop &_loop, _Args_&&...) : task_loop(_loop)  {}
+
+public: /*interface*/
+  std::suspend_never initial_suspend() const noexcept  { return {}; }
+
+  template< class _Promise_ >
+  struct final_awaiter
+  {
+    bool await_ready() const noexcept  { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle< _Promise_ > _coro) noexcept
+    {
+      auto &promise = _coro.promise();
+      if (promise.continuation)  return promise.continuation;
+      if (promise.detached)
+      {
+        auto e = std::move(promise.exception);
+        _coro.destroy();
+        if (e)  report(std::move(e));
+      }
+      return std::noop_coroutine();
+    }
+    void await_resume() const noexcept  {}
+  };
+
+  /* an exception must not propagate out of a detached coroutine into the libuv callback that has resumed it */
+  static void report(std::exception_ptr _exception) noexcept
+  {
+    auto &cb = on_detached_exception();
+    if (cb)
+      cb(_exception);
+    else
+      std::rethrow_exception(_exception);  // out of a noexcept function: std::terminate() with it as the current exception
+  }
+
+  void unhandled_exception() noexcept  { exception = std::current_exception(); }
+};
+
+template< typename _T_ >
+class task_promise : public task_promise_base
+{
+  template< typename > friend class task;
+
+private: /*data*/
+  std::optional< _T_ > value;
+
+public: /*constructors*/
+  using task_promise_base::task_promise_base;
+
+public: /*interface*/
+  task< _T_ > get_return_object() noexcept;
+  final_awaiter< task_promise > final_suspend() const noexcept  { return {}; }
+
+  template< typename _U_ = _T_ > void return_value(_U_ &&_value)  { value.emplace(std::forward< _U_ >(_value)); }
+
+  _T_ get()
+  {
+    if (exception)  std::rethrow_exception(exception);
+    return std::move(*value);
+  }
+};
+
+template<>
+class task_promise< void > : public task_promise_base
+{
+  template< typename > friend class task;
+
+public: /*constructors*/
+  using task_promise_base::task_promise_base;
+
+public: /*interface*/
+  task< void > get_return_object() noexcept;
+  final_awaiter< task_promise > final_suspend() const noexcept  { return {}; }
+
+  void return_void() const noexcept  {}
+
+  void get()
+  {
+    if (exception)  std::rethrow_exception(exception);
+  }
+};
+
+//! \}
+//! \endcond
+
+
+/*! \brief The coroutine task type.
+    \details A coroutine returning `task< _T_ >` starts executing immediately on the calling thread (which is
+    expected to be a loop thread) and runs until its first suspension point. It is resumed afterwards from the libuv
+    callbacks, i.e. it keeps running on the thread of the loop where the awaited operations have been started.
+
+    A task can be awaited from another coroutine, or the loop can be run until the task completion with `wait()`.
+    If the coroutine's first parameter is of `uv::loop&` type, the task remembers the loop (see `loop()`).
+
+    Destroying a task object that has not been completed yet detaches the running coroutine: it will continue
+    running and its frame is destroyed automatically on completion. An exception escaping a detached coroutine
+    is passed to the `on_detached_exception()` callback, or terminates the program if the callback is not set.
+    \note The task is not thread-safe. */
+template< typename _T_ >
+class task
+{
+  //! \cond
+  friend class task_promise< _T_ >;
+  //! \endcond
+
+public: /*types*/
+  using value_type = _T_;
+  using promise_type = task_promise< _T_ >;
+
+private: /*data*/
+  std::coroutine_handle< promise_type > coro;
+
+private: /*constructors*/
+  explicit task(std::coroutine_handle< promise_type > _coro) noexcept : coro(_coro)  {}
+
+public: /*constructors*/
+  ~task()  { release(); }
+
+  task(const task&) = delete;
+  task& operator =(const task&) = delete;
+
+  task(task &&_that) noexcept : coro(std::exchange(_that.coro, nullptr))  {}
+  task& operator =(task &&_that) noexcept
+  {
+    if (this != &_that)
+    {
+      release();
+      coro = std::exchange(_that.coro, nullptr);
+    }
+    return *this;
+  }
+
+private: /*functions*/
+  void release() noexcept
+  {
+    if (!coro)  return;
+    if (coro.done())
+      coro.destroy();
+    else
+      coro.promise().detached = true;
+    coro = nullptr;
+  }
+
+public: /*interface*/
+  /*! \brief Check if the coroutine has completed. */
+  bool done() const noexcept  { return !coro or coro.done(); }
+
+  /*! \brief The loop the coroutine has been started with, if it was passed as the first coroutine parameter. */
+  const std::optional< uv::loop >& loop() const noexcept  { return coro.promise().task_loop; }
+
+  /*! \brief Get the result of the completed coroutine or rethrow the exception escaped from it.
+      \note Throws `std::logic_error` if the coroutine has not been completed yet. */
+  _T_ get()
+  {
+    if (!done())  throw std::logic_error(__PRETTY_FUNCTION__);
+    return coro.promise().get();
+  }
+
+  /*! \brief Run the loop `_loop` until the coroutine completes and return its result.
+      \details Throws `std::logic_error` if the loop has no more active handles and requests but the coroutine
+      has not been completed. */
+  _T_ wait(uv::loop &_loop)
+  {
+    while (!done())  if (_loop.run(UV_RUN_ONCE) == 0 and !done())  throw std::logic_error(__PRETTY_FUNCTION__);
+    return get();
+  }
+  /*! \brief Idem for the loop the coroutine has been started with. */
+  _T_ wait()
+  {
+    auto &l = loop();
+    if (!l)  throw std::logic_error(__PRETTY_FUNCTION__);
+    uv::loop task_loop = *l;
+    return wait(task_loop);
+  }
+
+  /*! \brief Make the task awaitable from another coroutine. */
+  auto operator co_await() && noexcept
+  {
+    struct awaiter
+    {
+      std::coroutine_handle< promise_type > coro;
+
+      bool await_ready() const noexcept  { return !coro or coro.done(); }
+      void await_suspend(std::coroutine_handle<> _continuation) const noexcept  { coro.promise().continuation = _continuation; }
+      _T_ await_resume() const  { return coro.promise().get(); }
+    };
+    return awaiter{ coro };
+  }
+  auto operator co_await() & noexcept  { return std::move(*this).operator co_await(); }
+};
+
+//! \cond
+template< typename _T_ >
+task< _T_ > task_promise< _T_ >::get_return_object() noexcept
+{ return task< _T_ >(std::coroutine_handle< task_promise >::from_promise(*this)); }
+
+inline task< void > task_promise< void >::get_return_object() noexcept
+{ return task< void >(std::coroutine_handle< task_promise >::from_promise(*this)); }
+//! \endcond
+
+
+
+/*! \brief The awaitable object for running a request from a coroutine.
+    \details The awaiter is a temporary object that lives in the coroutine frame for the duration of the
+    `co_await` expression. On suspension, it substitutes the request callback with the one resuming the coroutine,
+    and then calls `_Request_::run()` with the given arguments. When the request completes, the original callback is
+    restored and the coroutine is resumed; the `co_await` expression yields the `uv_status()` value of the request.
+    If `run()` fails, the coroutine is not suspended at all and gets the error code immediately.
+
+    The resuming callback captures only a pointer to the awaiter and fits into the small object buffer of
+    `std::function`, so awaiting a request does not allocate anything beyond the request itself.
+
+    The request can be cancelled while the coroutine is suspended by calling `request::cancel()` on it from
+    elsewhere; the coroutine is resumed with `UV_ECANCELED` status then.
+    \sa `uv::co_run()` */
+template< class _Request_, typename... _Args_ >
+class request_awaiter
+{
+private: /*data*/
+  _Request_ &req;
+  std::tuple< _Args_&&... > args;
+  typename _Request_::on_request_t saved_cb;
+  std::coroutine_handle<> coro;
+
+public: /*constructors*/
+  ~request_awaiter() = default;
+
+  explicit request_awaiter(_Request_ &_req, _Args_&&... _args) : req(_req), args(std::forward< _Args_ >(_args)...)  {}
+
+  request_awaiter(const request_awaiter&) = delete;
+  request_awaiter& operator =(const request_awaiter&) = delete;
+
+  request_awaiter(request_awaiter&&) = default;
+  request_awaiter& operator =(request_awaiter&&) = delete;
+
+public: /*interface*/
+  bool await_ready() const noexcept  { return false; }
+
+  bool await_suspend(std::coroutine_handle<> _coro)
+  {
+    coro = _coro;
+    saved_cb = std::move(req.on_request());
+    req.on_request() = [this](auto&&...)
+    {
+      auto self = this;  // the closure object is destroyed by the following assignment
+      self->req.on_request() = std::move(self->saved_cb);
+      self->coro.resume();
+    };
+
+    int ret = std::apply(
+        [this](auto&&... _args) -> int
+        {
+          if constexpr (std::is_void_v< decltype(req.run(std::forward< decltype(_args) >(_args)...)) >)
+          {
+            req.run(std::forward< decltype(_args) >(_args)...);
+            return 0;
+          }
+          else
+            return req.run(std::forward< decltype(_args) >(_args)...);
+        },
+        args
+    );
+    if (ret < 0)
+    {
+      req.on_request() = std::move(saved_cb);
+      return false;
+    }
+
+    return true;
+  }
+
+  int await_resume() const noexcept  { return req.uv_status(); }
+};
+
+
+/*! \brief Run the request from a coroutine: `co_await uv::co_run(request, run_arguments...)`.
+    \details The arguments are passed to the `_request.run()` function as is. They are forwarded by reference,
+    which is valid until the end of the full `co_await` expression.
+    \sa `uv::request_awaiter` */
+template< class _Request_, typename... _Args_ >
+request_awaiter< _Request_, _Args_... > co_run(_Request_ &_request, _Args_&&... _args)
+{
+  return request_awaiter< _Request_, _Args_... >(_request, std::forward< _Args_ >(_args)...);
+}
+
+
+//! \}
+}
+
+
+#endif
+
+#endif
@@ -0,0 +1,466 @@
+
+#ifndef UVCC_DIR_WALKER__HPP
+#define UVCC_DIR_WALKER__HPP
+
+#include "uvcc/utility.hpp"
+#include "uvcc/loop.hpp"
+#include "uvcc/request-fs.hpp"
+#include "uvcc/executor.hpp"
+
+#include <cstddef>      // size_t
+#include <cstdint>      // uint64_t
+#include <cstring>      // memset()
+#include <uv.h>
+
+#ifndef _WIN32
+#include <sys/stat.h>   // lstat() struct statx S_ISDIR()
+#include <fcntl.h>      // AT_FDCWD AT_SYMLINK_NOFOLLOW
+#include <unistd.h>     // syscall()
+#include <cerrno>       // errno
+#endif
+#ifdef __linux__
+#include <sys/syscall.h>   // __NR_statx
+#include <sys/sysmacros.h> // makedev()
+#endif
+
+#include <atomic>       // atomic
+#include <functional>   // function
+#include <memory>       // shared_ptr make_shared() unique_ptr
+#include <string>       // string
+#include <utility>      // move() pair
+#include <vector>       // vector
+
+
+namespace uv
+{
+
+
+/*! \ingroup doxy_group__request
+    \brief The recursive directory tree walker reading several directories concurrently.
+    \details The directories are read with `fs::readdir` requests, up to `concurrency()` of them at the same time, and
+    the entries are delivered to the `on_entries()` callback on the loop thread in batches, as they have been read.
+    The subdirectories found are queued for reading, the deeper ones first, so that the queue stays short.
+
+    The entries can be selected with the `on_filter()` callback, and the subdirectories can be excluded from
+    the traversal with the `on_prune()` callback. The symbolic links are not followed.
+
+    If `stat_mode()` is other than `NONE`, the status information of the selected entries is retrieved before they are
+    delivered, with a single thread pool task per batch. With `STATX` the Linux
+    [`statx()`](http://man7.org/linux/man-pages/man2/statx.2.html) system call is used, fetching only the fields
+    specified by `statx_mask()`; it falls back to `lstat()` where not available. The status information is also
+    retrieved for the entries whose type has not been reported by the filesystem, to find out if they are directories.
+
+    The walker object is not copyable and not movable. Destroying it stops the walk, no callbacks are called afterwards.
+    \note The walker is not thread-safe and all its operations should be performed on the loop thread. */
+class dir_walker
+{
+public: /*types*/
+  /*! \brief The directory entry. */
+  struct entry
+  {
+    const char *path;           /*!< the entry path: the root path joined with the relative path of the entry */
+    const char *name;           /*!< the entry name, i.e. the last component of the `path` */
+    uint64_t ino;               /*!< the inode number */
+    ::uv_dirent_type_t type;    /*!< the entry type */
+    unsigned depth;             /*!< the depth of the entry, **0** for the entries of the root directory */
+    const ::uv_stat_t *stat;    /*!< the status information, or `nullptr` if it has not been retrieved or has failed */
+    int stat_status;            /*!< the status value of the status information retrieval, **0** if it has not been done */
+  };
+
+  /*! \brief The ways of retrieving the status information of the entries. */
+  enum class stat_kind : int
+  {
+      NONE,   /*!< don't retrieve, unless needed to find out the entry type */
+      LSTAT,  /*!< `lstat()` */
+      STATX   /*!< `statx()` with the `statx_mask()` fields */
+  };
+
+  using on_entries_t = std::function< void(const entry *_entries, std::size_t _count) >;
+  /*!< \brief The function type of the callback called with a batch of entries. The `_entries` are valid within
+       the callback only. */
+  using on_filter_t = std::function< bool(const entry &_entry) >;
+  /*!< \brief The function type of the callback selecting the entries to deliver (returns `true` for them).
+       \details It is called before the status information is retrieved, so `_entry.stat` is `nullptr`. */
+  using on_prune_t = std::function< bool(const entry &_entry) >;
+  /*!< \brief The function type of the callback called for each subdirectory, returning `true` to skip reading it. */
+  using on_error_t = std::function< void(const char *_path, int _uv_status) >;
+  /*!< \brief The function type of the callback called when a subdirectory cannot be read. */
+  using on_done_t = std::function< void(int _uv_status) >;
+  /*!< \brief The function type of the callback called when the walk has completed.
+       \details `_uv_status` is the status of reading the root directory, or `UV_ECANCELED` if the walk has been
+       stopped. */
+
+private: /*types*/
+  struct item
+  {
+    std::size_t path_off, name_off;  // the offsets within reader::arena
+    uint64_t ino;
+    ::uv_dirent_type_t type;
+    bool selected;
+    bool need_stat;
+    int stat_status;
+    ::uv_stat_t statbuf;
+  };
+
+  struct state;
+
+  struct reader
+  {
+    ::uv_work_t uv_work;
+    state *st = nullptr;
+    std::string path;
+    unsigned depth = 0;
+    fs::readdir rd;
+    std::string arena;
+    std::vector< item > items;
+  };
+
+  struct state
+  {
+    uv::loop loop;
+    unsigned concurrency = 8;
+    stat_kind mode = stat_kind::NONE;
+    unsigned statx_mask = 0x7FF;  // STATX_BASIC_STATS
+    std::size_t buffer_size = 32*1024;
+    std::atomic< bool > no_statx{ false };
+
+    on_entries_t entries_cb;
+    on_filter_t filter_cb;
+    on_prune_t prune_cb;
+    on_error_t error_cb;
+    on_done_t done_cb;
+
+    std::shared_ptr< state > self;  // keeps the state alive while the walk is in progress
+    std::vector< std::pair< std::string, unsigned > > pending;  // the directories to be read
+    std::vector< std::unique_ptr< reader > > readers;
+    std::string root;
+    unsigned active = 0;
+    bool running = false;
+    bool stopped = false;
+    int status = 0;
+    uint64_t nentries = 0, ndirs = 0;
+
+    explicit state(uv::loop &_loop) : loop(_loop)  {}
+
+    void pump()
+    {
+      auto keep = self;  // a reader failing to start may complete the walk
+      while (!stopped and active < concurrency and !pending.empty())
+      {
+        auto d = std::move(pending.back());
+        pending.pop_back();
+        start_reader(std::move(d.first), d.second);
+      }
+
+      if (running and active == 0 and (stopped or pending.empty()))
+      {
+        running = false;
+        pending.clear();
+        self.reset();
+        if (done_cb)  done_cb(stopped ? UV_ECANCELED : status);
+      }
+    }
+
+    void start_reader(std::string &&_path, unsigned _depth)
+    {
+      readers.emplace_back(new reader);
+      auto r = readers.back().get();
+      r->st = this;
+      r->path = std::move(_path);
+      r->depth = _depth;
+      r->uv_work.data = r;
+      r->rd.buffer_size(buffer_size);
+      r->rd.on_request() = [r](fs::readdir _req){ r->st->on_read(r, _req); };
+      ++active;
+      ++ndirs;
+
+      auto uv_ret = r->rd.run(loop, r->path.c_str());
+      if (uv_ret < 0)  fail_reader(r, uv_ret);
+    }
+
+    void finish_reader(reader *_r)
+    {
+      --active;
+      for (auto it = readers.begin(); it != readers.end(); ++it)  if (it->get() == _r)
+      {
+        std::swap(*it, readers.back());
+        readers.pop_back();
+        break;
+      }
+      pump();
+    }
+
+    void fail_reader(reader *_r, int _uv_status)
+    {
+      if (_r->depth == 0 and _r->path == root)
+        status = _uv_status;
+      else if (error_cb)
+        error_cb(_r->path.c_str(), _uv_status);
+      finish_reader(_r);
+    }
+
+    static entry make_entry(const reader &_r, const item &_i, bool _with_stat) noexcept
+    {
+      return entry{
+          _r.arena.data() + _i.path_off, _r.arena.data() + _i.name_off, _i.ino, _i.type, _r.depth,
+          _with_stat and _i.need_stat and _i.stat_status >= 0 ? &_i.statbuf : nullptr, _i.stat_status
+      };
+    }
+
+    void on_read(reader *_r, fs::readdir &_req)
+    {
+      if (!_req)  return fail_reader(_r, _req.uv_status());
+      if (stopped or _req.eof())  return finish_reader(_r);
+
+      _r->arena.clear();
+      _r->items.clear();
+      bool any_stat = false;
+      for (auto &e : _req)
+      {
+        item i;
+        i.path_off = _r->arena.size();
+        _r->arena.append(_r->path);
+        if (_r->path.empty() or _r->path.back() != '/')  _r->arena.push_back('/');
+        i.name_off = _r->arena.size();
+        _r->arena.append(e.name);
+        _r->arena.push_back('\0');
+        i.ino = e.ino;
+        i.type = e.type;
+        i.stat_status = 0;
+        i.need_stat = false;
+        i.selected = true;
+        _r->items.push_back(i);
+      }
+      for (auto &i : _r->items)
+      {
+        if (filter_cb)  i.selected = filter_cb(make_entry(*_r, i, false));
+        i.need_stat = (mode != stat_kind::NONE and i.selected) or i.type == UV_DIRENT_UNKNOWN;
+        any_stat |= i.need_stat;
+      }
+
+      if (!any_stat)  return complete_batch(_r);
+
+      auto uv_ret = executors::route(executors::pool::FS, static_cast< uv::loop::uv_t* >(loop),
+          [_r](){ stat_batch(*_r); return 0; },
+          [_r](int _status){ after_stat_cb(&_r->uv_work, _status); }
+      );
+      if (uv_ret == UV_ENOSYS)  uv_ret = ::uv_queue_work(static_cast< uv::loop::uv_t* >(loop), &_r->uv_work, stat_work_cb, after_stat_cb);
+      if (uv_ret < 0)  fail_reader(_r, uv_ret);
+    }
+
+    void complete_batch(reader *_r)
+    {
+      if (stopped)  return finish_reader(_r);
+
+      bool with_stat = mode != stat_kind::NONE;
+      std::vector< entry > batch;
+      batch.reserve(_r->items.size());
+      for (auto &i : _r->items)  if (i.selected)  batch.push_back(make_entry(*_r, i, with_stat));
+
+      nentries += batch.size();
+      if (!batch.empty() and entries_cb)  entries_cb(batch.data(), batch.size());
+
+      for (auto &i : _r->items)  if (i.type == UV_DIRENT_DIR)
+      {
+        if (prune_cb and prune_cb(make_entry(*_r, i, with_stat)))  continue;
+        pending.emplace_back(std::string(_r->arena.data() + i.path_off), _r->depth + 1);
+      }
+
+      if (stopped)  return finish_reader(_r);
+      pump();
+
+      auto uv_ret = _r->rd.next();
+      if (uv_ret < 0)  fail_reader(_r, uv_ret);
+    }
+
+    /* retrieve the status information of the batch entries, it is run on a thread pool thread */
+    static void stat_batch(reader &_r)
+    {
+      auto &st = *_r.st;
+      for (auto &i : _r.items)  if (i.need_stat)
+      {
+        auto path = _r.arena.data() + i.path_off;
+        std::memset(&i.statbuf, 0, sizeof(i.statbuf));
+        i.stat_status = UV_ENOSYS;
+#if defined(__linux__) && defined(__NR_statx) && defined(STATX_BASIC_STATS)
+        if (st.mode == stat_kind::STATX and !st.no_statx.load(std::memory_order_relaxed))
+        {
+          struct ::statx stx;
+          auto mask = i.type == UV_DIRENT_UNKNOWN ? st.statx_mask | STATX_TYPE : st.statx_mask;
+          if (::syscall(__NR_statx, AT_FDCWD, path, AT_SYMLINK_NOFOLLOW, mask, &stx) == 0)
+          {
+            auto &s = i.statbuf;
+            s.st_dev = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+            s.st_mode = stx.stx_mode;
+            s.st_nlink = stx.stx_nlink;
+            s.st_uid = stx.stx_uid;
+            s.st_gid = stx.stx_gid;
+            s.st_rdev = makedev(stx.stx_rdev_major, stx.stx_rdev_minor);
+            s.st_ino = stx.stx_ino;
+            s.st_size = stx.stx_size;
+            s.st_blksize = stx.stx_blksize;
+            s.st_blocks = stx.stx_blocks;
+            s.st_atim = { stx.stx_atime.tv_sec, stx.stx_atime.tv_nsec };
+            s.st_mtim = { stx.stx_mtime.tv_sec, stx.stx_mtime.tv_nsec };
+            s.st_ctim = { stx.stx_ctime.tv_sec, stx.stx_ctime.tv_nsec };
+            s.st_birthtim = { stx.stx_btime.tv_sec, stx.stx_btime.tv_nsec };
+            i.stat_status = 0;
+          }
+          else if (errno == ENOSYS)
+            st.no_statx.store(true, std::memory_order_relaxed);
+          else
+            i.stat_status = -errno;
+
+          if (i.stat_status != UV_ENOSYS)
+          {
+            resolve_type(i);
+            continue;
+          }
+        }
+#endif
+#ifndef _WIN32
+        struct ::stat sb;
+        if (::lstat(path, &sb) == 0)
+        {
+          auto &s = i.statbuf;
+          s.st_dev = sb.st_dev;
+          s.st_mode = sb.st_mode;
+          s.st_nlink = sb.st_nlink;
+          s.st_uid = sb.st_uid;
+          s.st_gid = sb.st_gid;
+          s.st_rdev = sb.st_rdev;
+          s.st_ino = sb.st_ino;
+          s.st_size = sb.st_size;
+          s.st_blksize = sb.st_blksize;
+          s.st_blocks = sb.st_blocks;
+          s.st_atim = { sb.st_atim.tv_sec, sb.st_atim.tv_nsec };
+          s.st_mtim = { sb.st_mtim.tv_sec, sb.st_mtim.tv_nsec };
+          s.st_ctim = { sb.st_ctim.tv_sec, sb.st_ctim.tv_nsec };
+          i.stat_status = 0;
+        }
+        else
+          i.stat_status = -errno;
+#endif
+        resolve_type(i);
+      }
+    }
+
+    static void resolve_type(item &_i) noexcept
+    {
+#ifndef _WIN32
+      if (_i.type != UV_DIRENT_UNKNOWN or _i.stat_status < 0)  return;
+      auto m = _i.statbuf.st_mode;
+      _i.type = S_ISREG(m) ? UV_DIRENT_FILE : S_ISDIR(m) ? UV_DIRENT_DIR : S_ISLNK(m) ? UV_DIRENT_LINK :
+          S_ISFIFO(m) ? UV_DIRENT_FIFO : S_ISSOCK(m) ? UV_DIRENT_SOCKET : S_ISCHR(m) ? UV_DIRENT_CHAR :
+          S_ISBLK(m) ? UV_DIRENT_BLOCK : UV_DIRENT_UNKNOWN;
+#endif
+    }
+
+    static void stat_work_cb(::uv_work_t *_uv_work)  { stat_batch(*static_cast< reader* >(_uv_work->data)); }
+
+    static void after_stat_cb(::uv_work_t *_uv_work, int _status)
+    {
+      auto r = static_cast< reader* >(_uv_work->data);
+      if (_status < 0)
+        r->st->fail_reader(r, _status);
+      else
+        r->st->complete_batch(r);
+    }
+  };
+
+private: /*data*/
+  std::shared_ptr< state > st;
+
+public: /*constructors*/
+  ~dir_walker()
+  {
+    auto &s = *st;
+    s.entries_cb = nullptr;
+    s.filter_cb = nullptr;
+    s.prune_cb = nullptr;
+    s.error_cb = nullptr;
+    s.done_cb = nullptr;
+    stop();
+  }
+
+  /*! \brief Create a directory tree walker for the `_loop`. */
+  explicit dir_walker(uv::loop &_loop) : st(std::make_shared< state >(_loop))  {}
+
+  dir_walker(const dir_walker&) = delete;
+  dir_walker& operator =(const dir_walker&) = delete;
+
+  dir_walker(dir_walker&&) = delete;
+  dir_walker& operator =(dir_walker&&) = delete;
+
+public: /*interface*/
+  /*! \brief Set the callback receiving the batches of entries. */
+  on_entries_t& on_entries() const noexcept  { return st->entries_cb; }
+  /*! \brief Set the callback selecting the entries to deliver. All entries are delivered if it is empty. */
+  on_filter_t& on_filter() const noexcept  { return st->filter_cb; }
+  /*! \brief Set the callback excluding subdirectories from the traversal. */
+  on_prune_t& on_prune() const noexcept  { return st->prune_cb; }
+  /*! \brief Set the callback reporting the subdirectories that cannot be read. */
+  on_error_t& on_error() const noexcept  { return st->error_cb; }
+  /*! \brief Set the callback called when the walk has completed. */
+  on_done_t& on_done() const noexcept  { return st->done_cb; }
+
+  /*! \brief The maximum number of the directories being read at the same time (default is 8). */
+  unsigned concurrency() const noexcept  { return st->concurrency; }
+  /*! \brief Set the maximum number of the directories being read at the same time. */
+  void concurrency(unsigned _value) noexcept  { st->concurrency = greatest(_value, 1u); }
+
+  /*! \brief The way of retrieving the status information of the entries (default is `stat_kind::NONE`). */
+  stat_kind stat_mode() const noexcept  { return st->mode; }
+  /*! \brief Set the way of retrieving the status information of the entries. */
+  void stat_mode(stat_kind _value) noexcept  { st->mode = _value; }
+
+  /*! \brief The `statx()` fields mask used with `stat_kind::STATX` (default is `STATX_BASIC_STATS`). */
+  unsigned statx_mask() const noexcept  { return st->statx_mask; }
+  /*! \brief Set the `statx()` fields mask used with `stat_kind::STATX`. */
+  void statx_mask(unsigned _value) noexcept  { st->statx_mask = _value; }
+
+  /*! \brief The size of the buffer each directory is read with (default is 32 KiB). \sa `fs::readdir::buffer_size()` */
+  std::size_t buffer_size() const noexcept  { return st->buffer_size; }
+  /*! \brief Set the size of the buffer each directory is read with. */
+  void buffer_size(std::size_t _value) noexcept  { st->buffer_size = _value; }
+
+  /*! \brief The number of the entries delivered so far. */
+  uint64_t entries() const noexcept  { return st->nentries; }
+  /*! \brief The number of the directories read so far, including the root one. */
+  uint64_t directories() const noexcept  { return st->ndirs; }
+
+  /*! \brief Check if the walk is in progress. */
+  bool is_running() const noexcept  { return st->running; }
+
+  /*! \brief Start walking the directory tree under `_root`.
+      \returns `UV_EBUSY` if the walk is already in progress, or **0**. The errors of reading the root directory
+      are reported to the `on_done()` callback. */
+  int run(std::string _root)
+  {
+    auto &s = *st;
+    if (s.running)  return UV_EBUSY;
+
+    s.root = _root;
+    s.status = 0;
+    s.stopped = false;
+    s.nentries = s.ndirs = 0;
+    s.running = true;
+    s.self = st;
+    s.pending.emplace_back(std::move(_root), 0);
+    s.pump();
+    return 0;
+  }
+
+  /*! \brief Stop the walk. The directories being read are abandoned after the current batches, and
+      the `on_done()` callback is called with `UV_ECANCELED` status. */
+  void stop() noexcept
+  {
+    if (st->running)  st->stopped = true;
+  }
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,906 @@
+
+#ifndef UVCC_EXECUTOR__HPP
+#define UVCC_EXECUTOR__HPP
+
+#include "uvcc/utility.hpp"
+#include "uvcc/loop.hpp"
+#include "uvcc/request-base.hpp"
+#include "uvcc/fs-ring.hpp"
+
+#include <cstddef>      // size_t
+#include <cstdint>      // uint64_t
+#include <cstdlib>      // malloc() free()
+#include <cstring>      // strlen() memcpy()
+#include <uv.h>
+
+#include <atomic>              // atomic memory_order_*
+#include <condition_variable>  // condition_variable
+#include <deque>               // deque
+#include <memory>              // unique_ptr
+#include <mutex>               // mutex lock_guard unique_lock
+#include <thread>              // thread this_thread
+#include <tuple>               // tuple get()
+#include <type_traits>         // decay_t
+#include <unordered_map>       // unordered_map
+#include <utility>             // swap() forward() move() index_sequence
+#include <vector>              // vector
+
+
+namespace uv
+{
+
+
+/*! \defgroup doxy_group__executor  Executor
+    \brief The thread pool alternative to the libuv built-in one. */
+
+/*! \ingroup doxy_group__executor
+    \brief A work-stealing thread pool with task priorities.
+    \details The libuv thread pool (used by `uv_queue_work()`) is a single global FIFO queue served by a fixed
+    number of threads. So a long-running batch job queued before a latency-critical task delays it till one of the
+    threads gets free. The executor is an alternative pool that can be used instead of the libuv one for running
+    `uv::work` requests (see `work::run()`) or any user-defined `executor::task`:
+    - each worker thread has its own task queues, and an idle worker steals tasks from the other workers' queues;
+    - the tasks have priorities: a worker always takes a higher priority task first, and a number of threads can be
+      reserved for the `HIGH` and `NORMAL` priority tasks only (see `reserved_threads()`), so that the `LOW` priority
+      tasks can never occupy the whole pool;
+    - the number of worker threads can be changed at run time (see `threads()`);
+    - the queue waiting time and the run time of each task are measured, and accumulated statistics per priority
+      level are available (see `stats()`).
+
+    As with the libuv thread pool, the task completion callback is called on the thread of the loop where the task
+    has been submitted from. While a loop has some uncompleted tasks submitted to the executor, it is kept alive with
+    an internal `uv_async_t` handle; the handle is closed when all the tasks have been completed.
+
+    The executor is a reference-counted object; every uncompleted task holds an extra reference to its executor.
+    \note `submit()` and `cancel()` should be called on the thread of the loop the task is submitted to;
+    all the other functions are thread-safe. */
+class executor
+{
+  //! \cond
+  friend class executors;
+  //! \endcond
+
+public: /*types*/
+  class task;
+
+  /*! \brief The task priority levels. */
+  enum class priority : unsigned  { HIGH, NORMAL, LOW };
+
+  /*! \brief The accumulated statistics for one priority level.
+      \details All times are in nanoseconds. */
+  struct statistics
+  {
+    uint64_t completed = 0;      /*!< \brief The number of completed tasks. */
+    uint64_t cancelled = 0;      /*!< \brief The number of tasks cancelled before they have been started. */
+    uint64_t wait_time = 0;      /*!< \brief The total time spent by the completed tasks in the queues. */
+    uint64_t max_wait_time = 0;  /*!< \brief The maximum time spent by a task in the queues. */
+    uint64_t run_time = 0;       /*!< \brief The total run time of the completed tasks. */
+  };
+
+private: /*types*/
+  class instance;
+
+  enum : unsigned  { PRIORITIES = 3 };
+
+public: /*types*/
+  /*! \brief A unit of work that can be submitted to the executor.
+      \details This is an intrusive queue node which is designed to be embedded into the user's data structure,
+      in the manner of `uv_work_t`. `work_cb` is called on one of the executor threads; `after_work_cb` is called
+      on the loop thread afterwards, with **0** status value, or `UV_ECANCELED` if the task has been cancelled.
+      The task object should stay valid until `after_work_cb` is called. It is not copyable and not movable.
+      \note `work_cb` must not throw exceptions. */
+  class task
+  {
+    //! \cond
+    friend class executor;
+    friend class instance;
+    //! \endcond
+
+  public: /*types*/
+    using work_cb_t = void (*)(task *_task);
+    using after_work_cb_t = void (*)(task *_task, int _status);
+
+  private: /*data*/
+    work_cb_t work_cb = nullptr;
+    after_work_cb_t after_work_cb = nullptr;
+    void *task_data = nullptr;
+    void *chan = nullptr;  // the completion channel of the loop the task has been submitted from; non-null while the task is in progress
+    executor::priority prio = executor::priority::NORMAL;
+    int status = 0;
+    uint64_t t_queued = 0, t_started = 0, t_finished = 0;
+
+  public: /*constructors*/
+    ~task() = default;
+
+    task() = default;
+    task(work_cb_t _work_cb, after_work_cb_t _after_work_cb) : work_cb(_work_cb), after_work_cb(_after_work_cb)  {}
+
+    task(const task&) = delete;
+    task& operator =(const task&) = delete;
+
+    task(task&&) = delete;
+    task& operator =(task&&) = delete;
+
+  public: /*interface*/
+    /*! \brief The function called on an executor thread. */
+    work_cb_t& on_work() noexcept  { return work_cb; }
+    /*! \brief The function called on the loop thread after the task has been completed or cancelled. */
+    after_work_cb_t& on_after_work() noexcept  { return after_work_cb; }
+
+    /*! \brief The pointer to the user-defined arbitrary data. */
+    void* const& data() const noexcept  { return task_data; }
+    void*      & data()       noexcept  { return task_data; }
+
+    /*! \brief Check if the task is submitted and has not been completed yet. */
+    bool is_active() const noexcept  { return chan != nullptr; }
+
+    /*! \brief The priority the task has been submitted with. */
+    executor::priority priority() const noexcept  { return prio; }
+
+    /*! \brief The time (in nanoseconds) the task has spent in the queue before it has been started. */
+    uint64_t wait_time() const noexcept  { return t_started ? t_started - t_queued : 0; }
+    /*! \brief The time (in nanoseconds) the task has been running. */
+    uint64_t run_time() const noexcept  { return t_finished ? t_finished - t_started : 0; }
+  };
+
+private: /*types*/
+  class instance
+  {
+    struct worker
+    {
+      spinlock lock;
+      bool active = false;
+      std::deque< task* > queues[PRIORITIES];
+      std::thread thread;
+    };
+
+    struct channel
+    {
+      ::uv_async_t uv_async;
+      instance *pool;
+      std::size_t outstanding = 0;  // accessed on the loop thread only
+      spinlock lock;
+      std::vector< task* > completed;
+      std::vector< task* > batch;
+    };
+
+    struct counters
+    {
+      std::atomic< uint64_t > completed, cancelled, wait_time, max_wait_time, run_time;
+      counters() : completed(0), cancelled(0), wait_time(0), max_wait_time(0), run_time(0)  {}
+    };
+
+  public: /*data*/
+    mutable int uv_error = 0;
+    ref_count refs;
+
+  private: /*data*/
+    const unsigned max_threads;
+    std::unique_ptr< worker[] > workers;
+    std::mutex control;  // serializes threads() changes and the destruction
+    std::atomic< unsigned > target;  // the required number of threads
+    std::atomic< unsigned > spawned;  // the high-water mark of the worker indices that have been ever started
+    std::atomic< unsigned > reserved;
+    std::atomic< unsigned > low_running;
+    std::atomic< unsigned > next_worker;
+    std::atomic< std::size_t > queued;
+    std::atomic< std::size_t > pending;
+    std::atomic< uint64_t > stolen;
+    std::atomic< bool > shutdown;
+
+    std::mutex idle_lock;
+    std::condition_variable idle_cv;
+    std::atomic< uint64_t > seq;  // incremented on every event a sleeping worker can be interested in
+
+    std::mutex channels_lock;
+    std::unordered_map< uv::loop::uv_t*, channel* > channels;
+
+    counters stat[PRIORITIES];
+
+  private: /*constructors*/
+    instance(unsigned _threads, unsigned _max_threads)
+      : max_threads(greatest(1U, _max_threads)), workers(new worker[greatest(1U, _max_threads)]),
+        target(0), spawned(0), reserved(0), low_running(0), next_worker(0), queued(0), pending(0), stolen(0), shutdown(false), seq(0)
+    {
+      set_threads(_threads);
+      reserved = target > 1 ? 1 : 0;
+    }
+
+  public: /*constructors*/
+    ~instance()
+    {
+      std::lock_guard< std::mutex > lk(control);
+      shutdown = true;
+      wake_all();
+      for (unsigned i = 0; i < spawned; ++i)  if (workers[i].thread.joinable())
+      {
+        if (workers[i].thread.get_id() == std::this_thread::get_id())
+          workers[i].thread.detach();
+        else
+          workers[i].thread.join();
+      }
+    }
+
+    instance(const instance&) = delete;
+    instance& operator =(const instance&) = delete;
+
+    instance(instance&&) = delete;
+    instance& operator =(instance&&) = delete;
+
+  private: /*functions*/
+    void destroy()  { delete this; }
+
+    void wake_one()
+    {
+      seq.fetch_add(1, std::memory_order_release);
+      { std::lock_guard< std::mutex > lk(idle_lock); }
+      idle_cv.notify_one();
+    }
+    void wake_all()
+    {
+      seq.fetch_add(1, std::memory_order_release);
+      { std::lock_guard< std::mutex > lk(idle_lock); }
+      idle_cv.notify_all();
+    }
+
+    bool acquire_low() noexcept
+    {
+      auto t = target.load(std::memory_order_relaxed), r = reserved.load(std::memory_order_relaxed);
+      auto limit = t > r ? t - r : 1;
+      auto n = low_running.load(std::memory_order_relaxed);
+      do
+        if (n >= limit)  return false;
+      while (!low_running.compare_exchange_weak(n, n+1, std::memory_order_relaxed, std::memory_order_relaxed));
+      return true;
+    }
+    void release_low()
+    {
+      low_running.fetch_sub(1, std::memory_order_relaxed);
+      wake_one();
+    }
+
+    task* take(unsigned _w)
+    {
+      const unsigned nworkers = spawned.load(std::memory_order_acquire);
+      for (unsigned p = 0; p < PRIORITIES; ++p)
+      {
+        if (p == unsigned(priority::LOW) and !acquire_low())  break;
+
+        {  // own queue: first in, first out
+          auto &self = workers[_w];
+          std::lock_guard< spinlock > lk(self.lock);
+          auto &q = self.queues[p];
+          if (!q.empty())
+          {
+            auto t = q.front();
+            q.pop_front();
+            return t;
+          }
+        }
+        for (unsigned i = 1; i < nworkers; ++i)  // steal from the back of the others' queues
+        {
+          auto &victim = workers[(_w + i) % nworkers];
+          std::lock_guard< spinlock > lk(victim.lock);
+          auto &q = victim.queues[p];
+          if (!q.empty())
+          {
+            auto t = q.back();
+            q.pop_back();
+            stolen.fetch_add(1, std::memory_order_relaxed);
+            return t;
+          }
+        }
+
+        if (p == unsigned(priority::LOW))  low_running.fetch_sub(1, std::memory_order_relaxed);
+      }
+      return nullptr;
+    }
+
+    void execute(task &_t)
+    {
+      queued.fetch_sub(1, std::memory_order_relaxed);
+
+      _t.t_started = ::uv_hrtime();
+      _t.work_cb(&_t);
+      _t.t_finished = ::uv_hrtime();
+
+      auto &c = stat[unsigned(_t.prio)];
+      auto wait = _t.t_started - _t.t_queued;
+      c.completed.fetch_add(1, std::memory_order_relaxed);
+      c.wait_time.fetch_add(wait, std::memory_order_relaxed);
+      c.run_time.fetch_add(_t.t_finished - _t.t_started, std::memory_order_relaxed);
+      auto max_wait = c.max_wait_time.load(std::memory_order_relaxed);
+      while (max_wait < wait and !c.max_wait_time.compare_exchange_weak(max_wait, wait, std::memory_order_relaxed));
+
+      if (_t.prio == priority::LOW)  release_low();
+      complete(_t, 0);
+    }
+
+    static void complete(task &_t, int _status)
+    {
+      _t.status = _status;
+      auto ch = static_cast< channel* >(_t.chan);
+      std::lock_guard< spinlock > lk(ch->lock);  // the channel cannot be closed until the async event is sent
+      ch->completed.push_back(&_t);
+      ::uv_async_send(&ch->uv_async);
+    }
+
+    void worker_main(unsigned _w)
+    {
+      auto &self = workers[_w];
+      for (;;)
+      {
+        auto s = seq.load(std::memory_order_acquire);
+
+        if (shutdown.load(std::memory_order_relaxed) or _w >= target.load(std::memory_order_relaxed))
+        {
+          std::vector< task* > orphans[PRIORITIES];
+          {
+            std::lock_guard< spinlock > lk(self.lock);
+            if (!shutdown.load(std::memory_order_relaxed) and _w < target.load(std::memory_order_relaxed))  continue;
+            self.active = false;
+            for (unsigned p = 0; p < PRIORITIES; ++p)
+            {
+              orphans[p].assign(self.queues[p].begin(), self.queues[p].end());
+              self.queues[p].clear();
+            }
+          }
+          bool any = false;
+          {  // hand over the remaining tasks to the first worker, which never retires
+            std::lock_guard< spinlock > lk(workers[0].lock);
+            for (unsigned p = 0; p < PRIORITIES; ++p)
+            {
+              workers[0].queues[p].insert(workers[0].queues[p].end(), orphans[p].begin(), orphans[p].end());
+              any = any or !orphans[p].empty();
+            }
+          }
+          if (any)  wake_all();
+          return;
+        }
+
+        auto t = take(_w);
+        if (t)
+        {
+          execute(*t);
+          continue;
+        }
+
+        std::unique_lock< std::mutex > lk(idle_lock);
+        idle_cv.wait(lk, [this, s, _w](){
+            return seq.load(std::memory_order_acquire) != s or shutdown.load(std::memory_order_relaxed) or
+                   _w >= target.load(std::memory_order_relaxed);
+        });
+      }
+    }
+
+    static void async_cb(::uv_async_t *_uv_async)
+    {
+      auto ch = static_cast< channel* >(_uv_async->data);
+      auto pool = ch->pool;
+
+      ref_guard< instance > unref_pool(*pool);
+
+      {
+        std::lock_guard< spinlock > lk(ch->lock);
+        ch->batch.swap(ch->completed);
+      }
+      for (auto t : ch->batch)
+      {
+        --ch->outstanding;
+        t->chan = nullptr;
+        pool->pending.fetch_sub(1, std::memory_order_relaxed);
+        if (t->after_work_cb)  t->after_work_cb(t, t->status);
+        pool->unref();  // UNREF:COMPLETE -- the reference from submit()
+      }
+      ch->batch.clear();
+
+      if (ch->outstanding == 0)
+      {
+        {
+          std::lock_guard< std::mutex > lk(pool->channels_lock);
+          pool->channels.erase(_uv_async->loop);
+        }
+        ::uv_close(reinterpret_cast< ::uv_handle_t* >(_uv_async), [](::uv_handle_t *_h){ delete static_cast< channel* >(_h->data); });
+      }
+    }
+
+  public: /*interface*/
+    static instance* create(unsigned _threads, unsigned _max_threads)  { return new instance(_threads, _max_threads); }
+
+    void ref()  { refs.inc(); }
+    void unref()  { if (refs.dec() == 0)  destroy(); }
+
+    unsigned get_threads() const noexcept  { return target.load(std::memory_order_relaxed); }
+    unsigned get_max_threads() const noexcept  { return max_threads; }
+    unsigned get_reserved() const noexcept  { return reserved.load(std::memory_order_relaxed); }
+    void set_reserved(unsigned _n) noexcept
+    {
+      reserved.store(_n, std::memory_order_relaxed);
+      wake_all();
+    }
+    std::size_t get_queued() const noexcept  { return queued.load(std::memory_order_relaxed); }
+    std::size_t get_pending() const noexcept  { return pending.load(std::memory_order_relaxed); }
+    uint64_t get_stolen() const noexcept  { return stolen.load(std::memory_order_relaxed); }
+
+    statistics get_stats(priority _prio) const noexcept
+    {
+      auto &c = stat[unsigned(_prio)];
+      statistics ret;
+      ret.completed = c.completed.load(std::memory_order_relaxed);
+      ret.cancelled = c.cancelled.load(std::memory_order_relaxed);
+      ret.wait_time = c.wait_time.load(std::memory_order_relaxed);
+      ret.max_wait_time = c.max_wait_time.load(std::memory_order_relaxed);
+      ret.run_time = c.run_time.load(std::memory_order_relaxed);
+      return ret;
+    }
+
+    int set_threads(unsigned _n)
+    {
+      std::lock_guard< std::mutex > lk(control);
+
+      _n = lowest(greatest(1U, _n), max_threads);
+      target.store(_n, std::memory_order_relaxed);
+
+      for (unsigned i = 0; i < _n; ++i)
+      {
+        auto &w = workers[i];
+        {
+          std::lock_guard< spinlock > lk(w.lock);
+          if (w.active)  continue;
+          w.active = true;
+        }
+        if (w.thread.joinable())  w.thread.join();  // the retired thread has already handed its tasks over
+        try
+        {
+          w.thread = std::thread(&instance::worker_main, this, i);
+        }
+        catch (...)
+        {
+          {
+            std::lock_guard< spinlock > lk(w.lock);
+            w.active = false;
+          }
+          target.store(greatest(1U, i), std::memory_order_relaxed);
+          wake_all();
+          return uv_error = UV_EAGAIN;
+        }
+        if (spawned.load(std::memory_order_relaxed) <= i)  spawned.store(i+1, std::memory_order_release);
+      }
+
+      wake_all();  // let the extra threads retire
+      return uv_error = 0;
+    }
+
+    int submit(uv::loop::uv_t *_uv_loop, task &_t, priority _prio)
+    {
+      if (_t.chan)  return uv_error = UV_EBUSY;
+      if (!_t.work_cb)  return uv_error = UV_EINVAL;
+
+      auto uv_loop = _uv_loop;
+
+      channel *ch;
+      {
+        std::lock_guard< std::mutex > lk(channels_lock);
+        auto &slot = channels[uv_loop];
+        if (!slot)
+        {
+          ch = new channel;
+          ch->pool = this;
+          ch->uv_async.data = ch;
+          auto uv_ret = ::uv_async_init(uv_loop, &ch->uv_async, async_cb);
+          if (uv_ret < 0)
+          {
+            delete ch;
+            channels.erase(uv_loop);
+            return uv_error = uv_ret;
+          }
+          slot = ch;
+        }
+        ch = slot;
+      }
+
+      ref();  // REF:SUBMIT -- the executor should exist until the task is completed
+      ++ch->outstanding;
+
+      _t.chan = ch;
+      _t.prio = _prio;
+      _t.status = 0;
+      _t.t_started = _t.t_finished = 0;
+      _t.t_queued = ::uv_hrtime();
+
+      queued.fetch_add(1, std::memory_order_relaxed);
+      pending.fetch_add(1, std::memory_order_relaxed);
+      auto w = &workers[next_worker.fetch_add(1, std::memory_order_relaxed) % target.load(std::memory_order_relaxed)];
+      for (bool pushed = false; !pushed; w = &workers[0])
+      {
+        std::lock_guard< spinlock > lk(w->lock);
+        if (w->active)
+        {
+          w->queues[unsigned(_prio)].push_back(&_t);
+          pushed = true;
+        }
+      }
+      wake_one();
+
+      return uv_error = 0;
+    }
+
+    int cancel(task &_t)
+    {
+      if (!_t.chan)  return uv_error = UV_EINVAL;
+
+      const unsigned nworkers = spawned.load(std::memory_order_acquire);
+      for (unsigned i = 0; i < nworkers; ++i)
+      {
+        auto &w = workers[i];
+        bool found = false;
+        {
+          std::lock_guard< spinlock > lk(w.lock);
+          auto &q = w.queues[unsigned(_t.prio)];
+          for (auto it = q.begin(); it != q.end(); ++it)  if (*it == &_t)
+          {
+            q.erase(it);
+            found = true;
+            break;
+          }
+        }
+        if (found)
+        {
+          queued.fetch_sub(1, std::memory_order_relaxed);
+          stat[unsigned(_t.prio)].cancelled.fetch_add(1, std::memory_order_relaxed);
+          complete(_t, UV_ECANCELED);
+          return uv_error = 0;
+        }
+      }
+
+      return uv_error = UV_EBUSY;  // the task is already running or completed
+    }
+  };
+
+private: /*data*/
+  instance *instance_ptr;
+
+private: /*constructors*/
+  explicit executor(instance *_instance_ptr)
+  {
+    if (_instance_ptr)  _instance_ptr->ref();
+    instance_ptr = _instance_ptr;
+  }
+
+public: /*constructors*/
+  ~executor()  { if (instance_ptr)  instance_ptr->unref(); }
+
+  /*! \brief Create an executor with `_threads` worker threads.
+      \details The number of threads can be changed later but never exceeds `_max_threads`. */
+  explicit executor(unsigned _threads = 4, unsigned _max_threads = 128) : instance_ptr(instance::create(_threads, _max_threads))  {}
+
+  executor(const executor &_that) : executor(_that.instance_ptr)  {}
+  executor& operator =(const executor &_that)
+  {
+    if (this != &_that)
+    {
+      if (_that.instance_ptr)  _that.instance_ptr->ref();
+      auto t = instance_ptr;
+      instance_ptr = _that.instance_ptr;
+      if (t)  t->unref();
+    }
+    return *this;
+  }
+
+  executor(executor &&_that) noexcept : instance_ptr(_that.instance_ptr)  { _that.instance_ptr = nullptr; }
+  executor& operator =(executor &&_that) noexcept
+  {
+    if (this != &_that)
+    {
+      auto t = instance_ptr;
+      instance_ptr = _that.instance_ptr;
+      _that.instance_ptr = nullptr;
+      if (t)  t->unref();
+    }
+    return *this;
+  }
+
+public: /*interface*/
+  void swap(executor &_that) noexcept  { std::swap(instance_ptr, _that.instance_ptr); }
+  /*! \brief The current number of existing references to the same executor as this variable refers to. */
+  long nrefs() const noexcept  { return instance_ptr->refs.get_value(); }
+  /*! \brief The status value returned by the last executed operation. */
+  int uv_status() const noexcept  { return instance_ptr->uv_error; }
+
+  /*! \brief The current number of worker threads. */
+  unsigned threads() const noexcept  { return instance_ptr->get_threads(); }
+  /*! \brief Set the number of worker threads.
+      \details The value is limited to the range of 1...`max_threads()`. New threads are started immediately;
+      the extra threads retire as soon as they finish their current tasks, and their queued tasks are handed over
+      to the remaining ones. */
+  int threads(unsigned _n) const  { return instance_ptr->set_threads(_n); }
+  /*! \brief The maximum number of worker threads. */
+  unsigned max_threads() const noexcept  { return instance_ptr->get_max_threads(); }
+
+  /*! \brief The number of threads that never run `LOW` priority tasks.
+      \details Defaults to **1** if the executor has more than one thread. At least one `LOW` priority task
+      can always run regardless of this setting. */
+  unsigned reserved_threads() const noexcept  { return instance_ptr->get_reserved(); }
+  /*! \brief Set the number of threads that never run `LOW` priority tasks. */
+  void reserved_threads(unsigned _n) const noexcept  { instance_ptr->set_reserved(_n); }
+
+  /*! \brief The number of submitted tasks that have not been started yet. */
+  std::size_t queued() const noexcept  { return instance_ptr->get_queued(); }
+  /*! \brief The number of submitted tasks that have not been completed yet, i.e. whose completion callback
+      has not been called yet. */
+  std::size_t pending() const noexcept  { return instance_ptr->get_pending(); }
+  /*! \brief The number of tasks that have been stolen by the idle workers from the queues of the busy ones. */
+  uint64_t stolen() const noexcept  { return instance_ptr->get_stolen(); }
+  /*! \brief The accumulated statistics for the given priority level. */
+  statistics stats(priority _prio) const noexcept  { return instance_ptr->get_stats(_prio); }
+
+  /*! \brief Queue the task with the given priority.
+      \details The task completion callback will be called on the `_loop` thread.
+      Returns `UV_EBUSY` if the task has already been submitted and not completed yet. */
+  int submit(uv::loop &_loop, task &_task, priority _prio = priority::NORMAL) const
+  { return instance_ptr->submit(static_cast< uv::loop::uv_t* >(_loop), _task, _prio); }
+
+  /*! \brief Cancel the task if it has not been started yet.
+      \details The task completion callback is called with `UV_ECANCELED` status then. Returns `UV_EBUSY` if the task
+      is already running or completed but the completion callback has not been called yet. */
+  int cancel(task &_task) const  { return instance_ptr->cancel(_task); }
+
+public: /*conversion operators*/
+  explicit operator bool() const noexcept  { return (uv_status() >= 0); }  /*!< \brief Equivalent to `(uv_status() >= 0)`. */
+};
+
+
+
+/*! \ingroup doxy_group__executor
+    \brief Dedicated executors for the classes of requests that are otherwise run on the libuv thread pool.
+    \details By default, the filesystem requests (`uv::fs` subclasses), the name resolution requests (`uv::getaddrinfo`,
+    `uv::getnameinfo`), and the `uv::work` requests all share the single libuv thread pool, so a burst of CPU-heavy
+    work delays every file operation and DNS lookup queued after it. When an executor is assigned for a request
+    class, all the requests of this class that are run asynchronously are routed to that executor automatically:
+    the libuv function for the request is called _synchronously_ on one of the executor threads, and the request
+    callback is called on the loop thread afterwards as usual. The requests of the classes without an assigned
+    executor keep using the libuv thread pool.
+
+    The same executor can be assigned for several classes. The assignments are process-wide and can be changed
+    at any time; the requests that have already been started complete on the executor they have been started on.
+    \note The requests routed to an executor cannot be cancelled, `request::cancel()` returns `UV_EBUSY` for them. */
+class executors
+{
+public: /*types*/
+  /*! \brief The request classes. */
+  enum class pool : unsigned
+  {
+      FS,   /*!< filesystem requests */
+      DNS,  /*!< `getaddrinfo` and `getnameinfo` requests */
+      CPU   /*!< `uv::work` requests run without an explicitly specified executor */
+  };
+
+private: /*types*/
+  enum : unsigned  { POOLS = 3 };
+
+  struct registry
+  {
+    spinlock lock;
+    executor::instance *pools[POOLS] = { nullptr, };
+    ~registry()  { for (auto p : pools)  if (p)  p->unref(); }
+  };
+
+  //! \cond internals
+  template< class _Call_, class _Complete_ >
+  struct routed_task : executor::task
+  {
+    _Call_ call;
+    _Complete_ complete;
+    int result = 0;
+
+    template< class _C1_, class _C2_ >
+    routed_task(_C1_ &&_call, _C2_ &&_complete)
+      : executor::task(work_cb, after_work_cb), call(std::forward< _C1_ >(_call)), complete(std::forward< _C2_ >(_complete))
+    {}
+
+    static void work_cb(executor::task *_t)
+    {
+      auto self = static_cast< routed_task* >(_t);
+      self->result = self->call();
+    }
+    static void after_work_cb(executor::task *_t, int _status)
+    {
+      auto self = static_cast< routed_task* >(_t);
+      self->complete(_status < 0 ? _status : self->result);
+      delete self;
+    }
+  };
+  //! \endcond
+
+private: /*functions*/
+  static registry& get_registry()
+  {
+    static registry r;
+    return r;
+  }
+
+  static executor::instance* acquire(pool _pool)
+  {
+    auto &r = get_registry();
+    std::lock_guard< spinlock > lk(r.lock);
+    auto p = r.pools[unsigned(_pool)];
+    if (p)  p->ref();
+    return p;
+  }
+
+  /* the path arguments are copied into a single block the way libuv does for the asynchronous requests: the block
+     becomes uv_fs_t.path (and uv_fs_t.new_path points into it) and is freed by uv_fs_req_cleanup() */
+  static std::size_t routed_size(const char *_s) noexcept  { return _s ? std::strlen(_s) + 1 : 0; }
+  template< typename _T_ > static std::size_t routed_size(const _T_&) noexcept  { return 0; }
+
+  static const char* routed_arg(char *&_block, const char *_s) noexcept
+  {
+    if (!_s)  return nullptr;
+    auto ret = _block;
+    auto n = std::strlen(_s) + 1;
+    std::memcpy(_block, _s, n);
+    _block += n;
+    return ret;
+  }
+  template< typename _T_ > static std::decay_t< _T_ > routed_arg(char*&, const _T_ &_v)  { return _v; }
+
+  template< typename _Fn_, class _Tuple_, std::size_t... _I_ >
+  static int routed_fs_call(_Fn_ *_fn, uv::loop::uv_t *_uv_loop, ::uv_fs_t *_uv_req, const _Tuple_ &_args, std::index_sequence< _I_... >)
+  {
+    return _fn(_uv_loop, _uv_req, std::get< _I_ >(_args)..., nullptr);
+  }
+
+  static void replace(pool _pool, executor::instance *_p)
+  {
+    auto &r = get_registry();
+    if (_p)  _p->ref();
+    {
+      std::lock_guard< spinlock > lk(r.lock);
+      std::swap(r.pools[unsigned(_pool)], _p);
+    }
+    if (_p)  _p->unref();
+  }
+
+public: /*interface*/
+  /*! \brief Route the requests of the given class to the executor `_executor`. */
+  static void assign(pool _pool, const executor &_executor)  { replace(_pool, _executor.instance_ptr); }
+  /*! \brief Route the requests of the given class back to the libuv thread pool. */
+  static void reset(pool _pool)  { replace(_pool, nullptr); }
+
+  /*! \brief Create and assign separate executors for all the request classes with the given numbers of threads. */
+  static void isolate(unsigned _fs_threads = 4, unsigned _dns_threads = 2, unsigned _cpu_threads = 4)
+  {
+    assign(pool::FS, executor(_fs_threads));
+    assign(pool::DNS, executor(_dns_threads));
+    assign(pool::CPU, executor(_cpu_threads));
+  }
+
+  /*! \brief Check if the requests of the given class are routed to an executor. */
+  static bool is_assigned(pool _pool)
+  {
+    auto &r = get_registry();
+    std::lock_guard< spinlock > lk(r.lock);
+    return r.pools[unsigned(_pool)] != nullptr;
+  }
+
+  /*! \brief The number of worker threads of the executor assigned for the given class.
+      \details Returns **0** if there is no executor assigned for the class. \sa `executor::threads()` */
+  static unsigned threads(pool _pool)
+  {
+    auto p = acquire(_pool);
+    if (!p)  return 0;
+    ref_guard< executor::instance > unref_pool(*p, adopt_ref);
+    return p->get_threads();
+  }
+
+  /*! \brief The number of requests of the given class that are waiting in the executor queues.
+      \details Returns **0** if there is no executor assigned for the class. If the same executor is assigned for
+      several classes, the value is for all of them. \sa `executor::queued()` */
+  static std::size_t queued(pool _pool)
+  {
+    auto p = acquire(_pool);
+    if (!p)  return 0;
+    ref_guard< executor::instance > unref_pool(*p, adopt_ref);
+    return p->get_queued();
+  }
+  /*! \brief The number of requests of the given class that have been started and not completed yet.
+      \details Returns **0** if there is no executor assigned for the class. \sa `executor::pending()` */
+  static std::size_t pending(pool _pool)
+  {
+    auto p = acquire(_pool);
+    if (!p)  return 0;
+    ref_guard< executor::instance > unref_pool(*p, adopt_ref);
+    return p->get_pending();
+  }
+
+  /*! \brief Submit the task to the executor assigned for the given class.
+      \details Returns `UV_ENOSYS` if there is no executor assigned for the class. \sa `executor::submit()` */
+  static int submit(pool _pool, uv::loop::uv_t *_uv_loop, executor::task &_task, executor::priority _prio = executor::priority::NORMAL)
+  {
+    auto p = acquire(_pool);
+    if (!p)  return UV_ENOSYS;
+    ref_guard< executor::instance > unref_pool(*p, adopt_ref);
+    return p->submit(_uv_loop, _task, _prio);
+  }
+
+  /*! \brief Run the function `int _call()` on the executor assigned for the given class and then the function
+      `_complete(int _status)` on the `_uv_loop` thread.
+      \details `_status` is the value returned by `_call()`, or `UV_ECANCELED` if the task has been cancelled.
+      Returns `UV_ENOSYS` if there is no executor assigned for the class, and none of the functions is called then. */
+  template< class _Call_, class _Complete_ >
+  static int route(pool _pool, uv::loop::uv_t *_uv_loop, _Call_ &&_call, _Complete_ &&_complete)
+  {
+    using task_t = routed_task< std::decay_t< _Call_ >, std::decay_t< _Complete_ > >;
+
+    if (!is_assigned(_pool))  return UV_ENOSYS;
+
+    auto t = new task_t(std::forward< _Call_ >(_call), std::forward< _Complete_ >(_complete));
+    auto uv_ret = submit(_pool, _uv_loop, *t);
+    if (uv_ret < 0)  delete t;
+
+    return uv_ret;
+  }
+
+  //! \cond internals
+  /* run the libuv filesystem function `_fn` asynchronously with the `_cb` callback: on the io_uring ring of the loop
+     if there is one, on the libuv thread pool, or synchronously on the executor assigned for the filesystem requests */
+  template< typename _Fn_, typename... _Args_ >
+  static int queue_fs(_Fn_ *_fn, ::uv_fs_cb _cb, uv::loop::uv_t *_uv_loop, ::uv_fs_t *_uv_req, _Args_&&... _args)
+  {
+    request::unqueued(_uv_req);  // unless it is submitted to the libuv thread pool below
+
+    {
+      auto uv_ret = fs_ring::queue(_fn, _cb, _uv_loop, _uv_req, _args...);
+      if (uv_ret != UV_ENOSYS)  return uv_ret;
+    }
+
+    if (is_assigned(pool::FS))
+    {
+      std::size_t size = 0;
+      for (auto n : { std::size_t(0), routed_size(_args)... })  size += n;
+
+      char *paths = nullptr;
+      if (size)
+      {
+        paths = static_cast< char* >(std::malloc(size));
+        if (!paths)  return UV_ENOMEM;
+      }
+      auto block = paths;
+      std::tuple< decltype(routed_arg(block, _args))... > args{ routed_arg(block, _args)... };  // left to right
+
+      _uv_req->loop = _uv_loop;
+      auto uv_ret = route(pool::FS, _uv_loop,
+          [_fn, _uv_loop, _uv_req, args]()
+          { return routed_fs_call(_fn, _uv_loop, _uv_req, args, std::index_sequence_for< _Args_... >()); },
+          [_cb, _uv_req, paths](int _status)
+          {
+            // the synchronous libuv call has stored the paths as given and has reset the callback;
+            // unless it has not been made or has made its own copy (mkdtemp), hand the block over to the request
+            if (_uv_req->path != paths)  std::free(paths);
+            _uv_req->cb = _cb;
+            _uv_req->result = _status;
+            _cb(_uv_req);
+          }
+      );
+      if (uv_ret < 0)  std::free(paths);
+      if (uv_ret != UV_ENOSYS)  return uv_ret;  // otherwise the executor has just been reset
+    }
+
+    return _fn(_uv_loop, _uv_req, std::forward< _Args_ >(_args)..., _cb);
+  }
+
+  /* the loop passed to the libuv DNS functions called synchronously on executor threads:
+     they (un)register the request on the loop, which is not thread-safe */
+  static uv::loop::uv_t* dummy_loop() noexcept
+  {
+    thread_local ::uv_loop_t l;
+    return &l;
+  }
+  //! \endcond
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,299 @@
+
+#ifndef UVCC_FILE_TAILER__HPP
+#define UVCC_FILE_TAILER__HPP
+
+#include "uvcc/utility.hpp"
+#include "uvcc/loop.hpp"
+#include "uvcc/buffer.hpp"
+#include "uvcc/handle-io.hpp"
+#include "uvcc/handle-fs.hpp"
+#include "uvcc/request-fs.hpp"
+
+#include <cstddef>      // size_t
+#include <cstdint>      // int64_t uint64_t
+#include <fcntl.h>      // O_RDONLY
+#include <uv.h>
+
+#include <functional>   // function
+#include <memory>       // shared_ptr make_shared() enable_shared_from_this
+#include <string>       // string
+#include <utility>      // move()
+
+
+namespace uv
+{
+
+
+/*! \ingroup doxy_group__handle
+    \brief The follower of a growing file, such as a log file, delivering the data being appended to it.
+    \details The tailer watches the parent directory of the file with a `uv::fs_event` handle and, on the change events
+    concerning the file, reads the file from the last offset with positional `fs::read` requests up to its end. The data
+    is delivered through a callback of the `io::on_read_t` type, the same as `io::read_start()` does, with the current
+    `uv::file` handle as the `_handle` argument.
+
+    The change events coming while a check-and-read cycle is in progress are coalesced into a single repeated cycle
+    after the current one, so that a burst of events results in no more reads than needed to reach the end of the file.
+
+    Each cycle starts with `fs::stat` on the file path to detect:
+    - truncation: the file size is less than the current offset; reading restarts from the beginning of the file;
+    - rotation: the path refers to another file (inode) or does not exist anymore; the rest of the old file is read
+      to its end, then the new file, if any, is opened and read from the beginning. A file appearing later at
+      the path is picked up the same way.
+
+    Both are reported through the `on_reset()` callback before reading from the beginning of the file.
+
+    The tailer object is not copyable and not movable. Destroying it stops the tailer.
+    \note The tailer is not thread-safe and all its operations should be performed on the loop thread. */
+class file_tailer
+{
+public: /*types*/
+  /*! \brief The reasons of restarting the reading from the beginning of the file. */
+  enum class reset : int
+  {
+      TRUNCATED,  /*!< the file has been truncated */
+      ROTATED     /*!< the path now refers to a new file */
+  };
+
+  using on_reset_t = std::function< void(file _file, reset _reason) >;
+  /*!< \brief The function type of the callback called when the reading restarts from the beginning of the `_file`. */
+
+private: /*types*/
+  struct state : std::enable_shared_from_this< state >
+  {
+    uv::loop loop;
+    std::string path, name;  // the file path and its name within the watched directory
+    fs_event watch;
+    file current;
+    uint64_t dev = 0, ino = 0;  // the identity of the file being read
+    int64_t offset = 0, start_offset = -1;
+    std::size_t read_size = 65536;
+    bool running = false;
+    bool opened = false;  // a file has been opened at least once
+    bool busy = false;   // a check-and-read cycle is in progress
+    bool again = false;  // change events have come during the cycle
+    on_buffer_alloc_t alloc_cb;
+    io::on_read_t read_cb;
+    on_reset_t reset_cb;
+
+    state(uv::loop &_loop, std::string &&_path)
+      : loop(_loop), path(std::move(_path)), watch(_loop), current(_loop, -1)
+    {
+      auto slash = path.rfind('/');
+      name = slash == std::string::npos ? path : path.substr(slash + 1);
+      watch.path() = slash == std::string::npos ? std::string(".") : slash == 0 ? std::string("/") : path.substr(0, slash);
+    }
+
+    void notify()
+    {
+      if (!running)  return;
+      if (busy)
+        again = true;
+      else
+        cycle();
+    }
+
+    void cycle()
+    {
+      busy = true;
+      again = false;
+
+      fs::stat req;
+      req.on_request() = [self = shared_from_this()](fs::stat _req){ self->check(_req.uv_status(), _req.result()); };
+      if (req.run(loop, path.c_str(), true) < 0)  finish();
+    }
+
+    void finish()
+    {
+      busy = false;
+      if (running and again)  cycle();
+    }
+
+    void check(int _status, const ::uv_stat_t &_stat)
+    {
+      if (!running)  return finish();
+
+      auto self = shared_from_this();
+
+      if (current.fd() < 0)
+      {
+        if (_status < 0)  return finish();
+        return open(start_offset < 0 ? static_cast< int64_t >(_stat.st_size) : start_offset, opened);
+      }
+
+      if (_status < 0 or _stat.st_dev != dev or _stat.st_ino != ino)
+      {
+        // rotated: read the rest of the old file, then switch to the new one if it already exists
+        bool exists = _status >= 0;
+        return drain([self, exists]()
+        {
+          auto l = self->loop;
+          self->current = file(l, -1);
+          if (exists)
+            self->open(0, true);
+          else
+            self->finish();
+        });
+      }
+
+      if (static_cast< int64_t >(_stat.st_size) < offset)
+      {
+        offset = 0;
+        if (reset_cb)  reset_cb(current, reset::TRUNCATED);
+        if (!running)  return finish();
+      }
+
+      drain([self](){ self->finish(); });
+    }
+
+    void open(int64_t _offset, bool _rotated = false)
+    {
+      start_offset = 0;  // a file appearing at the path later is read from the beginning
+      file(loop, path.c_str(), O_RDONLY, 0, [self = shared_from_this(), _offset, _rotated](file _file)
+      {
+        if (!self->running)  return self->finish();
+        if (!_file)
+        {
+          if (_file.uv_status() != UV_ENOENT and self->read_cb)  self->read_cb(_file, _file.uv_status(), buffer(), _offset, nullptr);
+          return self->finish();
+        }
+
+        fs::stat st;
+        if (st.run(_file) < 0)  return self->finish();
+
+        self->current = _file;
+        self->opened = true;
+        self->dev = st.result().st_dev;
+        self->ino = st.result().st_ino;
+        self->offset = _offset;
+        if (_rotated and self->reset_cb)  self->reset_cb(_file, reset::ROTATED);
+        if (!self->running)  return self->finish();
+
+        self->again = true;  // the file may have been replaced or truncated since the stat of the path
+        self->drain([self](){ self->finish(); });
+      });
+    }
+
+    /* read the current file from the offset up to its end */
+    void drain(std::function< void() > &&_then)
+    {
+      if (!running)  return _then();
+
+      auto buf = alloc_cb(current, read_size);
+      if (!buf)
+      {
+        if (read_cb)  read_cb(current, UV_ENOBUFS, buffer(), offset, nullptr);
+        return _then();
+      }
+
+      fs::read req;
+      req.on_request() = [self = shared_from_this(), then = _then](fs::read _req, buffer _buf)
+      {
+        if (!self->running)  return then();
+
+        auto nread = _req.uv_status();
+        if (nread == 0)  return then();
+
+        if (nread > 0)  self->offset = _req.offset() + nread;
+        if (self->read_cb)  self->read_cb(self->current, nread, nread > 0 ? _buf : buffer(), _req.offset(), nullptr);
+
+        if (nread < 0)
+          then();
+        else
+          self->drain(std::function< void() >(then));
+      };
+      auto uv_ret = req.run(current, buf, offset);
+      if (uv_ret < 0)
+      {
+        if (read_cb)  read_cb(current, uv_ret, buffer(), offset, nullptr);
+        _then();
+      }
+    }
+  };
+
+private: /*data*/
+  std::shared_ptr< state > st;
+
+public: /*constructors*/
+  ~file_tailer()  { stop(); }
+
+  /*! \brief Create a tailer for the file specified by `_path`. */
+  file_tailer(uv::loop &_loop, std::string _path) : st(std::make_shared< state >(_loop, std::move(_path)))  {}
+
+  file_tailer(const file_tailer&) = delete;
+  file_tailer& operator =(const file_tailer&) = delete;
+
+  file_tailer(file_tailer&&) = delete;
+  file_tailer& operator =(file_tailer&&) = delete;
+
+public: /*interface*/
+  /*! \brief The path of the file being followed. */
+  const std::string& path() const noexcept  { return st->path; }
+
+  /*! \brief The file currently being read.
+      \details If the file has not been opened yet or has been removed, the returned handle is closed
+      (i.e. `uv::file::is_closing() == 1`). */
+  file handle() const noexcept  { return st->current; }
+
+  /*! \brief The offset the next read from the current file starts at. */
+  int64_t offset() const noexcept  { return st->offset; }
+
+  /*! \brief _Get_ the suggested size of the buffers requested from the allocation callback for the reads. */
+  std::size_t read_size() const noexcept  { return st->read_size; }
+  /*! \brief _Set_ the suggested size of the buffers requested from the allocation callback for the reads. */
+  void read_size(std::size_t _value) noexcept  { st->read_size = _value; }
+
+  /*! \brief Set the callback called when the reading restarts from the beginning of the file. */
+  on_reset_t& on_reset() const noexcept  { return st->reset_cb; }
+
+  /*! \brief Start following the file.
+      \details The reading starts from the `_offset` in the file, the value of < 0 meaning the end of the file, i.e.
+      only the data appended after this call is delivered. If the file does not exist yet it is read from
+      the beginning when it is created. When the tailer is restarted after `stop()` the reading resumes from
+      the current offset and the `_offset` argument is ignored.
+
+      Each chunk of data read is passed to the `_read_cb` callback with the buffer obtained from the `_alloc_cb`
+      callback. An error is passed to the `_read_cb` callback with a null-initialized buffer, and the following change
+      events of the file cause new attempts to read. The end of the file is not reported as `UV_EOF`, as it is
+      the normal state of the file being followed.
+      \returns The status value of starting the `uv::fs_event` handle watching the parent directory of the file. */
+  int start(const on_buffer_alloc_t &_alloc_cb, const io::on_read_t &_read_cb, int64_t _offset = -1)
+  {
+    auto &s = *st;
+    if (!_alloc_cb)  return UV_EINVAL;
+
+    s.alloc_cb = _alloc_cb;
+    s.read_cb = _read_cb;
+    s.start_offset = _offset;
+    s.running = true;
+
+    auto name = s.name;
+    s.watch.on_fs_event() = [wp = std::weak_ptr< state >(st), name](fs_event, const char *_filename, int)
+    {
+      auto self = wp.lock();
+      if (self and (!_filename or name == _filename))  self->notify();
+    };
+    auto uv_ret = s.watch.start();
+    if (uv_ret < 0)
+    {
+      s.running = false;
+      return uv_ret;
+    }
+
+    s.notify();
+    return 0;
+  }
+
+  /*! \brief Stop following the file. The current file is kept open, so that `start()` resumes the reading
+      from the current offset. */
+  int stop() noexcept
+  {
+    st->running = false;
+    return st->watch.stop();
+  }
+};
+
+
+}
+
+
+#endif
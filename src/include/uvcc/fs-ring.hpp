@@ -0,0 +1,593 @@
+
+#ifndef UVCC_FS_RING__HPP
+#define UVCC_FS_RING__HPP
+
+#include "uvcc/utility.hpp"
+#include "uvcc/loop.hpp"
+
+#include <cstddef>      // size_t
+#include <cstring>      // memset() strdup()
+#include <uv.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define UVCC_HAVE_IO_URING
+#endif
+#endif
+
+#ifdef UVCC_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>    // eventfd()
+#include <sys/mman.h>       // mmap() munmap()
+#include <sys/stat.h>       // statx
+#include <sys/syscall.h>    // __NR_io_uring_*
+#include <sys/sysmacros.h>  // makedev()
+#include <sys/uio.h>        // iovec
+#include <fcntl.h>          // AT_FDCWD AT_SYMLINK_NOFOLLOW AT_EMPTY_PATH
+#include <unistd.h>         // syscall() read() close()
+#include <cerrno>           // errno
+#endif
+
+#include <mutex>        // lock_guard
+#include <utility>      // pair
+#include <vector>       // vector
+
+
+namespace uv
+{
+
+
+/*! \ingroup doxy_group__executor
+    \brief The io_uring submission/completion ring for the filesystem requests of a loop.
+    \details While a ring object exists for a loop, the asynchronous `fs::read`, `fs::write`, `fs::sync`, and
+    `fs::stat` requests run on this loop as well as the `file::read_start()` reads are performed by the kernel
+    through the Linux io_uring interface instead of the libuv thread pool (or the executor assigned for the
+    `executors::pool::FS` request class), so that no thread context switches and no thread pool queue locking
+    take place for them. The requests are submitted in batches: all the operations started during a loop
+    iteration are passed to the kernel with a single system call just before the loop blocks for I/O. The
+    completions are signaled through an eventfd watched by the loop.
+
+    The ring is an opt-in facility with automatic fallback: the requests of the other types, the operations not
+    supported by the running kernel, and the ones that do not fit into the ring at the moment are run the usual
+    way. If io_uring is not available at all, the ring object is created in the failed state (see `uv_status()`)
+    and all the requests keep running the usual way.
+
+    When the ring object is destroyed, the requests are no longer routed to it, and its internal resources are
+    released after the operations that have already been started complete.
+    \note The ring object should be created and destroyed on the loop thread. There can be only one ring per loop.
+    The requests running on the ring cannot be cancelled, `request::cancel()` returns `UV_EBUSY` for them. */
+class fs_ring
+{
+  //! \cond
+  friend class executors;
+  //! \endcond
+
+private: /*types*/
+#ifdef UVCC_HAVE_IO_URING
+  struct op
+  {
+    ::uv_fs_t *uv_req;
+    ::uv_fs_cb cb;
+    bool stat;
+#ifdef STATX_BASIC_STATS
+    struct ::statx stx;
+#endif
+
+    op(::uv_fs_t *_uv_req, ::uv_fs_cb _cb, bool _stat = false) : uv_req(_uv_req), cb(_cb), stat(_stat)
+#ifdef STATX_BASIC_STATS
+      , stx()
+#endif
+    {}
+  };
+
+  struct core
+  {
+    uv::loop::uv_t *uv_loop;
+    int ring_fd = -1, event_fd = -1;
+    ::io_uring_params params;
+
+    void *sq_ptr = MAP_FAILED, *cq_ptr = MAP_FAILED;
+    std::size_t sq_size = 0, cq_size = 0;
+    ::io_uring_sqe *sqes = static_cast< ::io_uring_sqe* >(MAP_FAILED);
+    std::size_t sqes_size = 0;
+
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    ::io_uring_cqe *cqes;
+
+    unsigned sq_local_tail = 0;
+    unsigned to_submit = 0;
+    std::size_t inflight = 0;
+    int error = 0;  // the completion polling error, no more operations are submitted then
+    bool detached = false;
+    bool closing = false;
+    bool polling = false;
+    unsigned char supported[IORING_OP_LAST] = { 0, };
+
+    ::uv_poll_t uv_poll;
+    ::uv_prepare_t uv_prepare;
+    int handles = 0;
+
+    ~core()
+    {
+      if (sqes != MAP_FAILED)  ::munmap(sqes, sqes_size);
+      if (cq_ptr != MAP_FAILED and cq_ptr != sq_ptr)  ::munmap(cq_ptr, cq_size);
+      if (sq_ptr != MAP_FAILED)  ::munmap(sq_ptr, sq_size);
+      if (event_fd >= 0)  ::close(event_fd);
+      if (ring_fd >= 0)  ::close(ring_fd);
+    }
+  };
+#else
+  struct core;
+#endif
+
+  struct registry
+  {
+    spinlock lock;
+    std::vector< std::pair< uv::loop::uv_t*, core* > > rings;
+  };
+
+private: /*data*/
+  core *core_ptr = nullptr;
+  mutable int uv_error = 0;
+
+public: /*constructors*/
+  ~fs_ring()
+  {
+    if (!core_ptr)  return;
+    unregister(core_ptr);
+#ifdef UVCC_HAVE_IO_URING
+    core_ptr->detached = true;
+    if (core_ptr->inflight == 0)  close(core_ptr);
+#endif
+  }
+
+  /*! \brief Create a ring with `_entries` submission queue entries for the filesystem requests run on `_loop`. */
+  explicit fs_ring(uv::loop &_loop, unsigned _entries = 256)
+  {
+#ifdef UVCC_HAVE_IO_URING
+    auto uv_loop = static_cast< uv::loop::uv_t* >(_loop);
+    if (lookup(uv_loop))
+    {
+      uv_error = UV_EBUSY;
+      return;
+    }
+
+    auto c = new core;
+    c->uv_loop = uv_loop;
+    uv_error = setup(c, _entries);
+    if (uv_error < 0)
+    {
+      delete c;
+      return;
+    }
+
+    core_ptr = c;
+    auto &r = get_registry();
+    std::lock_guard< spinlock > lk(r.lock);
+    r.rings.emplace_back(uv_loop, c);
+#else
+    (void)_loop;
+    (void)_entries;
+    uv_error = UV_ENOSYS;
+#endif
+  }
+
+  fs_ring(const fs_ring&) = delete;
+  fs_ring& operator =(const fs_ring&) = delete;
+
+  fs_ring(fs_ring&&) = delete;
+  fs_ring& operator =(fs_ring&&) = delete;
+
+private: /*functions*/
+  static registry& get_registry()
+  {
+    static registry r;
+    return r;
+  }
+
+  static core* lookup(uv::loop::uv_t *_uv_loop)
+  {
+    auto &r = get_registry();
+    std::lock_guard< spinlock > lk(r.lock);
+    for (auto &e : r.rings)  if (e.first == _uv_loop)  return e.second;
+    return nullptr;
+  }
+
+  static void unregister(core *_c)
+  {
+    auto &r = get_registry();
+    std::lock_guard< spinlock > lk(r.lock);
+    for (auto it = r.rings.begin(); it != r.rings.end(); ++it)  if (it->second == _c)
+    {
+      r.rings.erase(it);
+      break;
+    }
+  }
+
+#ifdef UVCC_HAVE_IO_URING
+  static int setup(core *_c, unsigned _entries)
+  {
+    std::memset(&_c->params, 0, sizeof(_c->params));
+    _c->ring_fd = static_cast< int >(::syscall(__NR_io_uring_setup, _entries, &_c->params));
+    if (_c->ring_fd < 0)  return -errno;
+
+    auto &p = _c->params;
+    _c->sq_size = p.sq_off.array + p.sq_entries*sizeof(unsigned);
+    _c->cq_size = p.cq_off.cqes + p.cq_entries*sizeof(::io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP)  _c->sq_size = _c->cq_size = greatest(_c->sq_size, _c->cq_size);
+
+    _c->sq_ptr = ::mmap(nullptr, _c->sq_size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, _c->ring_fd, IORING_OFF_SQ_RING);
+    if (_c->sq_ptr == MAP_FAILED)  return -errno;
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+      _c->cq_ptr = _c->sq_ptr;
+    else
+    {
+      _c->cq_ptr = ::mmap(nullptr, _c->cq_size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, _c->ring_fd, IORING_OFF_CQ_RING);
+      if (_c->cq_ptr == MAP_FAILED)  return -errno;
+    }
+    _c->sqes_size = p.sq_entries*sizeof(::io_uring_sqe);
+    _c->sqes = static_cast< ::io_uring_sqe* >(::mmap(nullptr, _c->sqes_size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, _c->ring_fd, IORING_OFF_SQES));
+    if (_c->sqes == MAP_FAILED)  return -errno;
+
+    auto sq = static_cast< char* >(_c->sq_ptr), cq = static_cast< char* >(_c->cq_ptr);
+    _c->sq_head = reinterpret_cast< unsigned* >(sq + p.sq_off.head);
+    _c->sq_tail = reinterpret_cast< unsigned* >(sq + p.sq_off.tail);
+    _c->sq_mask = reinterpret_cast< unsigned* >(sq + p.sq_off.ring_mask);
+    _c->sq_array = reinterpret_cast< unsigned* >(sq + p.sq_off.array);
+    _c->cq_head = reinterpret_cast< unsigned* >(cq + p.cq_off.head);
+    _c->cq_tail = reinterpret_cast< unsigned* >(cq + p.cq_off.tail);
+    _c->cq_mask = reinterpret_cast< unsigned* >(cq + p.cq_off.ring_mask);
+    _c->cqes = reinterpret_cast< ::io_uring_cqe* >(cq + p.cq_off.cqes);
+    _c->sq_local_tail = *_c->sq_tail;
+
+    // the operations available since the very first io_uring version; the others are probed
+    _c->supported[IORING_OP_READV] = _c->supported[IORING_OP_WRITEV] = _c->supported[IORING_OP_FSYNC] = 1;
+    {
+      std::vector< char > buf(sizeof(::io_uring_probe) + 256*sizeof(::io_uring_probe_op), 0);
+      auto probe = reinterpret_cast< ::io_uring_probe* >(buf.data());
+      if (::syscall(__NR_io_uring_register, _c->ring_fd, IORING_REGISTER_PROBE, probe, 256) == 0)
+        for (unsigned i = 0; i < IORING_OP_LAST and i <= probe->last_op; ++i)
+          _c->supported[i] = (probe->ops[i].flags & IO_URING_OP_SUPPORTED) ? 1 : 0;
+    }
+
+    _c->event_fd = ::eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+    if (_c->event_fd < 0)  return -errno;
+    if (::syscall(__NR_io_uring_register, _c->ring_fd, IORING_REGISTER_EVENTFD, &_c->event_fd, 1) < 0)  return -errno;
+
+    auto uv_ret = ::uv_poll_init(_c->uv_loop, &_c->uv_poll, _c->event_fd);
+    if (uv_ret < 0)  return uv_ret;
+    _c->uv_poll.data = _c;
+    ++_c->handles;
+
+    ::uv_prepare_init(_c->uv_loop, &_c->uv_prepare);
+    _c->uv_prepare.data = _c;
+    ++_c->handles;
+    ::uv_prepare_start(&_c->uv_prepare, prepare_cb);
+    ::uv_unref(reinterpret_cast< ::uv_handle_t* >(&_c->uv_prepare));
+
+    return 0;
+  }
+
+  static void close(core *_c)
+  {
+    if (_c->closing)  return;
+    _c->closing = true;
+
+    if (_c->handles == 0)
+    {
+      delete _c;
+      return;
+    }
+    auto close_cb = [](::uv_handle_t *_h)
+    {
+      auto c = static_cast< core* >(_h->data);
+      if (--c->handles == 0)  delete c;
+    };
+    ::uv_close(reinterpret_cast< ::uv_handle_t* >(&_c->uv_poll), close_cb);
+    ::uv_close(reinterpret_cast< ::uv_handle_t* >(&_c->uv_prepare), close_cb);
+  }
+
+  /* pass the queued submission entries to the kernel */
+  static void flush(core *_c)
+  {
+    while (_c->to_submit)
+    {
+      auto ret = ::syscall(__NR_io_uring_enter, _c->ring_fd, _c->to_submit, 0, 0, nullptr, 0);
+      if (ret < 0)
+      {
+        if (errno == EINTR)  continue;
+        break;  // EAGAIN/EBUSY: retry on the next loop iteration
+      }
+      _c->to_submit -= static_cast< unsigned >(ret);
+      if (ret == 0)  break;
+    }
+  }
+
+  static ::io_uring_sqe* get_sqe(core *_c)
+  {
+    if (_c->error)  return nullptr;
+    if (_c->inflight >= _c->params.cq_entries)  return nullptr;  // don't let the completion queue overflow
+
+    if (_c->sq_local_tail - __atomic_load_n(_c->sq_head, __ATOMIC_ACQUIRE) >= _c->params.sq_entries)
+    {
+      flush(_c);
+      if (_c->sq_local_tail - __atomic_load_n(_c->sq_head, __ATOMIC_ACQUIRE) >= _c->params.sq_entries)  return nullptr;
+    }
+
+    auto idx = _c->sq_local_tail & *_c->sq_mask;
+    auto sqe = &_c->sqes[idx];
+    std::memset(sqe, 0, sizeof(*sqe));
+    _c->sq_array[idx] = idx;
+    return sqe;
+  }
+
+  /* initialize the request the way libuv does for an asynchronous one: the path is copied and owned by the request
+     until uv_fs_req_cleanup() */
+  static int init(core *_c, ::uv_fs_t *_uv_req, ::uv_fs_type _fs_type, ::uv_fs_cb _cb, const char *_path = nullptr)
+  {
+    _uv_req->type = UV_FS;
+    _uv_req->fs_type = _fs_type;
+    _uv_req->loop = _c->uv_loop;
+    _uv_req->result = 0;
+    _uv_req->ptr = nullptr;
+    _uv_req->path = nullptr;
+    _uv_req->new_path = nullptr;
+    _uv_req->bufs = nullptr;
+    _uv_req->cb = _cb;
+    if (_path)
+    {
+      _uv_req->path = ::strdup(_path);
+      if (!_uv_req->path)  return UV_ENOMEM;
+    }
+    return 0;
+  }
+
+  static int submit(core *_c, ::io_uring_sqe *_sqe, op *_op)
+  {
+    _sqe->user_data = reinterpret_cast< uint64_t >(_op);
+    __atomic_store_n(_c->sq_tail, ++_c->sq_local_tail, __ATOMIC_RELEASE);
+    ++_c->to_submit;
+
+    if (_c->inflight++ == 0 and !_c->polling)
+    {
+      ::uv_poll_start(&_c->uv_poll, UV_READABLE, poll_cb);
+      _c->polling = true;
+    }
+    return 0;
+  }
+
+  static void prepare_cb(::uv_prepare_t *_uv_prepare)  { flush(static_cast< core* >(_uv_prepare->data)); }
+
+  static void poll_cb(::uv_poll_t *_uv_poll, int _status, int)
+  {
+    auto c = static_cast< core* >(_uv_poll->data);
+
+    if (_status < 0)
+    {
+      // the completions can no longer be waited for with the loop: the new requests run the usual way,
+      // and the operations in flight are waited for right here, as the kernel still uses their buffers
+      c->error = _status;
+      for (reap(c); c->inflight; reap(c))
+      {
+        auto ret = ::syscall(__NR_io_uring_enter, c->ring_fd, c->to_submit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (ret >= 0)
+          c->to_submit -= static_cast< unsigned >(ret);
+        else if (errno != EINTR)
+          break;  // nothing else can be done
+      }
+    }
+    else
+    {
+      uint64_t n;
+      while (::read(c->event_fd, &n, sizeof(n)) < 0 and errno == EINTR);
+      reap(c);
+    }
+
+    if (c->inflight == 0 or c->error)
+    {
+      ::uv_poll_stop(&c->uv_poll);
+      c->polling = false;
+      if (c->detached and c->inflight == 0)  close(c);
+    }
+  }
+
+  /* complete the operations found in the completion queue */
+  static void reap(core *_c)
+  {
+    auto head = *_c->cq_head;
+    while (head != __atomic_load_n(_c->cq_tail, __ATOMIC_ACQUIRE))
+    {
+      auto cqe = _c->cqes[head & *_c->cq_mask];
+      __atomic_store_n(_c->cq_head, ++head, __ATOMIC_RELEASE);
+      --_c->inflight;
+      complete(reinterpret_cast< op* >(cqe.user_data), cqe.res);
+      head = *_c->cq_head;
+    }
+  }
+
+  static void complete(op *_op, int _res)
+  {
+    auto uv_req = _op->uv_req;
+    uv_req->result = _res;
+#ifdef STATX_BASIC_STATS
+    if (_op->stat)
+    {
+      if (_res == 0)
+      {
+        auto &s = _op->stx;
+        auto &st = uv_req->statbuf;
+        st.st_dev = makedev(s.stx_dev_major, s.stx_dev_minor);
+        st.st_mode = s.stx_mode;
+        st.st_nlink = s.stx_nlink;
+        st.st_uid = s.stx_uid;
+        st.st_gid = s.stx_gid;
+        st.st_rdev = makedev(s.stx_rdev_major, s.stx_rdev_minor);
+        st.st_ino = s.stx_ino;
+        st.st_size = s.stx_size;
+        st.st_blksize = s.stx_blksize;
+        st.st_blocks = s.stx_blocks;
+        st.st_flags = 0;
+        st.st_gen = 0;
+        st.st_atim.tv_sec = s.stx_atime.tv_sec;
+        st.st_atim.tv_nsec = s.stx_atime.tv_nsec;
+        st.st_mtim.tv_sec = s.stx_mtime.tv_sec;
+        st.st_mtim.tv_nsec = s.stx_mtime.tv_nsec;
+        st.st_ctim.tv_sec = s.stx_ctime.tv_sec;
+        st.st_ctim.tv_nsec = s.stx_ctime.tv_nsec;
+        st.st_birthtim.tv_sec = s.stx_btime.tv_sec;
+        st.st_birthtim.tv_nsec = s.stx_btime.tv_nsec;
+        uv_req->ptr = &uv_req->statbuf;
+      }
+    }
+#endif
+    auto cb = _op->cb;
+    struct op_guard { op *p; ~op_guard()  { delete p; } } guard{ _op };
+    cb(uv_req);
+  }
+#endif
+
+  /* the routing entry points for executors::queue_fs(): return UV_ENOSYS if the request should run the usual way */
+  template< typename _Fn_, typename... _Args_ >
+  static int queue(_Fn_*, ::uv_fs_cb, uv::loop::uv_t*, ::uv_fs_t*, const _Args_&...) noexcept  { return UV_ENOSYS; }
+
+  template< typename _Fd_, typename _Bufs_, typename _N_, typename _Off_ >
+  static int queue(decltype(&::uv_fs_read) _fn, ::uv_fs_cb _cb, uv::loop::uv_t *_uv_loop, ::uv_fs_t *_uv_req,
+      const _Fd_ &_fd, const _Bufs_ &_bufs, const _N_ &_nbufs, const _Off_ &_offset)
+  {
+#ifdef UVCC_HAVE_IO_URING
+    static_assert(sizeof(::uv_buf_t) == sizeof(::iovec), "uv_buf_t is expected to be layout-compatible with struct iovec");
+
+    auto opcode = _fn == ::uv_fs_read ? IORING_OP_READV : _fn == ::uv_fs_write ? IORING_OP_WRITEV : IORING_OP_LAST;
+    if (opcode == IORING_OP_LAST)  return UV_ENOSYS;
+
+    auto c = lookup(_uv_loop);
+    if (!c or !c->supported[opcode])  return UV_ENOSYS;
+#ifdef IORING_FEAT_RW_CUR_POS
+    if (static_cast< int64_t >(_offset) < 0 and !(c->params.features & IORING_FEAT_RW_CUR_POS))  return UV_ENOSYS;
+#else
+    if (static_cast< int64_t >(_offset) < 0)  return UV_ENOSYS;  // the current file position is not supported
+#endif
+
+    auto sqe = get_sqe(c);
+    if (!sqe)  return UV_ENOSYS;
+
+    init(c, _uv_req, opcode == IORING_OP_READV ? UV_FS_READ : UV_FS_WRITE, _cb);
+    sqe->opcode = opcode;
+    sqe->fd = static_cast< int >(_fd);
+    sqe->addr = reinterpret_cast< uint64_t >(static_cast< const ::uv_buf_t* >(_bufs));
+    sqe->len = static_cast< unsigned >(_nbufs);
+    sqe->off = static_cast< uint64_t >(static_cast< int64_t >(_offset));
+    return submit(c, sqe, new op(_uv_req, _cb));
+#else
+    return UV_ENOSYS;
+#endif
+  }
+
+  template< typename _Fd_ >
+  static int queue(decltype(&::uv_fs_fsync) _fn, ::uv_fs_cb _cb, uv::loop::uv_t *_uv_loop, ::uv_fs_t *_uv_req, const _Fd_ &_fd)
+  {
+#ifdef UVCC_HAVE_IO_URING
+    bool stat = _fn == ::uv_fs_fstat;
+    if (!stat and _fn != ::uv_fs_fsync and _fn != ::uv_fs_fdatasync)  return UV_ENOSYS;
+
+    auto c = lookup(_uv_loop);
+    if (!c)  return UV_ENOSYS;
+    if (stat)  return queue_stat(c, _cb, _uv_req, static_cast< int >(_fd), nullptr, AT_EMPTY_PATH);
+    if (!c->supported[IORING_OP_FSYNC])  return UV_ENOSYS;
+
+    auto sqe = get_sqe(c);
+    if (!sqe)  return UV_ENOSYS;
+
+    init(c, _uv_req, _fn == ::uv_fs_fdatasync ? UV_FS_FDATASYNC : UV_FS_FSYNC, _cb);
+    sqe->opcode = IORING_OP_FSYNC;
+    sqe->fd = static_cast< int >(_fd);
+    if (_fn == ::uv_fs_fdatasync)  sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+    return submit(c, sqe, new op(_uv_req, _cb));
+#else
+    return UV_ENOSYS;
+#endif
+  }
+
+  static int queue(decltype(&::uv_fs_stat) _fn, ::uv_fs_cb _cb, uv::loop::uv_t *_uv_loop, ::uv_fs_t *_uv_req, const char *_path)
+  {
+#ifdef UVCC_HAVE_IO_URING
+    if (!_path or (_fn != ::uv_fs_stat and _fn != ::uv_fs_lstat))  return UV_ENOSYS;
+
+    auto c = lookup(_uv_loop);
+    if (!c)  return UV_ENOSYS;
+    return queue_stat(c, _cb, _uv_req, AT_FDCWD, _path, _fn == ::uv_fs_lstat ? AT_SYMLINK_NOFOLLOW : 0);
+#else
+    return UV_ENOSYS;
+#endif
+  }
+
+#ifdef UVCC_HAVE_IO_URING
+  static int queue_stat(core *_c, ::uv_fs_cb _cb, ::uv_fs_t *_uv_req, int _dirfd, const char *_path, int _flags)
+  {
+#ifdef STATX_BASIC_STATS
+    if (!_c->supported[IORING_OP_STATX])  return UV_ENOSYS;
+
+    auto sqe = get_sqe(_c);
+    if (!sqe)  return UV_ENOSYS;
+
+    auto uv_ret = init(_c, _uv_req, !_path ? UV_FS_FSTAT : _flags & AT_SYMLINK_NOFOLLOW ? UV_FS_LSTAT : UV_FS_STAT, _cb, _path);
+    if (uv_ret < 0)  return uv_ret;  // the entry is not submitted and is reused by the next operation
+
+    auto o = new op(_uv_req, _cb, true);
+    sqe->opcode = IORING_OP_STATX;
+    sqe->fd = _dirfd;
+    sqe->addr = reinterpret_cast< uint64_t >(_path ? _uv_req->path : "");
+    sqe->len = STATX_BASIC_STATS|STATX_BTIME;
+    sqe->off = reinterpret_cast< uint64_t >(&o->stx);
+    sqe->statx_flags = static_cast< uint32_t >(_flags);
+    return submit(_c, sqe, o);
+#else
+    return UV_ENOSYS;
+#endif
+  }
+#endif
+
+public: /*interface*/
+  /*! \brief The status value returned by the ring creation, or the error of polling for the completions afterwards.
+      \details After a polling error the ring no longer takes the new requests, and they run the usual way. */
+  int uv_status() const noexcept
+  {
+#ifdef UVCC_HAVE_IO_URING
+    if (core_ptr and core_ptr->error)  return core_ptr->error;
+#endif
+    return uv_error;
+  }
+
+  /*! \brief The number of the operations that have been started on the ring and not completed yet. */
+  std::size_t pending() const noexcept
+  {
+#ifdef UVCC_HAVE_IO_URING
+    return core_ptr ? core_ptr->inflight : 0;
+#else
+    return 0;
+#endif
+  }
+
+  /*! \brief The number of the submission queue entries of the ring. */
+  unsigned entries() const noexcept
+  {
+#ifdef UVCC_HAVE_IO_URING
+    return core_ptr ? core_ptr->params.sq_entries : 0;
+#else
+    return 0;
+#endif
+  }
+
+  /*! \brief Check if the filesystem requests run on the loop are routed to a ring. */
+  static bool is_enabled(uv::loop &_loop)  { return lookup(static_cast< uv::loop::uv_t* >(_loop)) != nullptr; }
+
+public: /*conversion operators*/
+  explicit operator bool() const noexcept  { return (uv_status() >= 0); }  /*!< \brief Equivalent to `(uv_status() >= 0)`. */
+};
+
+
+}
+
+
+#endif
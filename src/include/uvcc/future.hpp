@@ -0,0 +1,650 @@
+
+#ifndef UVCC_FUTURE__HPP
+#define UVCC_FUTURE__HPP
+
+#include "uvcc/utility.hpp"
+#include "uvcc/loop.hpp"
+#include "uvcc/executor.hpp"
+
+#include <cstddef>      // size_t
+#include <uv.h>
+
+#include <exception>    // exception_ptr current_exception() rethrow_exception()
+#include <functional>   // function bind()
+#include <memory>       // make_shared()
+#include <stdexcept>    // logic_error runtime_error
+#include <tuple>        // tuple
+#include <type_traits>  // aligned_storage conditional_t decay_t enable_if_t is_void
+#include <utility>      // forward() move() swap()
+#include <vector>       // vector
+
+
+namespace uv
+{
+/*! \defgroup doxy_group__future  Futures
+    \brief Loop-native futures with continuation chaining.
+    \details The `uv::future` objects are intended to be completed and consumed on the loop thread only. Therefore,
+    unlike `std::future`/`std::shared_future`, they do not involve any mutex or condition variable, and there is
+    no blocking wait: the result is consumed with continuations attached with `future::then()` or `future::on_ready()`
+    which are called on the loop thread when the future is completed. */
+//! \{
+
+
+template< typename _T_ > class future;
+template< typename _T_ > class promise;
+template< typename _R_, class _Task_ > struct queued_work;
+
+
+//! \cond internals
+//! \addtogroup doxy_group__internals
+//! \{
+
+template< typename _R_ > struct future_unwrap  { using type = _R_; };
+template< typename _U_ > struct future_unwrap< future< _U_ > >  { using type = _U_; };
+
+//! \}
+//! \endcond
+
+
+/*! \brief The result type of the `when_any()` function. */
+template< typename _Sequence_ >
+struct when_any_result
+{
+  std::size_t index;  /*!< \brief The index of the first completed future in the `futures` sequence. */
+  _Sequence_ futures;
+};
+
+
+/*! \brief A future value that is completed on the loop thread.
+    \details The object is a reference counted handle to the shared state, it can be copied and passed to
+    continuations by value. The `void` specialization is supported.
+
+    Besides a value or an exception, a future carries a libuv status code (`uv_status()`), which is set
+    to a negative error value when the operation the future represents has failed on the libuv API level. */
+template< typename _T_ >
+class future
+{
+  //! \cond
+  template< typename > friend class future;
+  template< typename > friend class promise;
+  template< typename, class > friend struct queued_work;
+  //! \endcond
+
+public: /*types*/
+  using value_type = _T_;
+  using on_ready_t = std::function< void(future _future) >;
+  /*!< \brief The function type of the callback called when the future becomes ready. */
+
+private: /*types*/
+  struct empty  {};
+  using storage_type = std::conditional_t< std::is_void< _T_ >::value, empty, _T_ >;
+
+  class state
+  {
+  public: /*data*/
+    ref_count refs;
+    int uv_error = 0;
+    bool ready = false;
+    bool has_value = false;
+    std::exception_ptr exception;
+    std::vector< std::function< void() > > continuations;
+    typename std::aligned_storage< sizeof(storage_type), alignof(storage_type) >::type storage;
+
+  public: /*constructors*/
+    ~state()  { if (has_value)  value().~storage_type(); }
+    state() = default;
+
+    state(const state&) = delete;
+    state& operator =(const state&) = delete;
+
+    state(state&&) = delete;
+    state& operator =(state&&) = delete;
+
+  public: /*interface*/
+    void ref()  { refs.inc(); }
+    void unref()  { if (refs.dec() == 0)  delete this; }
+
+    storage_type& value() noexcept  { return *reinterpret_cast< storage_type* >(&storage); }
+
+    template< typename... _Args_ > void emplace(_Args_&&... _args)
+    {
+      if (has_value)  value().~storage_type();
+      has_value = false;
+      new(static_cast< void* >(&storage)) storage_type{ std::forward< _Args_ >(_args)... };
+      has_value = true;
+    }
+
+    void complete()
+    {
+      if (ready)  throw std::logic_error(__PRETTY_FUNCTION__);
+      ready = true;
+
+      ref_guard< state > unref_state(*this);  // the continuations are able to release the last external reference
+      auto ready_cb = std::move(continuations);
+      continuations.clear();
+      for (auto &cb : ready_cb)  cb();
+    }
+  };
+
+private: /*data*/
+  state *state_ptr;
+
+private: /*constructors*/
+  explicit future(state *_state_ptr)
+  {
+    if (_state_ptr)  _state_ptr->ref();
+    state_ptr = _state_ptr;
+  }
+
+public: /*constructors*/
+  ~future()  { if (state_ptr)  state_ptr->unref(); }
+
+  /*! \brief Create an empty future object that is not associated with any shared state. */
+  future() noexcept : state_ptr(nullptr)  {}
+
+  future(const future &_that) : future(_that.state_ptr)  {}
+  future& operator =(const future &_that)
+  {
+    if (this != &_that)
+    {
+      if (_that.state_ptr)  _that.state_ptr->ref();
+      auto t = state_ptr;
+      state_ptr = _that.state_ptr;
+      if (t)  t->unref();
+    }
+    return *this;
+  }
+
+  future(future &&_that) noexcept : state_ptr(_that.state_ptr)  { _that.state_ptr = nullptr; }
+  future& operator =(future &&_that) noexcept
+  {
+    if (this != &_that)
+    {
+      auto t = state_ptr;
+      state_ptr = _that.state_ptr;
+      _that.state_ptr = nullptr;
+      if (t)  t->unref();
+    }
+    return *this;
+  }
+
+private: /*functions*/
+  template< typename _R_, class _F_ >
+  static void fulfil(promise< _R_ > &_promise, _F_ &_f, future &_self, std::true_type/*is_void< _R_ >*/)
+  {
+    _f(_self);
+    _promise.set_value();
+  }
+  template< typename _R_, class _F_ >
+  static void fulfil(promise< _R_ > &_promise, _F_ &_f, future &_self, std::false_type/*is_void< _R_ >*/)
+  {
+    _promise.set_value(_f(_self));
+  }
+
+  template< typename _R_, class _F_ >
+  static void fulfil(promise< _R_ > &_promise, _F_ &_f, future &_self, const future< _R_ >*/*unwrap*/)
+  {
+    _f(_self).on_ready([_promise](future< _R_ > _inner) mutable { _promise.set_from(_inner); });
+  }
+  template< typename _R_, class _F_ >
+  static void fulfil(promise< _R_ > &_promise, _F_ &_f, future &_self, const void*/*no unwrap*/)
+  {
+    fulfil(_promise, _f, _self, std::is_void< _R_ >());
+  }
+
+public: /*interface*/
+  void swap(future &_that) noexcept  { std::swap(state_ptr, _that.state_ptr); }
+
+  /*! \brief Check if the future is associated with a shared state. */
+  bool valid() const noexcept  { return state_ptr != nullptr; }
+
+  /*! \brief Check if the future has been completed. */
+  bool is_ready() const noexcept  { return state_ptr and state_ptr->ready; }
+
+  /*! \brief The libuv status code the future has been completed with. */
+  int uv_status() const noexcept  { return state_ptr ? state_ptr->uv_error : UV_EINVAL; }
+
+  /*! \brief Check if the future has been completed with an exception. */
+  bool has_exception() const noexcept  { return state_ptr and state_ptr->exception; }
+
+  /*! \brief Get the value of the completed future.
+      \details Rethrows the exception the future has been completed with. If the future has been completed with a
+      libuv error code and holds no value, `std::runtime_error` is thrown.
+      \note It never blocks: if the future has not been completed yet, `std::logic_error` is thrown. */
+  template< typename _U_ = _T_ >
+  std::enable_if_t< !std::is_void< _U_ >::value, const _U_& > get() const
+  {
+    check_value();
+    return state_ptr->value();
+  }
+  /*! \brief Idem for the `void` specialization. */
+  template< typename _U_ = _T_ >
+  std::enable_if_t< std::is_void< _U_ >::value > get() const  { check_value(); }
+
+  /*! \brief Add a callback to be called on the loop thread when the future becomes ready.
+      \details If the future is already completed, the callback is called immediately. */
+  void on_ready(const on_ready_t &_ready_cb) const
+  {
+    if (!state_ptr)  throw std::logic_error(__PRETTY_FUNCTION__);
+
+    if (state_ptr->ready)
+      _ready_cb(*this);
+    else
+    {
+      auto s = state_ptr;
+      state_ptr->continuations.emplace_back([s, _ready_cb](){ _ready_cb(future(s)); });
+    }
+  }
+
+  /*! \brief Attach a continuation and return the future for its result.
+      \details The function object `_f` is called with this (completed) future as its argument. The returned
+      future is completed with the value returned from `_f`, or with the exception escaped from it.
+      If `_f` returns a `uv::future< _U_ >`, the result is unwrapped and `future< _U_ >` is returned, which is
+      completed when the returned inner future is completed. */
+  template< class _F_, typename _R_ = invoke_result_t< _F_&, future& > >
+  future< typename future_unwrap< _R_ >::type > then(_F_ &&_f) const
+  {
+    using result_type = typename future_unwrap< _R_ >::type;
+
+    promise< result_type > p;
+    auto ret = p.get_future();
+
+    on_ready(
+        [p, f = std::decay_t< _F_ >(std::forward< _F_ >(_f))](future _self) mutable
+        {
+          try
+          {
+            fulfil(p, f, _self, static_cast< const _R_* >(nullptr));
+          }
+          catch (...)
+          {
+            p.set_exception(std::current_exception());
+          }
+        }
+    );
+
+    return ret;
+  }
+
+private: /*functions*/
+  void check_value() const
+  {
+    if (!is_ready())  throw std::logic_error(__PRETTY_FUNCTION__);
+    if (state_ptr->exception)  std::rethrow_exception(state_ptr->exception);
+    if (!state_ptr->has_value)  throw std::runtime_error(::uv_strerror(state_ptr->uv_error));
+  }
+
+public: /*conversion operators*/
+  explicit operator bool() const noexcept  { return (uv_status() >= 0); }  /*!< \brief Equivalent to `(uv_status() >= 0)`. */
+};
+
+
+/*! \brief The completion side of a `uv::future`.
+    \details The object is a reference counted handle to the shared state, it can be copied and captured into
+    callbacks. All the `set_*()` functions complete the future and call its continuations synchronously, so they
+    should only be called on the loop thread. An attempt to complete the future twice results in `std::logic_error`. */
+template< typename _T_ >
+class promise
+{
+  //! \cond
+  template< typename > friend class future;
+  template< typename > friend class promise;
+  template< typename, class > friend struct queued_work;
+  //! \endcond
+
+private: /*types*/
+  using state = typename future< _T_ >::state;
+
+private: /*data*/
+  state *state_ptr;
+
+public: /*constructors*/
+  ~promise()  { if (state_ptr)  state_ptr->unref(); }
+
+  promise() : state_ptr(new state)  {}
+
+  promise(const promise &_that) : state_ptr(_that.state_ptr)  { if (state_ptr)  state_ptr->ref(); }
+  promise& operator =(const promise &_that)
+  {
+    if (this != &_that)
+    {
+      if (_that.state_ptr)  _that.state_ptr->ref();
+      auto t = state_ptr;
+      state_ptr = _that.state_ptr;
+      if (t)  t->unref();
+    }
+    return *this;
+  }
+
+  promise(promise &&_that) noexcept : state_ptr(_that.state_ptr)  { _that.state_ptr = nullptr; }
+  promise& operator =(promise &&_that) noexcept
+  {
+    if (this != &_that)
+    {
+      auto t = state_ptr;
+      state_ptr = _that.state_ptr;
+      _that.state_ptr = nullptr;
+      if (t)  t->unref();
+    }
+    return *this;
+  }
+
+private: /*functions*/
+  template< typename _U_ >
+  void set_from(const future< _U_ > &_that, std::true_type/*is_void< _U_ >*/)  { state_ptr->emplace(); }
+  template< typename _U_ >
+  void set_from(const future< _U_ > &_that, std::false_type/*is_void< _U_ >*/)  { state_ptr->emplace(_that.state_ptr->value()); }
+
+  /* complete with the result of another completed future */
+  template< typename _U_ >
+  void set_from(const future< _U_ > &_that)
+  {
+    state_ptr->uv_error = _that.state_ptr->uv_error;
+    state_ptr->exception = _that.state_ptr->exception;
+    if (_that.state_ptr->has_value)  set_from(_that, std::is_void< _U_ >());
+    state_ptr->complete();
+  }
+
+public: /*interface*/
+  void swap(promise &_that) noexcept  { std::swap(state_ptr, _that.state_ptr); }
+
+  /*! \brief Get the future associated with this promise. */
+  future< _T_ > get_future() const  { return future< _T_ >(state_ptr); }
+
+  /*! \brief Complete the future with the value constructed from the given arguments. */
+  template< typename... _Args_ >
+  void set_value(_Args_&&... _args)
+  {
+    state_ptr->emplace(std::forward< _Args_ >(_args)...);
+    state_ptr->complete();
+  }
+
+  /*! \brief Complete the future with the value constructed from the given arguments and the libuv status code. */
+  template< typename... _Args_ >
+  void set_value_status(int _uv_status, _Args_&&... _args)
+  {
+    state_ptr->uv_error = _uv_status;
+    set_value(std::forward< _Args_ >(_args)...);
+  }
+
+  /*! \brief Complete the future with a libuv error code and no value. */
+  void set_error(int _uv_error)
+  {
+    state_ptr->uv_error = _uv_error;
+    state_ptr->complete();
+  }
+
+  /*! \brief Complete the future with an exception. */
+  void set_exception(std::exception_ptr _exception)
+  {
+    state_ptr->exception = _exception;
+    state_ptr->complete();
+  }
+
+  /*! \brief Check if the future associated with this promise has been completed. */
+  bool is_ready() const noexcept  { return state_ptr->ready; }
+
+public: /*conversion operators*/
+  explicit operator bool() const noexcept  { return state_ptr != nullptr; }
+};
+
+
+
+/*! \brief Create a future that is already completed with the value constructed from the given arguments. */
+template< typename _T_, typename... _Args_ >
+future< _T_ > make_ready_future(_Args_&&... _args)
+{
+  promise< _T_ > p;
+  p.set_value(std::forward< _Args_ >(_args)...);
+  return p.get_future();
+}
+/*! \brief Create a `future< void >` that is already completed. */
+inline future< void > make_ready_future()  { return make_ready_future< void >(); }
+
+
+/*! \brief Create a future that is completed when all the futures from the given vector are completed.
+    \details The resulting future holds the vector of the (completed) source futures. */
+template< typename _T_ >
+future< std::vector< future< _T_ > > > when_all(std::vector< future< _T_ > > _futures)
+{
+  using result_type = std::vector< future< _T_ > >;
+
+  promise< result_type > p;
+  auto ret = p.get_future();
+
+  if (_futures.empty())
+  {
+    p.set_value(std::move(_futures));
+    return ret;
+  }
+
+  struct context
+  {
+    promise< result_type > p;
+    result_type futures;
+    std::size_t pending;
+  };
+  auto ctx = std::make_shared< context >();
+  ctx->p = p;
+  ctx->pending = _futures.size();
+  ctx->futures = std::move(_futures);
+
+  for (auto &f : ctx->futures)  f.on_ready([ctx](future< _T_ >){
+    if (--ctx->pending == 0)  ctx->p.set_value(std::move(ctx->futures));
+  });
+
+  return ret;
+}
+
+/*! \brief Create a future that is completed when all the given futures are completed.
+    \details The resulting future holds the tuple of the (completed) source futures. */
+template< typename... _Ts_ >
+future< std::tuple< future< _Ts_ >... > > when_all(future< _Ts_ >... _futures)
+{
+  using result_type = std::tuple< future< _Ts_ >... >;
+
+  promise< result_type > p;
+  auto ret = p.get_future();
+
+  if (sizeof...(_Ts_) == 0)
+  {
+    p.set_value();
+    return ret;
+  }
+
+  struct context
+  {
+    promise< result_type > p;
+    result_type futures;
+    std::size_t pending;
+  };
+  auto ctx = std::make_shared< context >(context{ p, result_type(_futures...), sizeof...(_Ts_) });
+
+  auto ready_cb = [ctx](auto&&){ if (--ctx->pending == 0)  ctx->p.set_value(std::move(ctx->futures)); };
+  using expander = int[];
+  (void)expander{ 0, (_futures.on_ready(ready_cb), 0)... };
+
+  return ret;
+}
+
+/*! \brief Create a future that is completed when any of the futures from the given vector is completed.
+    \details The resulting future holds the index of the first completed future and the vector of the source futures.
+    If the vector is empty, the resulting future is completed immediately with the index equal to zero. */
+template< typename _T_ >
+future< when_any_result< std::vector< future< _T_ > > > > when_any(std::vector< future< _T_ > > _futures)
+{
+  using result_type = when_any_result< std::vector< future< _T_ > > >;
+
+  promise< result_type > p;
+  auto ret = p.get_future();
+
+  if (_futures.empty())
+  {
+    p.set_value(result_type{ 0, std::move(_futures) });
+    return ret;
+  }
+
+  auto futures = std::make_shared< std::vector< future< _T_ > > >(std::move(_futures));
+  for (std::size_t i = 0; i < futures->size(); ++i)
+  {
+    if (p.is_ready())  break;
+    (*futures)[i].on_ready([p, futures, i](future< _T_ >) mutable {
+      if (!p.is_ready())  p.set_value(result_type{ i, *futures });
+    });
+  }
+
+  return ret;
+}
+
+/*! \brief Create a future that is completed when any of the given futures is completed.
+    \details The resulting future holds the index of the first completed future and the tuple of the source futures. */
+template< typename... _Ts_ >
+future< when_any_result< std::tuple< future< _Ts_ >... > > > when_any(future< _Ts_ >... _futures)
+{
+  using result_type = when_any_result< std::tuple< future< _Ts_ >... > >;
+
+  promise< result_type > p;
+  auto ret = p.get_future();
+
+  std::tuple< future< _Ts_ >... > futures(_futures...);
+  std::size_t i = 0;
+  using expander = int[];
+  (void)expander{ 0, (
+      _futures.on_ready([p, futures, idx = i++](auto&&) mutable {
+        if (!p.is_ready())  p.set_value(result_type{ idx, futures });
+      }), 0
+  )... };
+
+  return ret;
+}
+
+
+
+/*! \brief Run the request and get a future for its completion: `uv::make_future(request, run_arguments...)`.
+    \details The request callback (`on_request()`) is replaced with the one completing the future, and then
+    `_request.run()` is called with the given arguments. The future is completed with the request object as its value
+    and the `uv_status()` of the request as its status code. After completion, the request callback is reset to an
+    empty one. If `run()` fails, the future is completed with the error code immediately.
+    \note Keep in mind that some requests (`uv::fs` ones, `uv::getaddrinfo`, `uv::getnameinfo`) run synchronously
+    when their callback is empty, which is the case after the future completion. */
+template< class _Request_, typename... _Args_ >
+future< _Request_ > make_future(_Request_ &_request, _Args_&&... _args)
+{
+  promise< _Request_ > p;
+  auto ret = p.get_future();
+
+  _request.on_request() = [p](auto _req, auto&&...) mutable
+  {
+    auto q = std::move(p);  // the closure object is destroyed by the following assignment
+    _req.on_request() = nullptr;
+    q.set_value_status(_req.uv_status(), std::move(_req));
+  };
+
+  _request.run(std::forward< _Args_ >(_args)...);
+  if (_request.uv_status() < 0 and !ret.is_ready())
+  {
+    _request.on_request() = nullptr;
+    p.set_value_status(_request.uv_status(), _request);
+  }
+
+  return ret;
+}
+
+
+//! \cond internals
+//! \addtogroup doxy_group__internals
+//! \{
+template< typename _R_, class _Task_ >
+struct queued_work
+{
+  ::uv_work_t uv_work;
+  _Task_ task;
+  promise< _R_ > p;
+
+  static void run(_Task_ &_task, typename future< _R_ >::state &_state, std::true_type/*is_void< _R_ >*/)
+  {
+    _task();
+    _state.emplace();
+  }
+  static void run(_Task_ &_task, typename future< _R_ >::state &_state, std::false_type/*is_void< _R_ >*/)
+  {
+    _state.emplace(_task());
+  }
+
+  static void work_cb(::uv_work_t *_uv_work)
+  {
+    auto self = static_cast< queued_work* >(_uv_work->data);
+    auto &state = *self->p.state_ptr;
+    try
+    {
+      run(self->task, state, std::is_void< _R_ >());
+    }
+    catch (...)
+    {
+      state.exception = std::current_exception();
+    }
+  }
+
+  static void after_work_cb(::uv_work_t *_uv_work, int _status)
+  {
+    auto self = static_cast< queued_work* >(_uv_work->data);
+    auto p = std::move(self->p);
+    delete self;
+
+    if (_status < 0)
+      p.set_error(_status);
+    else
+      p.state_ptr->complete();
+  }
+};
+//! \}
+//! \endcond
+
+/*! \brief Queue the `_task` to the thread pool and get a future for its result.
+    \details The given `_task` function is called with specified `_args` applied and is executed on the one of the
+    threads from the thread pool. The returned future is completed on the `_loop` thread with the value returned from
+    the task or the exception escaped from it. If the work has been cancelled or could not be queued the future is
+    completed with the corresponding libuv error code.
+
+    Unlike `uv::work< _Result_ >` request, it neither employs `std::packaged_task` nor `std::shared_future`:
+    the task object and the future state are the only two allocations, and the result is passed from the
+    thread pool to the loop thread under the libuv's own work queue synchronization.
+
+    If an executor is assigned for the `executors::pool::CPU` request class, the task is routed to that executor
+    instead of the libuv thread pool (see `uv::executors`).
+    \note All arguments are copied (or moved) to the task function object. For passing arguments by reference
+    wrap them with `std::ref()` or use raw pointers.
+    \sa libuv API documentation: [`uv_queue_work()`](http://docs.libuv.org/en/v1.x/threadpool.html#c.uv_queue_work). */
+template< class _Task_, typename... _Args_,
+    typename _R_ = invoke_result_t< std::decay_t< _Task_ >&, std::decay_t< _Args_ >&... >
+>
+future< _R_ > queue_work(uv::loop &_loop, _Task_ &&_task, _Args_&&... _args)
+{
+  auto bound = std::bind(std::forward< _Task_ >(_task), std::forward< _Args_ >(_args)...);
+  using work_type = queued_work< _R_, decltype(bound) >;
+
+  auto w = new work_type{ ::uv_work_t(), std::move(bound), promise< _R_ >() };
+  w->uv_work.data = w;
+  auto ret = w->p.get_future();
+
+  auto uv_ret = executors::route(executors::pool::CPU, static_cast< uv::loop::uv_t* >(_loop),
+      [w](){ work_type::work_cb(&w->uv_work); return 0; },
+      [w](int _status){ work_type::after_work_cb(&w->uv_work, _status); }
+  );
+  if (uv_ret == UV_ENOSYS)  uv_ret = ::uv_queue_work(static_cast< uv::loop::uv_t* >(_loop), &w->uv_work, work_type::work_cb, work_type::after_work_cb);
+  if (uv_ret < 0)
+  {
+    auto p = std::move(w->p);
+    delete w;
+    p.set_error(uv_ret);
+  }
+
+  return ret;
+}
+
+
+//! \}
+}
+
+
+#endif
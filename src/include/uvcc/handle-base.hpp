@@ -50,7 +50,7 @@ protected: /*types*/
   //! \{
 
   struct properties  {};
-  constexpr static const std::size_t MAX_PROPERTY_SIZE = 136 + sizeof(::uv_buf_t) + sizeof(::uv_fs_t);
+  constexpr static const std::size_t MAX_PROPERTY_SIZE = 152 + sizeof(::uv_buf_t) + sizeof(::uv_fs_t);
   constexpr static const std::size_t MAX_PROPERTY_ALIGN = 8;
 
   struct uv_interface
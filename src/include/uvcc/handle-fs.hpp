@@ -6,6 +6,7 @@
 #include "uvcc/handle-base.hpp"
 #include "uvcc/handle-io.hpp"
 #include "uvcc/loop.hpp"
+#include "uvcc/executor.hpp"
 
 #include <uv.h>
 
@@ -15,9 +16,12 @@
 #include <unistd.h>     // lseek64()
 #endif
 
+#include <cstdint>      // int64_t uint64_t
+#include <deque>        // deque
 #include <functional>   // function
 #include <string>       // string
 #include <utility>      // move()
+#include <vector>       // vector
 
 
 namespace uv
@@ -44,6 +48,41 @@ protected: /*types*/
   //! \addtogroup doxy_group__internals
   //! \{
 
+  struct write_queue
+  {
+    ::uv_fs_t uv_req_struct = { 0,};
+    bool enabled = true;
+    bool busy = false;
+    bool has_tail = false;
+    int64_t tail = 0;  // the end offset of the last write having been queued
+    uint64_t queued = 0, completed = 0;  // the numbers of the requests having been queued and completed so far
+    std::deque< ::uv_fs_t* > pending;
+    std::vector< ::uv_fs_t* > batch;
+    std::vector< ::uv_buf_t > bufs;
+  };
+
+  struct sync_group
+  {
+    ::uv_fs_t uv_req_struct = { 0,};
+    bool enabled = true;
+    bool busy = false;     // a round has been started and is not completed yet
+    bool waiting = false;  // the round waits for the coalesced writes queued before it to be completed
+    uint64_t window = 0;   // the commit window, in milliseconds
+    uint64_t barrier = 0;  // the number of the coalesced writes to be completed before the round can sync the file
+    std::vector< ::uv_fs_t* > pending;  // the requests to be completed by the next round
+    std::vector< ::uv_fs_t* > round;    // the requests to be completed by the current round
+    void (*resume)(::uv_fs_t*) = nullptr;
+    ::uv_timer_t *uv_timer = nullptr;  // the commit window timer, created on demand
+
+    ~sync_group()
+    {
+      if (uv_timer)  ::uv_close(reinterpret_cast< ::uv_handle_t* >(uv_timer), [](::uv_handle_t *_uv_handle)
+      {
+        delete reinterpret_cast< ::uv_timer_t* >(_uv_handle);
+      });
+    }
+  };
+
   struct properties : io::properties
   {
     on_open_t open_cb;
@@ -54,6 +93,10 @@ protected: /*types*/
     } rd;
     std::size_t write_queue_size = 0;
     int is_closing = 0;
+    write_queue *wq = nullptr;
+    sync_group *sg = nullptr;
+
+    ~properties()  { delete wq; delete sg; }
   };
 
   struct uv_interface : handle::uv_fs_interface, io::uv_interface
@@ -155,10 +198,9 @@ public: /*constructors*/
     instance_ptr->properties().open_cb = _open_cb;
 
     uv_status(0);
-    auto uv_ret = ::uv_fs_open(
+    auto uv_ret = executors::queue_fs(::uv_fs_open, open_cb,
         static_cast< uv::loop::uv_t* >(_loop), static_cast< uv_t* >(uv_handle),
-        _path, _flags, _mode,
-        open_cb
+        _path, _flags, _mode
     );
     if (uv_ret >= 0)
       instance_ptr->book_loop();
@@ -182,12 +224,11 @@ private: /*functions*/
 
     io_alloc_cb(&_instance_ptr->uv_handle_struct, 65536, &properties.rd.uv_buf_struct);
 
-    return ::uv_fs_read(
+    return executors::queue_fs(::uv_fs_read, read_cb,
       _instance_ptr->uv_handle_struct.loop, &properties.rd.uv_req_struct,
       _instance_ptr->uv_handle_struct.result,
       &properties.rd.uv_buf_struct, 1,
-      properties.rdoffset,
-      read_cb
+      properties.rdoffset
     );
   }
 
@@ -195,6 +236,69 @@ public: /*interface*/
   /*! \brief The amount of bytes waiting to be written to the file. */
   std::size_t write_queue_size() const noexcept  { return instance::from(uv_handle)->properties().write_queue_size; }
 
+  /*! \brief Check if the asynchronous writes to the file are coalesced. */
+  bool coalesce_writes() const noexcept
+  {
+    auto wq = instance::from(uv_handle)->properties().wq;
+    return wq and wq->enabled;
+  }
+  /*! \brief Enable or disable coalescing of the asynchronous writes to the file.
+      \details When enabled, the asynchronous `fs::write` requests run on the file are queued and performed one batch at
+      a time: while a batch is being written, the subsequent requests are accumulated, and those of them that follow each
+      other at contiguous offsets are merged into a single vectored write (`pwritev()`). Each of the original requests is
+      still completed individually, in the order they have been run. So that many small writes at adjacent offsets cost
+      a single thread pool round trip, and the writes to the file are never reordered.
+
+      The `_offset` value of < 0 passed to `fs::write::run()` means in this mode the offset right after the end of the last
+      write queued on the file (or the current file position if there has been no such write yet), which makes
+      the sequential appending writes work as expected. */
+  void coalesce_writes(bool _enable)
+  {
+    auto &properties = instance::from(uv_handle)->properties();
+    if (!properties.wq)
+    {
+      if (!_enable)  return;
+      properties.wq = new write_queue;
+    }
+    properties.wq->enabled = _enable;
+  }
+
+  /*! \brief Check if the group commit of the asynchronous sync requests run on the file is enabled. */
+  bool group_commit() const noexcept
+  {
+    auto sg = instance::from(uv_handle)->properties().sg;
+    return sg and sg->enabled;
+  }
+  /*! \brief Enable or disable the group commit of the asynchronous `fs::sync` requests run on the file.
+      \details When enabled, the pending sync requests are coalesced: a single `fdatasync()` (or `fsync()`, if any of them
+      has asked to flush all metadata) completes all of the requests that have been run before it started. The requests
+      run while the sync is in progress are accumulated and completed by the next one. So that the number of the syncs
+      issued is bounded by the storage device latency rather than by the number of the durable writers.
+
+      `_commit_window` is the time in milliseconds the first request of a round waits for others to join before
+      the file is synced. The value of **0** means no extra delay.
+
+      If `coalesce_writes()` is also enabled, a round does not start syncing until all the writes having been queued
+      on the file before it are completed, so a sync request run right after a write request makes the written data
+      durable. Otherwise the sync covers only the writes completed by the time it starts. */
+  void group_commit(bool _enable, uint64_t _commit_window = 0)
+  {
+    auto &properties = instance::from(uv_handle)->properties();
+    if (!properties.sg)
+    {
+      if (!_enable)  return;
+      properties.sg = new sync_group;
+    }
+    properties.sg->enabled = _enable;
+    properties.sg->window = _commit_window;
+  }
+  /*! \brief The commit window of the group commit in milliseconds. */
+  uint64_t commit_window() const noexcept
+  {
+    auto sg = instance::from(uv_handle)->properties().sg;
+    return sg ? sg->window : 0;
+  }
+
   /*! \brief Get the cross platform representation of the file handle.
       \details On Windows this function returns _a C run-time file descriptor_ which differs from the
       _operating-system file handle_ that is returned by `handle::fileno()` function.
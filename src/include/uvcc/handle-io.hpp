@@ -29,6 +29,9 @@ class io : public handle
   friend class output;
   friend class fs;
   friend class process;
+  friend class timer_wheel;
+  friend class udp;
+  friend class udp_send;
   //! \endcond
 
 public: /*types*/
@@ -125,10 +128,14 @@ protected: /*functions*/
 
     auto &read_cb = properties.read_cb;
     if (_uv_buf->base)
+    {
+      auto buf_instance_ptr = buffer::instance::from(buffer::instance::uv_buf::from(_uv_buf->base));
+      if (buf_instance_ptr->slab)  buf_instance_ptr->uv_buf_struct.len = _nread > 0 ? _nread : 0;  // return the unused space to the slab
       read_cb(io(_uv_handle), _nread, buffer(buffer::instance::uv_buf::from(_uv_buf->base), adopt_ref), properties.rdoffset, _info);
       // don't forget to specify adopt_ref flag when using ref_guard to unref the object
       // don't use ref_guard unless it really needs to hold on the object until the scope end
       // use move/transfer semantics instead if you need just pass the object to another function for further processing
+    }
     else
       read_cb(io(_uv_handle), _nread, buffer(), properties.rdoffset, _info);
 
@@ -6,11 +6,31 @@
 #include "uvcc/handle-base.hpp"
 #include "uvcc/handle-io.hpp"
 #include "uvcc/loop.hpp"
+#include "uvcc/netstruct.hpp"
 
 #include <cstddef>      // size_t
 #include <uv.h>
 
+#include <cerrno>       // errno EAGAIN EWOULDBLOCK EINTR
+#include <deque>        // deque
+#include <functional>   // function
 #include <type_traits>  // enable_if_t
+#include <vector>       // vector
+
+#ifdef __linux__
+#include <sys/socket.h> // recvmmsg() mmsghdr setsockopt() getsockopt() CMSG_* MSG_DONTWAIT MSG_TRUNC
+#include <sys/uio.h>    // iovec
+#include <netinet/in.h> // IPPROTO_UDP
+#include <unistd.h>     // dup() close()
+#include <cstring>      // memcpy()
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#endif
 
 
 namespace uv
@@ -26,6 +46,7 @@ class udp : public io
   friend class handle::uv_interface;
   friend class handle::instance< udp >;
   friend class udp_send;
+  friend class udp_send_batch;
   //! \endcond
 
 public: /*types*/
@@ -44,6 +65,40 @@ public: /*types*/
         \sa libuv API documentation: [`uv_udp_recv_cb`](http://docs.libuv.org/en/v1.x/udp.html#c.uv_udp_recv_cb),
                                      [`uv_udp_flags`](http://docs.libuv.org/en/v1.x/udp.html#c.uv_udp_flags). */
     unsigned int flags;
+    /*! \brief The size of the segments the payload consists of, if it has been coalesced from several datagrams
+        by the UDP generic receive offload (see `set_gro()`); otherwise **0**.
+        \note Only provided by `recv_batch_start()`. */
+    std::size_t segment_size;
+  };
+
+  /*! \brief A datagram received by `recv_batch_start()`. */
+  struct datagram
+  {
+    /*! \brief The slice of the batch buffer holding the datagram payload. */
+    ::uv_buf_t data;
+    /*! \brief The peer address and the message flags. `UV_UDP_PARTIAL` flag is set if the datagram has been truncated
+        to the slice size. */
+    io_info info;
+  };
+
+  using on_recv_batch_t = std::function< void(udp _handle, buffer _buffer, const std::vector< datagram > &_batch) >;
+  /*!< \brief The function type of the callback called by `recv_batch_start()` when a batch of datagrams has been received.
+       \details The `_batch` datagram payloads are the slices of the `_buffer` memory. The buffer can be retained
+       by the callback, in which case a new one is allocated for the next batch; otherwise the same memory is reused.
+       The `_batch` vector and the peer addresses are valid for the duration of the callback only.
+
+       On error the callback is called with an empty `_batch` and the error code can be checked with `uv_status()`. */
+
+  /*! \brief The policies of handling the datagrams sent over the egress limits.
+      \sa `udp::set_egress_limits()` */
+  enum class egress_policy
+  {
+    DROP_NEWEST,   /*!< \brief Refuse the new datagram: `udp_send::run()` fails with `UV_ENOBUFS`. */
+    DROP_OLDEST,   /*!< \brief Drop the oldest datagram that has not yet been passed to the socket:
+                        its request completes with `UV_ECANCELED` (the callback is called from within
+                        `udp_send::run()` for the new datagram). */
+    PAUSE_RECEIVE  /*!< \brief Accept the datagram, but pause reading from the linked receive side
+                        until the queue is drained below the half of the limits. */
   };
 
 protected: /*types*/
@@ -51,7 +106,32 @@ protected: /*types*/
   //! \addtogroup doxy_group__internals
   //! \{
 
-  struct properties : io::properties  {};
+  struct batch_receiver;
+
+  struct egress_control
+  {
+    std::size_t max_bytes = 0;
+    std::size_t max_count = 0;
+    egress_policy policy = egress_policy::DROP_NEWEST;
+    io::uv_t *receiver = nullptr;
+    bool paused = false;
+    std::deque< std::pair< ::uv_udp_send_t*, bool > > staged;  // the requests held back from libuv, with the connected flag
+    std::size_t staged_bytes = 0;
+    std::size_t dropped_count = 0;
+    std::size_t dropped_bytes = 0;
+
+    constexpr static const std::size_t WINDOW = 16;  // the number of datagrams passed to libuv in DROP_OLDEST mode
+  };
+
+  struct properties : io::properties
+  {
+    batch_receiver *batch_rx = nullptr;
+    egress_control *egress = nullptr;
+    bool connected = false;
+    ::sockaddr_storage peer = { 0,};
+
+    ~properties()  { delete egress; }
+  };
 
   struct uv_interface : handle::uv_handle_interface, io::uv_interface
   {
@@ -74,6 +154,29 @@ protected: /*types*/
 private: /*types*/
   using instance = handle::instance< udp >;
 
+protected: /*types*/
+  //! \cond internals
+  //! \addtogroup doxy_group__internals
+  //! \{
+  struct batch_receiver
+  {
+    ::uv_poll_t uv_poll;
+    int fd = -1;
+    uv_t *uv_handle = nullptr;
+    on_recv_batch_t recv_cb;
+    std::size_t datagram_size = 0;
+    buffer buf;
+    std::vector< datagram > batch;
+#ifdef __linux__
+    std::vector< ::mmsghdr > msgs;
+    std::vector< ::iovec > iovs;
+    std::vector< ::sockaddr_storage > peers;
+    std::vector< char > control;
+#endif
+  };
+  //! \}
+  //! \endcond
+
 protected: /*constructors*/
   //! \cond
   explicit udp(uv_t *_uv_handle) : io(static_cast< io::uv_t* >(_uv_handle))  {}
@@ -119,6 +222,19 @@ public: /*constructors*/
 private: /*functions*/
   template< typename = void > static void alloc_cb(::uv_handle_t*, std::size_t, ::uv_buf_t*);
   template< typename = void > static void recv_cb(::uv_udp_t*, ssize_t, const ::uv_buf_t*, const ::sockaddr*, unsigned int);
+  template< typename = void > static void batch_poll_cb(::uv_poll_t*, int, int);
+
+  static void batch_receiver_close(batch_receiver *_rx)
+  {
+    ::uv_close(reinterpret_cast< ::uv_handle_t* >(&_rx->uv_poll), [](::uv_handle_t *_h)
+    {
+      auto rx = static_cast< batch_receiver* >(_h->data);
+#ifdef __linux__
+      ::close(rx->fd);
+#endif
+      delete rx;
+    });
+  }
 
 public: /*interface*/
   /*! \brief Get the platform dependent socket descriptor. The alias for `handle::fileno()`. */
@@ -185,6 +301,228 @@ public: /*interface*/
         sizeof(_T_) >= z;
   }
 
+  /*! \name UDP segmentation offload features (Linux only, `UV_ENOSYS` is returned on other platforms): */
+  //! \{
+  /*! \brief Set the UDP generic segmentation offload (GSO) segment size for all the datagrams sent through the socket.
+      \details With a non-zero `_size`, a payload larger than `_size` bytes passed to a single send operation (e.g.
+      `udp_send::run()`) is split by the kernel (or the NIC) into the datagrams of `_size` bytes each (the last one can
+      be shorter), so that up to 64 KiB of data is sent with one system call. **0** disables the segmentation.
+      \sa `udp_send_batch::add()` for setting the segment size per datagram. */
+  int set_gso_segment(std::size_t _size) noexcept
+  {
+#ifdef __linux__
+    int v = static_cast< int >(_size);
+    if (::setsockopt(socket(), IPPROTO_UDP, UDP_SEGMENT, &v, sizeof(v)) < 0)  return uv_status(-errno);
+    return uv_status(0);
+#else
+    return uv_status(UV_ENOSYS);
+#endif
+  }
+  /*! \brief Enable or disable the UDP generic receive offload (GRO).
+      \details With GRO enabled, the kernel may coalesce several consecutive datagrams from the same peer having the
+      same size into one payload, which is received at once. The datagram boundaries can only be recovered
+      with `recv_batch_start()`, which reports the segment size in `io_info::segment_size`; the slice size passed to it
+      should be large enough to hold the coalesced payload (up to 64 KiB). Do not enable GRO on the socket read with
+      `recv_start()`. */
+  int set_gro(bool _enable) noexcept
+  {
+#ifdef __linux__
+    int v = _enable;
+    if (::setsockopt(socket(), IPPROTO_UDP, UDP_GRO, &v, sizeof(v)) < 0)  return uv_status(-errno);
+    return uv_status(0);
+#else
+    return uv_status(UV_ENOSYS);
+#endif
+  }
+  //! \}
+
+  /*! \name Egress limits: */
+  //! \{
+  /*! \brief Limit the amount of data queued for sending through the socket.
+      \details The limits apply to the datagrams sent with `udp_send::run()` (and `output::run()`) that have not been
+      written to the socket yet. Either limit is disabled by setting it to **0**; disabling both removes the limits.
+      If the next datagram would exceed a limit, it is handled according to the `_policy`:
+      \arg `egress_policy::DROP_NEWEST` - the datagram is refused,
+      \arg `egress_policy::DROP_OLDEST` - the oldest queued datagrams are dropped to make room for the new one; in this
+            mode, only a small number of datagrams is passed to libuv at once, and the rest is held back so that it
+            could be dropped,
+      \arg `egress_policy::PAUSE_RECEIVE` - the datagram is accepted, but `io::read_pause()` is called for
+            the `_receiver` handle (which is this handle by default) until the amount of the queued data falls below
+            the half of the limits, when `io::read_resume()` is called. The `_receiver` handle should outlive
+            this one or the limits should be removed before it is destroyed.
+      .
+      The dropped datagrams are counted in `egress_dropped_count()` and `egress_dropped_bytes()`. */
+  void set_egress_limits(std::size_t _max_bytes, std::size_t _max_count, egress_policy _policy = egress_policy::DROP_NEWEST)
+  { set_egress_limits(_max_bytes, _max_count, _policy, *this); }
+  /*! \brief Idem, with the receive side to be paused under the `egress_policy::PAUSE_RECEIVE` policy. */
+  void set_egress_limits(std::size_t _max_bytes, std::size_t _max_count, egress_policy _policy, const io &_receiver)
+  {
+    auto &properties = instance::from(uv_handle)->properties();
+
+    if (_max_bytes == 0 and _max_count == 0)
+    {
+      if (properties.egress and properties.egress->staged.empty())
+      {
+        if (properties.egress->paused)  io(properties.egress->receiver).read_resume(true);
+        delete properties.egress;
+        properties.egress = nullptr;
+      }
+      else if (properties.egress)  // keep the held back requests going to libuv
+        properties.egress->max_bytes = properties.egress->max_count = 0;
+      return;
+    }
+
+    if (!properties.egress)  properties.egress = new egress_control;
+    auto eg = properties.egress;
+    eg->max_bytes = _max_bytes;
+    eg->max_count = _max_count;
+    eg->policy = _policy;
+    eg->receiver = const_cast< io::uv_t* >(static_cast< const io::uv_t* >(_receiver));
+  }
+
+  /*! \brief The number of the datagrams dropped because of the egress limits. */
+  std::size_t egress_dropped_count() const noexcept
+  {
+    auto eg = instance::from(uv_handle)->properties().egress;
+    return eg ? eg->dropped_count : 0;
+  }
+  /*! \brief The number of bytes in the datagrams dropped because of the egress limits. */
+  std::size_t egress_dropped_bytes() const noexcept
+  {
+    auto eg = instance::from(uv_handle)->properties().egress;
+    return eg ? eg->dropped_bytes : 0;
+  }
+  /*! \brief The number of the datagrams held back from libuv under the `egress_policy::DROP_OLDEST` policy. */
+  std::size_t egress_backlog() const noexcept
+  {
+    auto eg = instance::from(uv_handle)->properties().egress;
+    return eg ? eg->staged.size() : 0;
+  }
+  //! \}
+
+  /*! \name Connected UDP features: */
+  //! \{
+  /*! \brief Associate the socket with a remote address so that the datagrams can be sent there without specifying
+      the address each time, and only the datagrams from that address are received.
+      \details The peer address is cached in the handle. A connected socket lets the kernel resolve the route once
+      instead of on every datagram. Use `send()` or `udp_send::run()` without an address argument for sending.
+
+      With libuv older than v1.27 (having no `uv_udp_connect()`), the socket is connected with the system
+      [`connect()`](https://man7.org/linux/man-pages/man2/connect.2.html) call and should already exist, i.e.
+      the handle should have been created with an address family flag or bound before.
+      \sa libuv API documentation: [`uv_udp_connect()`](http://docs.libuv.org/en/v1.x/udp.html#c.uv_udp_connect). */
+  template<
+      typename _T_,
+      typename = std::enable_if_t< is_one_of< _T_, ::sockaddr, ::sockaddr_in, ::sockaddr_in6, ::sockaddr_storage >::value >
+  >
+  int connect(const _T_ &_sockaddr) noexcept
+  {
+    auto &properties = instance::from(uv_handle)->properties();
+    auto sa = reinterpret_cast< const ::sockaddr* >(&_sockaddr);
+
+#if (UV_VERSION_MAJOR >= 1) && (UV_VERSION_MINOR >= 27)
+    auto uv_ret = ::uv_udp_connect(static_cast< uv_t* >(uv_handle), sa);
+#else
+    int uv_ret = 0;
+    if (socket() < 0)
+      uv_ret = UV_EBADF;
+    else if (::connect(socket(), sa, sa->sa_family == AF_INET6 ? sizeof(::sockaddr_in6) : sizeof(::sockaddr_in)) < 0)
+      uv_ret = -errno;
+#endif
+    if (uv_status(uv_ret) < 0)  return uv_ret;
+
+    init(properties.peer, *sa);
+    properties.connected = true;
+    return uv_ret;
+  }
+
+  /*! \brief Dissolve the association with the remote address.
+      \sa libuv API documentation: [`uv_udp_connect()`](http://docs.libuv.org/en/v1.x/udp.html#c.uv_udp_connect). */
+  int disconnect() noexcept
+  {
+    auto &properties = instance::from(uv_handle)->properties();
+    if (!properties.connected)  return uv_status(UV_ENOTCONN);
+
+#if (UV_VERSION_MAJOR >= 1) && (UV_VERSION_MINOR >= 27)
+    auto uv_ret = ::uv_udp_connect(static_cast< uv_t* >(uv_handle), nullptr);
+#else
+    ::sockaddr_storage unspec;
+    init(unspec, AF_UNSPEC);
+    int uv_ret = 0;
+    if (::connect(socket(), reinterpret_cast< const ::sockaddr* >(&unspec), sizeof(unspec)) < 0 and errno != EAFNOSUPPORT)
+      uv_ret = -errno;
+#endif
+    if (uv_status(uv_ret) < 0)  return uv_ret;
+
+    properties.connected = false;
+    init(properties.peer);
+    return uv_ret;
+  }
+
+  /*! \brief Check if the socket has been associated with a remote address by `connect()`. */
+  bool is_connected() const noexcept  { return instance::from(uv_handle)->properties().connected; }
+
+  /*! \brief Get the address of the remote peer which this handle is connected to.
+      \returns `true` if the handle is connected and `sizeof(_T_)` is enough to hold the returned socket address structure. */
+  template< typename _T_, typename = std::enable_if_t< is_one_of< _T_, ::sockaddr_in, ::sockaddr_in6, ::sockaddr_storage >::value > >
+  bool getpeername(_T_ &_sockaddr) const noexcept
+  {
+    auto &properties = instance::from(uv_handle)->properties();
+    if (!properties.connected)  return false;
+
+    switch (properties.peer.ss_family)
+    {
+      case AF_INET:
+          if (sizeof(_T_) < sizeof(::sockaddr_in))  return false;
+          reinterpret_cast< ::sockaddr_in& >(_sockaddr) = reinterpret_cast< const ::sockaddr_in& >(properties.peer);
+          return true;
+      case AF_INET6:
+          if (sizeof(_T_) < sizeof(::sockaddr_in6))  return false;
+          reinterpret_cast< ::sockaddr_in6& >(_sockaddr) = reinterpret_cast< const ::sockaddr_in6& >(properties.peer);
+          return true;
+      default:
+          return false;
+    }
+  }
+
+  /*! \brief Send the data to the connected peer immediately, without queuing a request.
+      \details Returns the number of bytes sent, or `UV_EAGAIN` if the data cannot be sent at once, or other error code.
+      `UV_ENOTCONN` is returned if the handle has not been connected.
+      \sa libuv API documentation: [`uv_udp_try_send()`](http://docs.libuv.org/en/v1.x/udp.html#c.uv_udp_try_send). */
+  int send(const buffer &_buf) noexcept
+  {
+    if (!is_connected())  return uv_status(UV_ENOTCONN);
+
+#if (UV_VERSION_MAJOR >= 1) && (UV_VERSION_MINOR >= 27)
+    return uv_status(::uv_udp_try_send(
+        static_cast< uv_t* >(uv_handle),
+        static_cast< const buffer::uv_t* >(_buf), _buf.count(),
+        nullptr
+    ));
+#elif defined(_WIN32)
+    return uv_status(::uv_udp_try_send(
+        static_cast< uv_t* >(uv_handle),
+        static_cast< const buffer::uv_t* >(_buf), _buf.count(),
+        reinterpret_cast< const ::sockaddr* >(&instance::from(uv_handle)->properties().peer)
+    ));
+#else
+    // as uv_udp_try_send() does, don't let the datagram overtake the ones queued with udp_send requests
+    if (static_cast< uv_t* >(uv_handle)->send_queue_count > 0)  return uv_status(UV_EAGAIN);
+
+    ::msghdr msg = {};
+    msg.msg_iov = reinterpret_cast< ::iovec* >(const_cast< buffer::uv_t* >(static_cast< const buffer::uv_t* >(_buf)));
+    msg.msg_iovlen = _buf.count();
+
+    ssize_t ret;
+    do
+      ret = ::sendmsg(socket(), &msg, MSG_DONTWAIT);
+    while (ret < 0 and errno == EINTR);
+
+    return uv_status(ret < 0 ? -errno : static_cast< int >(ret));
+#endif
+  }
+  //! \}
+
   /*! \brief Set the time to live value.
       \sa libuv API documentation: [`uv_udp_set_ttl()`](http://docs.libuv.org/en/v1.x/udp.html#c.uv_udp_set_ttl). */
   int set_ttl(int _value) noexcept  { return uv_status(::uv_udp_set_ttl(static_cast< uv_t* >(uv_handle), _value)); }
@@ -197,6 +535,90 @@ public: /*interface*/
   /*! \brief Alias for `io::read_stop()`. */
   int recv_stop() const  { return read_stop(); }
 
+  /*! \brief Start receiving datagrams in batches.
+      \details Each time the socket becomes readable, up to `_batch_size` datagrams are received with a single
+      [`recvmmsg()`](https://man7.org/linux/man-pages/man2/recvmmsg.2.html) system call into the slices of
+      `_datagram_size` bytes of one buffer, and delivered to one `_recv_cb` call. This saves the per-datagram system
+      call, buffer allocation, and callback dispatch of `recv_start()` at high packet rates.
+
+      The socket is polled through a duplicate of its descriptor, so the batch mode should not be used simultaneously
+      with `recv_start()`. Repeated call to this function results in the automatic call to `recv_batch_stop()` first.
+      \note On successful start this function adds an extra reference to the handle instance,
+      which is released when the counterpart function `recv_batch_stop()` is called.
+
+      Only available on Linux; returns `UV_ENOSYS` on other platforms. */
+  int recv_batch_start(const on_recv_batch_t &_recv_cb, std::size_t _batch_size = 64, std::size_t _datagram_size = 2048) const
+  {
+#ifdef __linux__
+    auto instance_ptr = instance::from(uv_handle);
+    auto &properties = instance_ptr->properties();
+
+    if (!_recv_cb or _batch_size == 0 or _datagram_size == 0)  return uv_status(UV_EINVAL);
+
+    recv_batch_stop();
+
+    auto sock = socket();
+    if (sock < 0)  return uv_status(UV_EBADF);
+
+    auto rx = new batch_receiver;
+    rx->uv_poll.data = rx;
+    rx->uv_handle = static_cast< uv_t* >(uv_handle);
+    rx->recv_cb = _recv_cb;
+    rx->datagram_size = _datagram_size;
+    rx->msgs.resize(_batch_size);
+    rx->iovs.resize(_batch_size);
+    rx->peers.resize(_batch_size);
+    rx->control.resize(_batch_size*CMSG_SPACE(sizeof(int)));
+    rx->batch.reserve(_batch_size);
+
+    rx->fd = ::dup(sock);
+    if (rx->fd < 0)
+    {
+      delete rx;
+      return uv_status(-errno);
+    }
+
+    auto uv_ret = ::uv_poll_init(static_cast< uv_t* >(uv_handle)->loop, &rx->uv_poll, rx->fd);
+    if (uv_ret < 0)
+    {
+      ::close(rx->fd);
+      delete rx;
+      return uv_status(uv_ret);
+    }
+
+    uv_status(0);
+    uv_ret = ::uv_poll_start(&rx->uv_poll, UV_READABLE, batch_poll_cb);
+    if (uv_ret < 0)
+    {
+      uv_status(uv_ret);
+      batch_receiver_close(rx);
+      return uv_ret;
+    }
+
+    properties.batch_rx = rx;
+    instance_ptr->ref();  // REF:BATCH_START -- make sure it will exist for the future batch_poll_cb() calls until recv_batch_stop()
+
+    return uv_ret;
+#else
+    return uv_status(UV_ENOSYS);
+#endif
+  }
+  /*! \brief Stop receiving datagrams in batches. */
+  int recv_batch_stop() const
+  {
+    auto instance_ptr = instance::from(uv_handle);
+    auto &properties = instance_ptr->properties();
+
+    auto rx = properties.batch_rx;
+    if (!rx)  return uv_status(0);
+
+    properties.batch_rx = nullptr;
+    batch_receiver_close(rx);
+
+    instance_ptr->unref();  // UNREF:BATCH_STOP -- release the reference from recv_batch_start()
+    return uv_status(0);
+  }
+
 #if 1
   /*! \brief _Get_ the size of the send buffer that the operating system uses for the socket.
       \sa libuv API documentation: [`uv_send_buffer_size()`](http://docs.libuv.org/en/v1.x/handle.html#c.uv_send_buffer_size). */
@@ -239,6 +661,92 @@ void udp::recv_cb(::uv_udp_t *_uv_handle, ssize_t _nread, const ::uv_buf_t *_uv_
   io_read_cb(_uv_handle, _nread, _uv_buf, &supplemental_data);
 }
 
+template< typename >
+void udp::batch_poll_cb(::uv_poll_t *_uv_poll, int _status, int _events)
+{
+  auto rx = static_cast< batch_receiver* >(_uv_poll->data);
+  auto instance_ptr = instance::from(rx->uv_handle);
+  ref_guard< instance > hold(*instance_ptr);  // the callback may stop the batch receiving and release the handle
+
+  if (_status < 0)
+  {
+    instance_ptr->uv_error = _status;
+    rx->batch.clear();
+    rx->recv_cb(udp(rx->uv_handle), buffer(), rx->batch);
+    return;
+  }
+
+#ifdef __linux__
+  const std::size_t batch_size = rx->msgs.size();
+  for (int n = 0; n < 16 and instance_ptr->properties().batch_rx == rx; ++n)  // bound the number of batches per wakeup
+  {
+    if (!rx->buf or rx->buf.nrefs() > 1)  // the previous buffer has been retained by the callback
+    {
+      rx->buf = buffer{ batch_size*rx->datagram_size };
+      for (std::size_t i = 0; i < batch_size; ++i)
+      {
+        rx->iovs[i].iov_base = rx->buf.base() + i*rx->datagram_size;
+        rx->iovs[i].iov_len = rx->datagram_size;
+      }
+    }
+    for (std::size_t i = 0; i < batch_size; ++i)
+    {
+      auto &hdr = rx->msgs[i].msg_hdr;
+      hdr = ::msghdr();
+      hdr.msg_name = &rx->peers[i];
+      hdr.msg_namelen = sizeof(::sockaddr_storage);
+      hdr.msg_iov = &rx->iovs[i];
+      hdr.msg_iovlen = 1;
+      hdr.msg_control = rx->control.data() + i*CMSG_SPACE(sizeof(int));
+      hdr.msg_controllen = CMSG_SPACE(sizeof(int));
+    }
+
+    int ret;
+    do
+      ret = ::recvmmsg(rx->fd, rx->msgs.data(), batch_size, MSG_DONTWAIT, nullptr);
+    while (ret < 0 and errno == EINTR);
+
+    if (ret < 0)
+    {
+      if (errno == EAGAIN or errno == EWOULDBLOCK)  return;
+
+      instance_ptr->uv_error = -errno;
+      rx->batch.clear();
+      rx->recv_cb(udp(rx->uv_handle), buffer(), rx->batch);
+      return;
+    }
+
+    instance_ptr->uv_error = 0;
+    rx->batch.clear();
+    for (int i = 0; i < ret; ++i)
+    {
+      auto &msg = rx->msgs[i];
+
+      std::size_t segment_size = 0;
+      for (auto cmsg = CMSG_FIRSTHDR(&msg.msg_hdr); cmsg; cmsg = CMSG_NXTHDR(&msg.msg_hdr, cmsg))
+        if (cmsg->cmsg_level == IPPROTO_UDP and cmsg->cmsg_type == UDP_GRO)
+        {
+          int v;
+          std::memcpy(&v, CMSG_DATA(cmsg), sizeof(v));
+          segment_size = v;
+        }
+
+      rx->batch.push_back({
+          ::uv_buf_init(static_cast< char* >(rx->iovs[i].iov_base), msg.msg_len),
+          { msg.msg_hdr.msg_namelen ? reinterpret_cast< const ::sockaddr* >(&rx->peers[i]) : nullptr,
+            (msg.msg_hdr.msg_flags & MSG_TRUNC) ? static_cast< unsigned int >(UV_UDP_PARTIAL) : 0u,
+            segment_size }
+      });
+    }
+
+    buffer buf = rx->buf;
+    rx->recv_cb(udp(rx->uv_handle), std::move(buf), rx->batch);
+
+    if (static_cast< std::size_t >(ret) < batch_size)  return;  // the socket has been drained
+  }
+#endif
+}
+
 
 }
 
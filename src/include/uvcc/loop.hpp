@@ -38,6 +38,7 @@ class loop
   friend class getaddrinfo;
   friend class getnameinfo;
   template< typename > friend class work;
+  template< typename > friend class lean_work;
   //! \endcond
 
 public: /*types*/
@@ -0,0 +1,289 @@
+
+#ifndef UVCC_MAPPED_FILE__HPP
+#define UVCC_MAPPED_FILE__HPP
+
+#include "uvcc/utility.hpp"
+#include "uvcc/buffer.hpp"
+#include "uvcc/handle-fs.hpp"
+
+#include <cstddef>      // size_t
+#include <cstdint>      // int64_t
+#include <uv.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>   // mmap() munmap() madvise() mlock() munlock()
+#include <sys/stat.h>   // fstat()
+#include <unistd.h>     // sysconf()
+#include <cerrno>       // errno
+#endif
+
+
+namespace uv
+{
+
+
+/*! \ingroup doxy_group__buffer
+    \brief The read-only memory mapping of a file region, handing out `uv::buffer`s that point directly into the mapping.
+    \details The buffers returned by `view()` are usual reference counted `uv::buffer` instances (with no memory chunk
+    of their own), which can be passed to `write::run()`, `udp_send::run()`, `fs::write::run()`, etc. without copying
+    the file data through an intermediate user-space buffer. Each of them holds a reference to the mapping, so the file
+    region stays mapped as long as at least one of such buffers or `mapped_file` objects referring to it exists.
+
+    A whole file or a window of it can be mapped. Calling `map()` again moves the window: the `mapped_file` object
+    switches to the new mapping, while the buffers having been obtained earlier keep the previous one alive.
+
+    The object is reference counted; its copies share the same mapping.
+    \note The sink callback of the buffers returned by `view()` should not be replaced, as it is what holds the reference
+    to the mapping. Such buffers cannot be used as input buffers supplied by an `on_buffer_alloc_t` callback.
+    \note If the file is truncated by another process while being mapped, accessing the pages beyond the new end of
+    the file raises `SIGBUS`. */
+class mapped_file
+{
+public: /*types*/
+  /*! \brief The access pattern hints for `advise()`.
+      \sa Linux: [`madvise()`](http://man7.org/linux/man-pages/man2/madvise.2.html). */
+  enum class advice : int
+  {
+#ifndef _WIN32
+      NORMAL = MADV_NORMAL,          /*!< no special treatment */
+      RANDOM = MADV_RANDOM,          /*!< expect page references in random order, don't read ahead */
+      SEQUENTIAL = MADV_SEQUENTIAL,  /*!< expect page references in sequential order, read ahead aggressively */
+      WILLNEED = MADV_WILLNEED,      /*!< expect access in the near future, start reading the pages in */
+      DONTNEED = MADV_DONTNEED       /*!< do not expect access in the near future, the pages can be freed */
+#else
+      NORMAL, RANDOM, SEQUENTIAL, WILLNEED, DONTNEED
+#endif
+  };
+
+private: /*types*/
+  class instance
+  {
+  public: /*data*/
+    mutable int uv_error = 0;
+    ref_count refs;
+    void *addr = nullptr;      // the page aligned start of the mapping
+    std::size_t map_length = 0;
+    char *data = nullptr;      // the start of the requested region within the mapping
+    std::size_t length = 0;
+    int64_t offset = 0;
+
+  private: /*constructors*/
+    instance() = default;
+
+  public: /*constructors*/
+    ~instance()
+    {
+#ifndef _WIN32
+      if (addr)  ::munmap(addr, map_length);
+#endif
+    }
+
+    instance(const instance&) = delete;
+    instance& operator =(const instance&) = delete;
+
+    instance(instance&&) = delete;
+    instance& operator =(instance&&) = delete;
+
+  public: /*interface*/
+    static instance* create(::uv_file _fd, int64_t _offset, std::size_t _length)
+    {
+      auto p = new instance;
+      p->offset = _offset;
+#ifndef _WIN32
+      if (_offset < 0)
+      {
+        p->uv_error = UV_EINVAL;
+        return p;
+      }
+      if (_length == 0)
+      {
+        struct ::stat st;
+        if (::fstat(_fd, &st) < 0)
+        {
+          p->uv_error = -errno;
+          return p;
+        }
+        if (st.st_size <= _offset)  return p;  // nothing to map
+        _length = static_cast< std::size_t >(st.st_size - _offset);
+      }
+
+      static const int64_t page_size = ::sysconf(_SC_PAGESIZE);
+      const int64_t map_offset = _offset & ~(page_size - 1);
+      p->map_length = _length + static_cast< std::size_t >(_offset - map_offset);
+
+      auto addr = ::mmap(nullptr, p->map_length, PROT_READ, MAP_SHARED, _fd, map_offset);
+      if (addr == MAP_FAILED)
+      {
+        p->uv_error = -errno;
+        p->map_length = 0;
+        return p;
+      }
+
+      p->addr = addr;
+      p->data = static_cast< char* >(addr) + (_offset - map_offset);
+      p->length = _length;
+#else
+      (void)_fd;
+      (void)_length;
+      p->uv_error = UV_ENOSYS;
+#endif
+      return p;
+    }
+
+    void ref()  { refs.inc(); }
+    void unref() noexcept  { if (refs.dec() == 0)  delete this; }
+  };
+
+private: /*data*/
+  instance *instance_ptr;
+
+private: /*constructors*/
+  explicit mapped_file(instance *_instance_ptr)
+  {
+    if (_instance_ptr)  _instance_ptr->ref();
+    instance_ptr = _instance_ptr;
+  }
+
+public: /*constructors*/
+  ~mapped_file()  { if (instance_ptr)  instance_ptr->unref(); }
+
+  /*! \brief Map `_length` bytes of the `_file` starting from `_offset`.
+      \details `_length` of **0** means up to the current end of the file. The `_offset` value does not need to be
+      a multiple of the page size. The file handle is not needed for the mapping to stay valid after that. */
+  explicit mapped_file(const file &_file, int64_t _offset = 0, std::size_t _length = 0)
+    : instance_ptr(instance::create(_file.fd(), _offset, _length))
+  {}
+
+  mapped_file(const mapped_file &_that) : mapped_file(_that.instance_ptr)  {}
+  mapped_file& operator =(const mapped_file &_that)
+  {
+    if (this != &_that)
+    {
+      if (_that.instance_ptr)  _that.instance_ptr->ref();
+      auto t = instance_ptr;
+      instance_ptr = _that.instance_ptr;
+      if (t)  t->unref();
+    }
+    return *this;
+  }
+
+  mapped_file(mapped_file &&_that) noexcept : instance_ptr(_that.instance_ptr)  { _that.instance_ptr = nullptr; }
+  mapped_file& operator =(mapped_file &&_that) noexcept
+  {
+    if (this != &_that)
+    {
+      auto t = instance_ptr;
+      instance_ptr = _that.instance_ptr;
+      _that.instance_ptr = nullptr;
+      if (t)  t->unref();
+    }
+    return *this;
+  }
+
+public: /*interface*/
+  void swap(mapped_file &_that) noexcept  { std::swap(instance_ptr, _that.instance_ptr); }
+  /*! \brief The current number of existing references to the same mapping as this object refers to,
+      including the ones held by the buffers obtained with `view()`. */
+  long nrefs() const noexcept  { return instance_ptr->refs.get_value(); }
+
+  /*! \brief The status value returned by the last mapping operation. */
+  int uv_status() const noexcept  { return instance_ptr->uv_error; }
+
+  /*! \brief Map another window of the `_file`. The same as creating a new `mapped_file` object and assigning
+      it to this one. */
+  int map(const file &_file, int64_t _offset = 0, std::size_t _length = 0)
+  {
+    *this = mapped_file(_file, _offset, _length);
+    return uv_status();
+  }
+
+  /*! \brief The pointer to the mapped file data. */
+  const char* data() const noexcept  { return instance_ptr->data; }
+  /*! \brief The length of the mapped file region. */
+  std::size_t size() const noexcept  { return instance_ptr->length; }
+  /*! \brief The offset of the mapped region from the beginning of the file. */
+  int64_t offset() const noexcept  { return instance_ptr->offset; }
+
+  /*! \brief Get a buffer pointing to `_length` bytes of the mapped data starting from `_pos` (relative to `offset()`).
+      \details The region is clipped to the mapped data. `_length` of **0** means up to the end of the mapped data.
+      A null-initialized buffer is returned if `_pos` is beyond the end of the mapped data. */
+  buffer view(std::size_t _pos = 0, std::size_t _length = 0) const
+  {
+    buffer ret;
+
+    auto &m = *instance_ptr;
+    if (_pos >= m.length)  return ret;
+    if (_length == 0 or _length > m.length - _pos)  _length = m.length - _pos;
+
+    ret.base() = m.data + _pos;
+    ret.len() = _length;
+    ret.sink_cb() = [keep = mapped_file(instance_ptr)](buffer&){};
+    return ret;
+  }
+
+  /*! \brief Give the kernel a hint on the access pattern to `_length` bytes of the mapped data starting from `_pos`.
+      \details `_length` of **0** means up to the end of the mapped data.
+      \sa Linux: [`madvise()`](http://man7.org/linux/man-pages/man2/madvise.2.html). */
+  int advise(advice _advice, std::size_t _pos = 0, std::size_t _length = 0) const noexcept
+  {
+    auto &m = *instance_ptr;
+#ifndef _WIN32
+    if (!m.addr)  return m.uv_error = UV_EINVAL;
+    if (_pos >= m.length)  return m.uv_error = UV_EINVAL;
+    if (_length == 0 or _length > m.length - _pos)  _length = m.length - _pos;
+
+    // madvise() requires a page aligned address
+    auto start = m.data + _pos;
+    auto aligned = static_cast< char* >(m.addr) + ((start - static_cast< char* >(m.addr)) & ~(::sysconf(_SC_PAGESIZE) - 1));
+    if (::madvise(aligned, _length + (start - aligned), static_cast< int >(_advice)) < 0)  return m.uv_error = -errno;
+    return m.uv_error = 0;
+#else
+    (void)_advice;
+    (void)_pos;
+    (void)_length;
+    return m.uv_error = UV_ENOSYS;
+#endif
+  }
+
+  /*! \brief Lock the mapped pages in memory.
+      \sa Linux: [`mlock()`](http://man7.org/linux/man-pages/man2/mlock.2.html). */
+  int lock() const noexcept
+  {
+    auto &m = *instance_ptr;
+#ifndef _WIN32
+    if (!m.addr)  return m.uv_error = UV_EINVAL;
+    return m.uv_error = (::mlock(m.addr, m.map_length) < 0 ? -errno : 0);
+#else
+    return m.uv_error = UV_ENOSYS;
+#endif
+  }
+  /*! \brief Unlock the mapped pages. */
+  int unlock() const noexcept
+  {
+    auto &m = *instance_ptr;
+#ifndef _WIN32
+    if (!m.addr)  return m.uv_error = UV_EINVAL;
+    return m.uv_error = (::munlock(m.addr, m.map_length) < 0 ? -errno : 0);
+#else
+    return m.uv_error = UV_ENOSYS;
+#endif
+  }
+
+public: /*conversion operators*/
+  explicit operator bool() const noexcept  { return (uv_status() >= 0); }  /*!< \brief Equivalent to `(uv_status() >= 0)`. */
+};
+
+
+}
+
+
+namespace std
+{
+
+//! \ingroup doxy_group__buffer
+template<> inline void swap(uv::mapped_file &_this, uv::mapped_file &_that) noexcept  { _this.swap(_that); }
+
+}
+
+
+#endif
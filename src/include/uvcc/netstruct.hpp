@@ -2,8 +2,10 @@
 #ifndef UVCC_NETSTRUCT__HPP
 #define UVCC_NETSTRUCT__HPP
 
-#include <cstring>       // memset()
+#include <cstring>       // memset() memcmp() memcpy()
 #include <cstdlib>       // atoi()
+#include <cstddef>       // size_t
+#include <cstdint>       // uint64_t
 #include <uv.h>
 
 #ifdef _WIN32
@@ -171,6 +173,86 @@ inline int init(::addrinfo &_ai,
 //! \}
 
 
+//! \name Socket address comparison and hashing
+//! \{
+
+/*! \brief The hash function object for the socket addresses.
+    \details Takes into account the address family, the IP address, and the port (and the scope id for IPv6).
+    An address of other family than `AF_INET` or `AF_INET6` is hashed by its family only.
+    Applicable as the `Hash` template parameter for the standard unordered containers. */
+struct sockaddr_hash
+{
+  static std::uint64_t mix(std::uint64_t _v) noexcept  // the finalizer of the MurmurHash3 64-bit variant
+  {
+    _v ^= _v >> 33;
+    _v *= 0xFF51AFD7ED558CCDULL;
+    _v ^= _v >> 33;
+    _v *= 0xC4CEB9FE1A85EC53ULL;
+    _v ^= _v >> 33;
+    return _v;
+  }
+
+  std::size_t operator ()(const ::sockaddr_in &_sin) const noexcept
+  {
+    std::uint32_t addr;
+    std::memcpy(&addr, &_sin.sin_addr, sizeof(addr));
+    return static_cast< std::size_t >(mix((std::uint64_t(addr) << 16 | _sin.sin_port) ^ (std::uint64_t(AF_INET) << 48)));
+  }
+  std::size_t operator ()(const ::sockaddr_in6 &_sin6) const noexcept
+  {
+    std::uint64_t hi, lo;
+    std::memcpy(&hi, reinterpret_cast< const char* >(&_sin6.sin6_addr), sizeof(hi));
+    std::memcpy(&lo, reinterpret_cast< const char* >(&_sin6.sin6_addr) + sizeof(hi), sizeof(lo));
+    return static_cast< std::size_t >(
+        mix(hi ^ mix(lo ^ (std::uint64_t(_sin6.sin6_port) << 32 | _sin6.sin6_scope_id) ^ (std::uint64_t(AF_INET6) << 48)))
+    );
+  }
+  std::size_t operator ()(const ::sockaddr &_sa) const noexcept
+  {
+    switch (_sa.sa_family)
+    {
+      case AF_INET:   return operator ()(reinterpret_cast< const ::sockaddr_in& >(_sa));
+      case AF_INET6:  return operator ()(reinterpret_cast< const ::sockaddr_in6& >(_sa));
+      default:        return static_cast< std::size_t >(mix(_sa.sa_family));
+    }
+  }
+  std::size_t operator ()(const ::sockaddr_storage &_ss) const noexcept  { return operator ()(reinterpret_cast< const ::sockaddr& >(_ss)); }
+};
+
+/*! \brief The equality function object for the socket addresses.
+    \details Compares the address family, the IP address, and the port (and the scope id for IPv6).
+    The addresses of other families than `AF_INET` and `AF_INET6` are compared by their family only.
+    Applicable as the `KeyEqual` template parameter for the standard unordered containers. */
+struct sockaddr_equal
+{
+  bool operator ()(const ::sockaddr_in &_a, const ::sockaddr_in &_b) const noexcept
+  {
+    return _a.sin_port == _b.sin_port and std::memcmp(&_a.sin_addr, &_b.sin_addr, sizeof(_a.sin_addr)) == 0;
+  }
+  bool operator ()(const ::sockaddr_in6 &_a, const ::sockaddr_in6 &_b) const noexcept
+  {
+    return
+        _a.sin6_port == _b.sin6_port and _a.sin6_scope_id == _b.sin6_scope_id
+      and
+        std::memcmp(&_a.sin6_addr, &_b.sin6_addr, sizeof(_a.sin6_addr)) == 0;
+  }
+  bool operator ()(const ::sockaddr &_a, const ::sockaddr &_b) const noexcept
+  {
+    if (_a.sa_family != _b.sa_family)  return false;
+    switch (_a.sa_family)
+    {
+      case AF_INET:   return operator ()(reinterpret_cast< const ::sockaddr_in& >(_a), reinterpret_cast< const ::sockaddr_in& >(_b));
+      case AF_INET6:  return operator ()(reinterpret_cast< const ::sockaddr_in6& >(_a), reinterpret_cast< const ::sockaddr_in6& >(_b));
+      default:        return true;
+    }
+  }
+  bool operator ()(const ::sockaddr_storage &_a, const ::sockaddr_storage &_b) const noexcept
+  { return operator ()(reinterpret_cast< const ::sockaddr& >(_a), reinterpret_cast< const ::sockaddr& >(_b)); }
+};
+
+//! \}
+
+
 //! \}
 }
 
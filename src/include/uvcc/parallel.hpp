@@ -0,0 +1,346 @@
+
+#ifndef UVCC_PARALLEL__HPP
+#define UVCC_PARALLEL__HPP
+
+#include "uvcc/utility.hpp"
+#include "uvcc/loop.hpp"
+#include "uvcc/future.hpp"
+#include "uvcc/executor.hpp"
+
+#include <cstddef>      // size_t
+#include <cstdlib>      // getenv() atoi()
+#include <uv.h>
+
+#include <algorithm>    // sort() inplace_merge()
+#include <atomic>       // atomic memory_order_relaxed
+#include <chrono>       // steady_clock duration_cast nanoseconds
+#include <functional>   // less
+#include <iterator>     // iterator_traits make_move_iterator()
+#include <memory>       // make_shared() shared_ptr unique_ptr
+#include <type_traits>  // decay_t
+#include <utility>      // move()
+#include <vector>       // vector
+
+
+namespace uv
+{
+/*! \defgroup doxy_group__parallel  Parallel algorithms
+    \ingroup doxy_group__future
+    \brief Parallel algorithms over random-access ranges executed on the libuv thread pool.
+    \details The algorithms split the range into chunks processed by a number of tasks queued to the thread pool
+    (as many as there are threads in it, see `parallel_workers()`) and return a `uv::future` which is completed
+    on the loop thread with the combined result. The loop thread is never blocked, the result is consumed with
+    `future::then()` or `future::on_ready()` continuations.
+
+    The chunks are claimed by the tasks dynamically from a shared atomic counter, and each task adapts the size of
+    its next chunk to the measured processing time of the previous ones (aiming at about 100 microseconds per chunk).
+    So the chunking automatically adapts to the cost of processing a single element, and the load is balanced
+    among the threads even when that cost varies across the range.
+
+    The range and the function objects must stay valid until the returned future is completed. If any function
+    object throws an exception the processing is stopped and the future is completed with that exception. */
+//! \{
+
+
+/*! \brief The number of tasks the parallel algorithms split the processing into.
+    \details It is equal to the number of threads the tasks are run on: the number of threads of the executor
+    assigned for the `executors::pool::CPU` request class if there is one (see `uv::executors`), otherwise
+    the libuv thread pool size, that is the value of the `UV_THREADPOOL_SIZE` environment variable
+    (limited to the range of 1...128) or **4** by default.
+    \sa libuv API documentation: [Thread pool work scheduling](http://docs.libuv.org/en/v1.x/threadpool.html#thread-pool-work-scheduling). */
+inline unsigned int parallel_workers() noexcept
+{
+  auto routed = executors::threads(executors::pool::CPU);
+  if (routed)  return routed;
+
+  auto env = std::getenv("UV_THREADPOOL_SIZE");
+  int n = env ? std::atoi(env) : 4;
+  return n < 1 ? 1 : n > 128 ? 128 : n;
+}
+
+
+//! \cond internals
+//! \addtogroup doxy_group__internals
+//! \{
+
+/* run the _body(worker, begin, end) function over [0, _n) index range by chunks on _workers thread pool tasks */
+template< class _Body_ >
+future< void > parallel_chunks(uv::loop &_loop, std::size_t _n, std::size_t _workers, _Body_ &&_body)
+{
+  constexpr const long long target_chunk_duration = 100000;  // nanoseconds
+
+  struct context
+  {
+    std::atomic< std::size_t > next;
+    std::size_t n;
+    std::size_t workers;
+    std::decay_t< _Body_ > body;
+
+    context(std::size_t _n, std::size_t _workers, _Body_ &&_body)
+      : next(0), n(_n), workers(_workers), body(std::forward< _Body_ >(_body))
+    {}
+
+    void run(std::size_t _worker)
+    {
+      std::size_t grain = 1;
+      for (;;)
+      {
+        auto begin = next.fetch_add(grain, std::memory_order_relaxed);
+        if (begin >= n)  break;
+        auto end = lowest(n, begin + grain);
+
+        auto t0 = std::chrono::steady_clock::now();
+        try
+        {
+          body(_worker, begin, end);
+        }
+        catch (...)
+        {
+          next.store(n, std::memory_order_relaxed);  // stop the other workers
+          throw;
+        }
+        auto dt = std::chrono::duration_cast< std::chrono::nanoseconds >(std::chrono::steady_clock::now() - t0).count();
+
+        if (dt < target_chunk_duration/2)
+          grain *= 2;
+        else if (dt > target_chunk_duration*2 and grain > 1)
+          grain /= 2;
+
+        // keep the tail of the range balanced among the workers
+        auto claimed = next.load(std::memory_order_relaxed);
+        auto remaining = claimed < n ? n - claimed : 0;
+        grain = greatest(std::size_t(1), lowest(grain, remaining/(2*workers)));
+      }
+    }
+  };
+
+  if (_n == 0)  return make_ready_future();
+
+  auto workers = lowest(_workers, _n);
+  auto ctx = std::make_shared< context >(_n, workers, std::forward< _Body_ >(_body));
+
+  std::vector< future< void > > tasks;
+  tasks.reserve(workers);
+  for (std::size_t w = 0; w < workers; ++w)  tasks.emplace_back(queue_work(_loop, [ctx, w](){ ctx->run(w); }));
+
+  return when_all(std::move(tasks)).then([](future< std::vector< future< void > > > _tasks){
+    for (auto &t : _tasks.get())  t.get();  // rethrow the first failure
+  });
+}
+
+//! \}
+//! \endcond
+
+
+/*! \brief Apply the function `_f` to every element of the range `[_first, _last)`.
+    \details The future is completed when all the elements have been processed. */
+template< class _RandomIt_, class _F_ >
+future< void > parallel_for(uv::loop &_loop, _RandomIt_ _first, _RandomIt_ _last, _F_ _f)
+{
+  return parallel_chunks(_loop, _last - _first, parallel_workers(),
+      [_first, _f](std::size_t, std::size_t _begin, std::size_t _end) mutable {
+        for (auto i = _begin; i < _end; ++i)  _f(_first[i]);
+      }
+  );
+}
+
+/*! \brief Apply the function `_f` to every element of the range `[_first, _last)` and store the result
+    in the range beginning at `_d_first`.
+    \details The future is completed with the output iterator to the element past the last element stored. */
+template< class _RandomIt_, class _OutRandomIt_, class _F_ >
+future< _OutRandomIt_ > parallel_transform(uv::loop &_loop, _RandomIt_ _first, _RandomIt_ _last, _OutRandomIt_ _d_first, _F_ _f)
+{
+  auto d_last = _d_first + (_last - _first);
+  return parallel_chunks(_loop, _last - _first, parallel_workers(),
+      [_first, _d_first, _f](std::size_t, std::size_t _begin, std::size_t _end) mutable {
+        for (auto i = _begin; i < _end; ++i)  _d_first[i] = _f(_first[i]);
+      }
+  ).then([d_last](future< void > _f){
+    _f.get();
+    return d_last;
+  });
+}
+
+/*! \brief Reduce the range `[_first, _last)` with the binary operation `_op` starting from the `_init` value.
+    \details The operation is applied in unspecified order and grouping (like `std::reduce()` does), so it should be
+    associative and commutative. The partial results of the thread pool tasks are combined on the loop thread. */
+template< class _RandomIt_, typename _T_, class _BinaryOp_ >
+future< _T_ > parallel_reduce(uv::loop &_loop, _RandomIt_ _first, _RandomIt_ _last, _T_ _init, _BinaryOp_ _op)
+{
+  struct partial
+  {
+    bool has_value = false;
+    _T_ value;
+  };
+
+  auto workers = parallel_workers();
+  auto partials = std::make_shared< std::vector< partial > >(workers);
+
+  return parallel_chunks(_loop, _last - _first, workers,
+      [_first, _op, partials](std::size_t _worker, std::size_t _begin, std::size_t _end) mutable {
+        auto &p = (*partials)[_worker];
+        auto i = _begin;
+        if (!p.has_value)
+        {
+          p.value = _first[i++];
+          p.has_value = true;
+        }
+        for (; i < _end; ++i)  p.value = _op(std::move(p.value), _first[i]);
+      }
+  ).then([_init, _op, partials](future< void > _f) mutable {
+    _f.get();
+    for (auto &p : *partials)  if (p.has_value)  _init = _op(std::move(_init), std::move(p.value));
+    return _init;
+  });
+}
+/*! \brief Idem with `std::plus<>` binary operation. */
+template< class _RandomIt_, typename _T_ >
+future< _T_ > parallel_reduce(uv::loop &_loop, _RandomIt_ _first, _RandomIt_ _last, _T_ _init)
+{
+  return parallel_reduce(_loop, _first, _last, std::move(_init), std::plus<>());
+}
+
+/*! \brief Count the elements of the range `[_first, _last)` for which the predicate `_p` returns `true`. */
+template< class _RandomIt_, class _UnaryPredicate_ >
+future< typename std::iterator_traits< _RandomIt_ >::difference_type >
+parallel_count_if(uv::loop &_loop, _RandomIt_ _first, _RandomIt_ _last, _UnaryPredicate_ _p)
+{
+  using count_type = typename std::iterator_traits< _RandomIt_ >::difference_type;
+
+  auto workers = parallel_workers();
+  auto counts = std::make_shared< std::vector< count_type > >(workers, 0);
+
+  return parallel_chunks(_loop, _last - _first, workers,
+      [_first, _p, counts](std::size_t _worker, std::size_t _begin, std::size_t _end) mutable {
+        count_type n = 0;
+        for (auto i = _begin; i < _end; ++i)  if (_p(_first[i]))  ++n;
+        (*counts)[_worker] += n;
+      }
+  ).then([counts](future< void > _f){
+    _f.get();
+    count_type n = 0;
+    for (auto c : *counts)  n += c;
+    return n;
+  });
+}
+
+
+//! \cond internals
+//! \addtogroup doxy_group__internals
+//! \{
+
+/* merge the adjacent sorted sections pairwise while there is more than one section */
+template< class _RandomIt_, class _Compare_ >
+future< void > parallel_merge(uv::loop _loop, _RandomIt_ _first, std::shared_ptr< std::vector< std::size_t > > _bounds, std::size_t _width, _Compare_ _comp)
+{
+  const std::size_t nsections = _bounds->size() - 1;
+  if (_width >= nsections)  return make_ready_future();
+
+  std::vector< future< void > > tasks;
+  for (std::size_t i = 0; i + _width < nsections; i += 2*_width)
+  {
+    auto lo = (*_bounds)[i], mid = (*_bounds)[i + _width], hi = (*_bounds)[lowest(i + 2*_width, nsections)];
+    tasks.emplace_back(queue_work(_loop, [_first, lo, mid, hi, _comp](){ std::inplace_merge(_first + lo, _first + mid, _first + hi, _comp); }));
+  }
+
+  return when_all(std::move(tasks)).then([_loop, _first, _bounds, _width, _comp](future< std::vector< future< void > > > _tasks){
+    for (auto &t : _tasks.get())  t.get();
+    return parallel_merge(_loop, _first, _bounds, 2*_width, _comp);
+  });
+}
+
+//! \}
+//! \endcond
+
+//! \cond internals
+//! \addtogroup doxy_group__internals
+//! \{
+
+template< typename _R_ > struct batch_future  { using type = future< std::vector< _R_ > >; };
+template<> struct batch_future< void >  { using type = future< void >; };
+
+template< class _Task_ >
+future< void > queue_batch(uv::loop &_loop, std::shared_ptr< std::vector< _Task_ > > _tasks, std::false_type)
+{
+  return parallel_chunks(_loop, _tasks->size(), parallel_workers(),
+      [_tasks](std::size_t, std::size_t _begin, std::size_t _end){
+        for (auto i = _begin; i < _end; ++i)  (*_tasks)[i]();
+      }
+  );
+}
+
+template< class _Task_, typename _R_ = invoke_result_t< _Task_& > >
+future< std::vector< _R_ > > queue_batch(uv::loop &_loop, std::shared_ptr< std::vector< _Task_ > > _tasks, std::true_type)
+{
+  const std::size_t n = _tasks->size();
+  std::shared_ptr< _R_ > results(new _R_[n], std::default_delete< _R_[] >());  // not a vector: concurrent writes to std::vector< bool > elements would race
+
+  return parallel_chunks(_loop, n, parallel_workers(),
+      [_tasks, results](std::size_t, std::size_t _begin, std::size_t _end){
+        for (auto i = _begin; i < _end; ++i)  results.get()[i] = (*_tasks)[i]();
+      }
+  ).then([results, n](future< void > _f){
+    _f.get();
+    return std::vector< _R_ >(std::make_move_iterator(results.get()), std::make_move_iterator(results.get() + n));
+  });
+}
+
+//! \}
+//! \endcond
+
+
+/*! \brief Run a batch of tasks on the thread pool with a single completion.
+    \details Submitting a lot of small tasks as separate `uv::work` requests costs a thread pool queue operation
+    and an after-work callback on the loop thread per each task. This function runs the whole batch with only as many
+    thread pool queue entries as there are threads in the pool (see `parallel_workers()`); the tasks are dequeued
+    by chunks of adaptive size, and the loop thread is notified just once when the whole batch has been completed.
+
+    The returned future is completed with the vector of the task results in the order of the tasks, or
+    with no value if the tasks return `void`. The result type should be default constructible.
+    If some task throws an exception, the tasks that have not been started yet are skipped and the future is
+    completed with that exception. */
+template< class _Task_, typename _R_ = invoke_result_t< _Task_& > >
+typename batch_future< _R_ >::type queue_batch(uv::loop &_loop, std::vector< _Task_ > _tasks)
+{
+  return queue_batch(_loop, std::make_shared< std::vector< _Task_ > >(std::move(_tasks)),
+      std::integral_constant< bool, !std::is_void< _R_ >::value >());
+}
+
+
+/*! \brief Sort the range `[_first, _last)` with the comparison function `_comp`.
+    \details The range is split into as many sections as there are thread pool threads (but the sections
+    are not made shorter than a few thousands of elements); the sections are sorted with `std::sort()` in parallel,
+    and then they are merged pairwise with `std::inplace_merge()` in a number of parallel rounds. */
+template< class _RandomIt_, class _Compare_ = std::less<> >
+future< void > parallel_sort(uv::loop &_loop, _RandomIt_ _first, _RandomIt_ _last, _Compare_ _comp = _Compare_())
+{
+  constexpr const std::size_t min_section_length = 4096;
+
+  const std::size_t n = _last - _first;
+  if (n < 2)  return make_ready_future();
+
+  const std::size_t nsections = greatest(std::size_t(1), lowest(std::size_t(parallel_workers()), n/min_section_length));
+  auto bounds = std::make_shared< std::vector< std::size_t > >(nsections + 1);
+  for (std::size_t i = 0; i <= nsections; ++i)  (*bounds)[i] = n*i/nsections;
+
+  std::vector< future< void > > tasks;
+  tasks.reserve(nsections);
+  for (std::size_t i = 0; i < nsections; ++i)
+  {
+    auto lo = (*bounds)[i], hi = (*bounds)[i + 1];
+    tasks.emplace_back(queue_work(_loop, [_first, lo, hi, _comp](){ std::sort(_first + lo, _first + hi, _comp); }));
+  }
+
+  uv::loop loop = _loop;
+  return when_all(std::move(tasks)).then([loop, _first, bounds, _comp](future< std::vector< future< void > > > _tasks){
+    for (auto &t : _tasks.get())  t.get();
+    return parallel_merge(loop, _first, bounds, 1, _comp);
+  });
+}
+
+
+//! \}
+}
+
+
+#endif
@@ -165,6 +165,19 @@ public: /*constructors*/
     return *this;
   }
 
+private: /*functions*/
+  static ::uv__work* work_req(uv_t *_uv_req) noexcept
+  {
+    switch (_uv_req->type)
+    {
+      case UV_FS:           return &reinterpret_cast< ::uv_fs_t* >(_uv_req)->work_req;
+      case UV_WORK:         return &reinterpret_cast< ::uv_work_t* >(_uv_req)->work_req;
+      case UV_GETADDRINFO:  return &reinterpret_cast< ::uv_getaddrinfo_t* >(_uv_req)->work_req;
+      case UV_GETNAMEINFO:  return &reinterpret_cast< ::uv_getnameinfo_t* >(_uv_req)->work_req;
+      default:              return nullptr;
+    }
+  }
+
 protected: /*functions*/
   //! \cond
   int uv_status(int _value) const noexcept
@@ -210,8 +223,29 @@ public: /*interface*/
   void*      & data()       noexcept  { return static_cast< uv_t* >(uv_req)->data; }
 
   /*! \brief Cancel a pending request.
+      \details Only the requests waiting in the libuv thread pool queue can be cancelled. `UV_EBUSY` is returned for
+      the requests that are not handed to the libuv thread pool: the ones routed to an executor (see `uv::executors`),
+      submitted to an io_uring ring (see `uv::fs_ring`), or carried out by uvcc itself, like `fs::copy` and
+      `fs::readdir`.
       \sa libuv API documentation: [`uv_cancel()`](http://docs.libuv.org/en/v1.x/request.html#c.uv_cancel).*/
-  int cancel() noexcept  { return ::uv_cancel(static_cast< uv_t* >(uv_req)); }
+  int cancel() noexcept
+  {
+    auto uv_req_ptr = static_cast< uv_t* >(uv_req);
+    auto w = work_req(uv_req_ptr);
+    if (w and !w->loop)  return UV_EBUSY;  // uv_cancel() would dereference the null loop
+    return ::uv_cancel(uv_req_ptr);
+  }
+
+  //! \cond internals
+  /* mark the request as not being handed to the libuv thread pool: its work_req.loop is null then, as it is for
+     a request that has never been submitted there (the request structures are zero-initialized) */
+  static void unqueued(uv_t *_uv_req) noexcept
+  {
+    auto w = work_req(_uv_req);
+    if (w)  w->loop = nullptr;
+  }
+  template< typename _UV_T_ > static void unqueued(_UV_T_ *_uv_req) noexcept  { unqueued(reinterpret_cast< uv_t* >(_uv_req)); }
+  //! \endcond
 
 public: /*conversion operators*/
   explicit operator const uv_t*() const noexcept  { return static_cast< const uv_t* >(uv_req); }
@@ -5,10 +5,12 @@
 #include "uvcc/utility.hpp"
 #include "uvcc/request-base.hpp"
 #include "uvcc/loop.hpp"
+#include "uvcc/executor.hpp"
 
 #include <uv.h>
 
 #include <functional>   // function
+#include <string>       // string
 #include <type_traits>  // enable_if_t
 
 
@@ -70,6 +72,46 @@ public: /*constructors*/
 private: /*functions*/
   template< typename = void > static void getaddrinfo_cb(::uv_getaddrinfo_t*, int, ::addrinfo*);
 
+  int route(uv::loop &_loop, const char *_hostname, const char *_service, const ::addrinfo *_hints)
+  {
+    if (!executors::is_assigned(executors::pool::DNS))  return UV_ENOSYS;
+
+    auto uv_loop = static_cast< uv::loop::uv_t* >(_loop);
+    auto uv_req_ptr = static_cast< uv_t* >(uv_req);
+
+    struct args_t
+    {
+      bool has_hostname, has_service, has_hints;
+      std::string hostname, service;
+      ::addrinfo hints;
+    } args = { _hostname != nullptr, _service != nullptr, _hints != nullptr, _hostname ? _hostname : "", _service ? _service : "", {} };
+    if (_hints)
+    {
+      args.hints.ai_flags = _hints->ai_flags;
+      args.hints.ai_family = _hints->ai_family;
+      args.hints.ai_socktype = _hints->ai_socktype;
+      args.hints.ai_protocol = _hints->ai_protocol;
+    }
+
+    unqueued(uv_req_ptr);
+    return executors::route(executors::pool::DNS, uv_loop,
+        [uv_req_ptr, args]()
+        {
+          return ::uv_getaddrinfo(
+              executors::dummy_loop(), uv_req_ptr,
+              nullptr,
+              args.has_hostname ? args.hostname.c_str() : nullptr, args.has_service ? args.service.c_str() : nullptr,
+              args.has_hints ? &args.hints : nullptr
+          );
+        },
+        [uv_req_ptr, uv_loop](int _status)
+        {
+          uv_req_ptr->loop = uv_loop;
+          getaddrinfo_cb(uv_req_ptr, _status, uv_req_ptr->addrinfo);
+        }
+    );
+  }
+
   int run_(uv::loop &_loop, const char *_hostname, const char *_service, const ::addrinfo *_hints)
   {
     ::uv_freeaddrinfo(static_cast< uv_t* >(uv_req)->addrinfo);  // assuming that *uv_req or this particular field has initially been nulled
@@ -89,7 +131,8 @@ private: /*functions*/
       instance_ptr->ref();
 
       uv_status(0);
-      auto uv_ret = ::uv_getaddrinfo(
+      auto uv_ret = route(_loop, _hostname, _service, _hints);
+      if (uv_ret == UV_ENOSYS)  uv_ret = ::uv_getaddrinfo(
           static_cast< uv::loop::uv_t* >(_loop), static_cast< uv_t* >(uv_req),
           getaddrinfo_cb,
           _hostname, _service, _hints
@@ -188,6 +231,39 @@ public: /*constructors*/
 private: /*functions*/
   template< typename = void > static void getnameinfo_cb(::uv_getnameinfo_t*, int, const char*, const char*);
 
+  int route(uv::loop &_loop, const ::sockaddr *_sa, int _NI_FLAGS)
+  {
+    if (!executors::is_assigned(executors::pool::DNS))  return UV_ENOSYS;
+
+    auto uv_loop = static_cast< uv::loop::uv_t* >(_loop);
+    auto uv_req_ptr = static_cast< uv_t* >(uv_req);
+
+    ::sockaddr_storage sa = {};
+    switch (_sa->sa_family)
+    {
+    case AF_INET:   *reinterpret_cast< ::sockaddr_in* >(&sa) = *reinterpret_cast< const ::sockaddr_in* >(_sa);  break;
+    case AF_INET6:  *reinterpret_cast< ::sockaddr_in6* >(&sa) = *reinterpret_cast< const ::sockaddr_in6* >(_sa);  break;
+    default:        return UV_ENOSYS;  // let libuv report the error
+    }
+
+    unqueued(uv_req_ptr);
+    return executors::route(executors::pool::DNS, uv_loop,
+        [uv_req_ptr, sa, _NI_FLAGS]()
+        {
+          return ::uv_getnameinfo(
+              executors::dummy_loop(), uv_req_ptr,
+              nullptr,
+              reinterpret_cast< const ::sockaddr* >(&sa), _NI_FLAGS
+          );
+        },
+        [uv_req_ptr, uv_loop](int _status)
+        {
+          uv_req_ptr->loop = uv_loop;
+          getnameinfo_cb(uv_req_ptr, _status, uv_req_ptr->host, uv_req_ptr->service);
+        }
+    );
+  }
+
 public: /*interface*/
   on_request_t& on_request() const noexcept  { return instance::from(uv_req)->request_cb_storage.value(); }
 
@@ -231,7 +307,8 @@ public: /*interface*/
       instance_ptr->ref();
 
       uv_status(0);
-      auto uv_ret = ::uv_getnameinfo(
+      auto uv_ret = route(_loop, reinterpret_cast< const ::sockaddr* >(&_sa), _NI_FLAGS);
+      if (uv_ret == UV_ENOSYS)  uv_ret = ::uv_getnameinfo(
           static_cast< uv::loop::uv_t* >(_loop), static_cast< uv_t* >(uv_req),
           getnameinfo_cb,
           reinterpret_cast< const ::sockaddr* >(&_sa), _NI_FLAGS
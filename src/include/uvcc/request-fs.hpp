@@ -8,16 +8,32 @@
 #include "uvcc/handle-io.hpp"
 #include "uvcc/buffer.hpp"
 #include "uvcc/loop.hpp"
+#include "uvcc/executor.hpp"
 
 #include <uv.h>
 
 #ifdef _WIN32
 #include <io.h>         // _telli64()
 #else
-#include <unistd.h>     // lseek64()
+#include <unistd.h>     // lseek64() pread() pwrite() ftruncate()
+#include <sys/stat.h>   // fstat()
+#include <fcntl.h>      // open() fallocate() O_DIRECTORY O_CLOEXEC
+#include <dirent.h>     // DT_REG DT_DIR ...
+#include <poll.h>       // poll()
+#include <cerrno>       // errno
+#endif
+#ifdef __linux__
+#include <sys/sendfile.h>  // sendfile()
+#include <sys/syscall.h>   // __NR_copy_file_range __NR_getdents64
 #endif
 
+#include <atomic>       // atomic memory_order_relaxed
+#include <cstddef>      // ptrdiff_t
+#include <cstring>      // memcpy()
 #include <functional>   // function
+#include <iterator>     // forward_iterator_tag
+#include <memory>       // unique_ptr
+#include <string>       // string
 #include <type_traits>  // enable_if_t is_convertible
 
 
@@ -52,6 +68,7 @@ public: /*types*/
   class sync;
   class truncate;
   class sendfile;
+  class copy;
 
   class stat;
   class chmod;
@@ -63,6 +80,7 @@ public: /*types*/
   class mkdtemp;
   class rmdir;
   class scandir;
+  class readdir;
   class rename;
   class access;
   class link;
@@ -219,10 +237,9 @@ public: /*interface*/
       _file.read_stop();  // it shall be after adding the extra reference to the handle
 
       uv_status(0);
-      auto uv_ret = ::uv_fs_close(
+      auto uv_ret = executors::queue_fs(::uv_fs_close, close_cb,
           static_cast< file::uv_t* >(_file)->loop, static_cast< uv_t* >(uv_req),
-          _file.fd(),
-          close_cb
+          _file.fd()
       );
       if (uv_ret < 0)
       {
@@ -368,12 +385,11 @@ public: /*interface*/
       }
 
       uv_status(0);
-      auto uv_ret = ::uv_fs_read(
+      auto uv_ret = executors::queue_fs(::uv_fs_read, read_cb,
           static_cast< file::uv_t* >(_file)->loop, static_cast< uv_t* >(uv_req),
           _file.fd(),
           static_cast< const buffer::uv_t* >(_buf), _buf.count(),
-          _offset,
-          read_cb
+          _offset
       );
       if (uv_ret < 0)
       {
@@ -462,6 +478,53 @@ public: /*constructors*/
 
 private: /*functions*/
   template< typename = void > static void write_cb(::uv_fs_t*);
+  template< typename = void > static void batch_cb(::uv_fs_t*);
+
+  /* start writing the next batch of the coalesced requests: the pending requests following the first one
+     at contiguous offsets are merged into a single vectored write */
+  static int flush(file::write_queue *_wq, file::uv_t *_uv_handle)
+  {
+    if (_wq->pending.empty())  return 0;
+
+    _wq->batch.clear();
+    _wq->bufs.clear();
+
+    auto offset = instance::from(_wq->pending.front())->properties().offset;
+    auto end = offset;
+    std::size_t size = 0;
+    while (!_wq->pending.empty())
+    {
+      auto &properties = instance::from(_wq->pending.front())->properties();
+      auto buf_count = buffer::instance::from(properties.uv_buf)->buf_count;
+      if (!_wq->batch.empty())
+      {
+        if (properties.offset != end)  break;
+        if (_wq->bufs.size() + buf_count > MAX_BATCH_BUFS or size + properties.pending_size > MAX_BATCH_SIZE)  break;
+      }
+
+      _wq->batch.push_back(_wq->pending.front());
+      _wq->pending.pop_front();
+      _wq->bufs.insert(_wq->bufs.end(), properties.uv_buf, properties.uv_buf + buf_count);
+      end += static_cast< int64_t >(properties.pending_size);
+      size += properties.pending_size;
+    }
+
+    ::uv_fs_req_cleanup(&_wq->uv_req_struct);
+    _wq->uv_req_struct.data = _wq;
+
+    auto uv_ret = executors::queue_fs(::uv_fs_write, batch_cb,
+        _uv_handle->loop, &_wq->uv_req_struct,
+        _uv_handle->result,
+        _wq->bufs.data(), static_cast< unsigned int >(_wq->bufs.size()),
+        offset
+    );
+    if (uv_ret < 0)
+      _wq->pending.insert(_wq->pending.begin(), _wq->batch.begin(), _wq->batch.end());  // put the batch back
+    else
+      _wq->busy = true;
+
+    return uv_ret;
+  }
 
 public: /*interface*/
   on_request_t& on_request() const noexcept  { return instance::from(uv_req)->request_cb_storage.value(); }
@@ -484,6 +547,16 @@ public: /*interface*/
   {
     ::uv_fs_req_cleanup(static_cast< uv_t* >(uv_req));  // assuming that *uv_req has initially been nulled
 
+    auto instance_ptr = instance::from(uv_req);
+
+    auto wq = file::instance::from(_file.uv_handle)->properties().wq;
+    if (wq and wq->enabled and instance_ptr->request_cb_storage.value())
+    {
+      if (_offset < 0 and wq->has_tail)  _offset = wq->tail;
+    }
+    else
+      wq = nullptr;
+
     if (_offset < 0)
     {
 #ifdef _WIN32
@@ -494,8 +567,6 @@ public: /*interface*/
 #endif
     }
 
-    auto instance_ptr = instance::from(uv_req);
-
     if (!instance_ptr->request_cb_storage.value())
     {
       auto &properties = instance_ptr->properties();
@@ -531,13 +602,30 @@ public: /*interface*/
       file::instance::from(_file.uv_handle)->properties().write_queue_size += wr_size;
 
       uv_status(0);
-      auto uv_ret = ::uv_fs_write(
-          static_cast< file::uv_t* >(_file)->loop, static_cast< uv_t* >(uv_req),
-          _file.fd(),
-          static_cast< const buffer::uv_t* >(_buf), _buf.count(),
-          _offset,
-          write_cb
-      );
+      int uv_ret = 0;
+      if (wq)
+      {
+        wq->pending.push_back(static_cast< uv_t* >(uv_req));
+        wq->has_tail = true;
+        wq->tail = _offset + static_cast< int64_t >(wr_size);
+        ++wq->queued;
+        if (!wq->busy)
+        {
+          uv_ret = flush(wq, static_cast< file::uv_t* >(_file));
+          if (uv_ret < 0)
+          {
+            wq->pending.pop_back();
+            --wq->queued;
+          }
+        }
+      }
+      else
+        uv_ret = executors::queue_fs(::uv_fs_write, write_cb,
+            static_cast< file::uv_t* >(_file)->loop, static_cast< uv_t* >(uv_req),
+            _file.fd(),
+            static_cast< const buffer::uv_t* >(_buf), _buf.count(),
+            _offset
+        );
       if (uv_ret < 0)
       {
         uv_status(uv_ret);
@@ -592,8 +680,67 @@ public: /*interface*/
 public: /*conversion operators*/
   explicit operator const uv_t*() const noexcept  { return static_cast< const uv_t* >(uv_req); }
   explicit operator       uv_t*()       noexcept  { return static_cast<       uv_t* >(uv_req); }
+
+private: /*constants*/
+  enum : std::size_t  { MAX_BATCH_BUFS = 1024, MAX_BATCH_SIZE = 4*1024*1024 };
 };
 
+template< typename >
+void fs::write::batch_cb(::uv_fs_t *_uv_req)
+{
+  auto wq = static_cast< file::write_queue* >(_uv_req->data);
+  auto result = _uv_req->result;
+  ::uv_fs_req_cleanup(_uv_req);
+
+  std::vector< uv_t* > batch;
+  batch.swap(wq->batch);
+  wq->busy = false;
+
+  // hand out the written bytes amount to the requests in order; on a short write
+  // the requests that have not been touched at all are written again
+  std::size_t requeue = batch.size();
+  ssize_t done = 0;
+  for (std::size_t i = 0; i < batch.size(); ++i)
+  {
+    auto size = static_cast< ssize_t >(instance::from(batch[i])->properties().pending_size);
+    if (result < 0)
+      batch[i]->result = result;
+    else if (result > 0 and done >= result)
+    {
+      requeue = i;
+      break;
+    }
+    else
+    {
+      auto rest = result > done ? result - done : 0;
+      batch[i]->result = rest < size ? rest : size;
+    }
+    done += size;
+  }
+  wq->pending.insert(wq->pending.begin(), batch.begin() + requeue, batch.end());
+  batch.resize(requeue);
+
+  auto uv_handle = instance::from(batch.front())->properties().uv_handle;
+  for (int uv_ret; (uv_ret = flush(wq, uv_handle)) < 0; )
+  {
+    // fail the requests that cannot be started
+    auto uv_req = wq->pending.front();
+    wq->pending.pop_front();
+    uv_req->result = uv_ret;
+    batch.push_back(uv_req);
+  }
+  wq->completed += batch.size();
+
+  // resume the group commit round waiting for these writes; the round requests keep the file alive
+  auto sg = file::instance::from(uv_handle)->properties().sg;
+  bool resume_sync = sg and sg->waiting and wq->completed >= sg->barrier;
+  if (resume_sync)  sg->waiting = false;
+
+  for (auto uv_req : batch)  write_cb(uv_req);
+
+  if (resume_sync)  sg->resume(uv_handle);
+}
+
 template< typename >
 void fs::write::write_cb(::uv_fs_t *_uv_req)
 {
@@ -636,6 +783,7 @@ protected: /*types*/
   struct properties : fs::properties
   {
     file::uv_t *uv_handle = nullptr;
+    bool flush_all_metadata = false;
   };
   //! \}
   //! \endcond
@@ -664,6 +812,106 @@ public: /*constructors*/
 
 private: /*functions*/
   template< typename = void > static void sync_cb(::uv_fs_t*);
+  template< typename = void > static void group_cb(::uv_fs_t*);
+  template< typename = void > static void window_cb(::uv_timer_t*);
+
+  /* group commit: the requests accumulated in sync_group::pending are moved to sync_group::round and completed
+     by a single sync of the file, which is started as soon as the coalesced writes queued before are completed */
+  static int group_commit(file::uv_t *_uv_handle)
+  {
+    auto &properties = file::instance::from(_uv_handle)->properties();
+    auto sg = properties.sg;
+
+    sg->round.swap(sg->pending);
+
+    auto wq = properties.wq;
+    sg->barrier = wq ? wq->queued : 0;
+    if (wq and wq->completed < sg->barrier)
+    {
+      sg->waiting = true;
+      sg->resume = group_resume;
+      return 0;
+    }
+
+    return group_sync(_uv_handle);
+  }
+
+  static int group_sync(file::uv_t *_uv_handle)
+  {
+    auto sg = file::instance::from(_uv_handle)->properties().sg;
+
+    bool flush_all_metadata = false;
+    for (auto uv_req : sg->round)  flush_all_metadata |= instance::from(uv_req)->properties().flush_all_metadata;
+
+    ::uv_fs_req_cleanup(&sg->uv_req_struct);
+    sg->uv_req_struct.data = _uv_handle;
+
+    return executors::queue_fs(flush_all_metadata ? ::uv_fs_fsync : ::uv_fs_fdatasync, group_cb,
+        _uv_handle->loop, &sg->uv_req_struct,
+        _uv_handle->result
+    );
+  }
+
+  static void group_resume(file::uv_t *_uv_handle)
+  {
+    auto uv_ret = group_sync(_uv_handle);
+    if (uv_ret < 0)  group_complete(_uv_handle, uv_ret);
+  }
+
+  /* start a round for the request just having been put into sync_group::pending */
+  static int group_start(file::uv_t *_uv_handle)
+  {
+    auto sg = file::instance::from(_uv_handle)->properties().sg;
+
+    sg->busy = true;
+    int uv_ret = 0;
+    if (sg->window == 0)
+      uv_ret = group_commit(_uv_handle);
+    else
+    {
+      if (!sg->uv_timer)
+      {
+        sg->uv_timer = new ::uv_timer_t;
+        ::uv_timer_init(_uv_handle->loop, sg->uv_timer);
+        sg->uv_timer->data = _uv_handle;
+      }
+      uv_ret = ::uv_timer_start(sg->uv_timer, window_cb, sg->window, 0);
+    }
+
+    if (uv_ret < 0)
+    {
+      sg->pending.clear();
+      sg->round.clear();
+      sg->busy = false;
+    }
+    return uv_ret;
+  }
+
+  /* complete the current round with the `_result` and start the next one if there are pending requests */
+  static void group_complete(file::uv_t *_uv_handle, ssize_t _result)
+  {
+    auto sg = file::instance::from(_uv_handle)->properties().sg;
+
+    std::vector< uv_t* > round;
+    round.swap(sg->round);
+    for (auto uv_req : round)  uv_req->result = _result;
+
+    // the requests run while this round was in progress have already waited long enough, no commit window for them
+    sg->busy = false;
+    while (!sg->pending.empty())
+    {
+      sg->busy = true;
+      auto uv_ret = group_commit(_uv_handle);
+      if (uv_ret >= 0)  break;
+
+      for (auto uv_req : sg->round)  uv_req->result = uv_ret;  // fail the requests that cannot be started
+      round.insert(round.end(), sg->round.begin(), sg->round.end());
+      sg->round.clear();
+      sg->busy = false;
+    }
+
+    for (auto uv_req : round)  sync_cb(uv_req);
+  }
 
 public: /*interface*/
   on_request_t& on_request() const noexcept  { return instance::from(uv_req)->request_cb_storage.value(); }
@@ -679,6 +927,9 @@ public: /*interface*/
                  [`fdatasync()`](http://man7.org/linux/man-pages/man2/fdatasync.2.html).
 
       By default [`uv_fs_fdatasync()`](http://docs.libuv.org/en/v1.x/fs.html#c.uv_fs_fdatasync) libuv API function is used.
+
+      If `file::group_commit()` is enabled for the `_file`, the asynchronous request is completed by the sync shared with
+      the other sync requests pending on the file.
       \note If the request callback is empty (has not been set), the request runs _synchronously_. */
   int run(file &_file, bool _flush_all_metadata = false)
   {
@@ -702,18 +953,26 @@ public: /*interface*/
       file::instance::from(_file.uv_handle)->ref();
       instance_ptr->ref();
 
-      // instance_ptr->properties() = { static_cast< file::uv_t* >(_file) };
+      // instance_ptr->properties() = { static_cast< file::uv_t* >(_file), _flush_all_metadata };
       {
         auto &properties = instance_ptr->properties();
         properties.uv_handle = static_cast< file::uv_t* >(_file);
+        properties.flush_all_metadata = _flush_all_metadata;
       }
 
       uv_status(0);
-      auto uv_ret = uv_fs_sync_func_ptr(
-          static_cast< file::uv_t* >(_file)->loop, static_cast< uv_t* >(uv_req),
-          _file.fd(),
-          sync_cb
-      );
+      int uv_ret = 0;
+      auto sg = file::instance::from(_file.uv_handle)->properties().sg;
+      if (sg and sg->enabled)
+      {
+        sg->pending.push_back(static_cast< uv_t* >(uv_req));
+        if (!sg->busy)  uv_ret = group_start(static_cast< file::uv_t* >(_file));
+      }
+      else
+        uv_ret = executors::queue_fs(uv_fs_sync_func_ptr, sync_cb,
+            static_cast< file::uv_t* >(_file)->loop, static_cast< uv_t* >(uv_req),
+            _file.fd()
+        );
       if (uv_ret < 0)
       {
         uv_status(uv_ret);
@@ -745,6 +1004,25 @@ void fs::sync::sync_cb(::uv_fs_t *_uv_req)
   if (sync_cb)  sync_cb(sync(_uv_req));
 }
 
+template< typename >
+void fs::sync::group_cb(::uv_fs_t *_uv_req)
+{
+  auto uv_handle = static_cast< file::uv_t* >(_uv_req->data);
+  auto result = _uv_req->result;
+  ::uv_fs_req_cleanup(_uv_req);
+
+  group_complete(uv_handle, result);
+}
+
+template< typename >
+void fs::sync::window_cb(::uv_timer_t *_uv_timer)
+{
+  auto uv_handle = static_cast< file::uv_t* >(_uv_timer->data);
+
+  auto uv_ret = group_commit(uv_handle);
+  if (uv_ret < 0)  group_complete(uv_handle, uv_ret);
+}
+
 
 
 /*! \brief Truncate a file to a specified length. */
@@ -853,11 +1131,10 @@ public: /*interface*/
       }
 
       uv_status(0);
-      auto uv_ret = ::uv_fs_ftruncate(
+      auto uv_ret = executors::queue_fs(::uv_fs_ftruncate, truncate_cb,
           static_cast< file::uv_t* >(_file)->loop, static_cast< uv_t* >(uv_req),
           _file.fd(),
-          _offset,
-          truncate_cb
+          _offset
       );
       if (uv_ret < 0)
       {
@@ -898,6 +1175,7 @@ class fs::sendfile : public fs
   //! \cond
   friend class request::instance< sendfile >;
   friend class output;
+  friend class fs::copy;
   //! \endcond
 
 public: /*types*/
@@ -1025,11 +1303,10 @@ public: /*interface*/
       if (_out.type() == UV_FILE)  file::instance::from(_out.uv_handle)->properties().write_queue_size += _length;
 
       uv_status(0);
-      int uv_ret = ::uv_fs_sendfile(
+      int uv_ret = executors::queue_fs(::uv_fs_sendfile, sendfile_cb,
           static_cast< file::uv_t* >(_in)->loop, static_cast< uv_t* >(uv_req),
           out, _in.fd(),
-          _offset, _length,
-          sendfile_cb
+          _offset, _length
       );
       if (uv_ret < 0)
       {
@@ -1074,6 +1351,591 @@ void fs::sendfile::sendfile_cb(::uv_fs_t *_uv_req)
 
 
 
+/*! \brief Copy a range of a file to another file or an I/O endpoint.
+    \details Unlike `fs::sendfile`, the request transfers the whole range however many system calls it takes,
+    splitting it into chunks of `chunk_size()` bytes that are copied on the thread pool (or on the executor
+    assigned for the `executors::pool::FS` request class) concurrently, up to `concurrency()` chunks at a time.
+
+    When the destination is a file:
+    - the data is copied with [`copy_file_range()`](http://man7.org/linux/man-pages/man2/copy_file_range.2.html),
+      which lets the kernel (or the filesystem, e.g. with reflinks or server-side copy) move the data without
+      passing it through user space, or with `pread()`/`pwrite()` where `copy_file_range()` is not supported;
+    - if `sparse()` is set (the default), the holes in the source file are detected with `lseek(SEEK_DATA/SEEK_HOLE)`
+      and skipped, so that they are preserved in the destination file.
+
+    When the destination is a stream, the chunks are copied sequentially with
+    [`sendfile()`](http://man7.org/linux/man-pages/man2/sendfile.2.html), or with `pread()`/`write()` where
+    `sendfile()` is not supported.
+
+    The `on_progress()` callback is called on the loop thread each time a chunk has been completed. */
+class fs::copy : public fs
+{
+  //! \cond
+  friend class request::instance< copy >;
+  //! \endcond
+
+public: /*types*/
+  using on_request_t = std::function< void(copy _request) >;
+  /*!< \brief The function type of the callback called when the whole range has been copied or the request has failed. */
+  using on_progress_t = std::function< void(copy _request, uint64_t _copied, uint64_t _total) >;
+  /*!< \brief The function type of the callback called when a chunk has been copied.
+       \details `_copied` is the number of bytes of the range having been processed so far (including the skipped holes). */
+
+  /*! \brief The copying methods (can be or'ed). */
+  enum method : unsigned
+  {
+      COPY_FILE_RANGE = 1,  /*!< `copy_file_range()` */
+      SENDFILE = 2,         /*!< `sendfile()` */
+      BUFFERED = 4          /*!< reading and writing through an intermediate buffer */
+  };
+
+protected: /*types*/
+  //! \cond internals
+  //! \addtogroup doxy_group__internals
+  //! \{
+  struct job
+  {
+    uv_t *uv_req;
+    io::uv_t *uv_handle_out;
+    file::uv_t *uv_handle_in;
+    int out_fd, in_fd;
+    bool out_is_file;
+    bool sparse;
+    bool clear_holes = false;  // the skipped source holes should be cleared in the destination
+    int64_t out_offset, in_offset;
+    int64_t in_size = 0;  // the source file size, to tell a trailing hole from the end of file in sparse mode
+    uint64_t length;
+    uint64_t next = 0;  // the start of the next chunk to be scheduled, relative to in_offset
+    unsigned active = 0;
+    int error = 0;
+    bool started = false;
+    bool stopped = false;
+    std::atomic< bool > no_copy_file_range{ false };
+    std::atomic< bool > no_sendfile{ false };
+  };
+
+  struct chunk
+  {
+    ::uv_work_t uv_work;
+    job *jb;
+    uint64_t offset;  // relative to in_offset
+    uint64_t length;
+    uint64_t done = 0;
+    unsigned methods = 0;
+    int error = 0;
+    bool eof = false;
+  };
+
+  struct properties : fs::properties
+  {
+    on_progress_t progress_cb;
+    std::size_t chunk_size = 16*1024*1024;
+    unsigned concurrency = 4;
+    bool sparse = true;
+    uint64_t copied = 0;
+    uint64_t total = 0;
+    unsigned methods = 0;
+    job *jb = nullptr;
+  };
+  //! \}
+  //! \endcond
+
+private: /*types*/
+  using instance = request::instance< copy >;
+
+protected: /*constructors*/
+  //! \cond
+  explicit copy(uv_t *_uv_req) : fs(_uv_req)  {}
+  //! \endcond
+
+public: /*constructors*/
+  ~copy() = default;
+  copy()
+  {
+    uv_req = instance::create();
+    init< UV_FS_UNKNOWN >();  // there is no libuv counterpart for this request
+  }
+
+  copy(const copy&) = default;
+  copy& operator =(const copy&) = default;
+
+  copy(copy&&) noexcept = default;
+  copy& operator =(copy&&) noexcept = default;
+
+private: /*functions*/
+  template< typename = void > static void work_cb(::uv_work_t*);
+  template< typename = void > static void after_work_cb(::uv_work_t*, int);
+
+  /* copy the chunk synchronously, it is run on a thread pool thread */
+  static void copy_chunk(chunk &_c)
+  {
+#ifndef _WIN32
+    auto &jb = *_c.jb;
+    auto pos = jb.in_offset + static_cast< int64_t >(_c.offset);
+    const auto end = pos + static_cast< int64_t >(_c.length);
+    auto sparse = jb.sparse;
+    std::unique_ptr< char[] > buf;
+
+    auto track = [&](int64_t _to){ _c.done = static_cast< uint64_t >(_to - jb.in_offset) - _c.offset; };
+
+    while (pos < end)
+    {
+      auto seg_end = end;
+#ifdef SEEK_DATA
+      if (sparse and jb.out_is_file)
+      {
+        auto d = ::lseek64(jb.in_fd, pos, SEEK_DATA);
+        const bool tail = d < 0 and errno == ENXIO;  // no data from pos on: a trailing hole or the end of file
+        if (tail)  d = pos < jb.in_size ? jb.in_size : pos;
+        if (d < 0)
+          sparse = false;  // not supported by the filesystem
+        else
+        {
+          if (d > end)  d = end;
+          if (d > pos and jb.clear_holes)
+          {
+            _c.error = clear(jb, pos, d);
+            if (_c.error)  return;
+          }
+          if (d == end)  { track(end); break; }
+          if (tail)  // the source file is shorter than expected
+          {
+            track(d);
+            _c.eof = true;
+            return;
+          }
+          pos = d;
+          auto h = ::lseek64(jb.in_fd, pos, SEEK_HOLE);
+          if (h > pos and h < end)  seg_end = h;
+        }
+      }
+#endif
+      while (pos < seg_end)
+      {
+        const auto n = static_cast< std::size_t >(seg_end - pos);
+        ssize_t ret = -1;
+        bool buffered = true;
+
+        if (jb.out_is_file)
+        {
+#if defined(__linux__) && defined(__NR_copy_file_range)
+          if (!jb.no_copy_file_range.load(std::memory_order_relaxed))
+          {
+            ::loff_t in_off = pos, out_off = jb.out_offset + (pos - jb.in_offset);
+            ret = ::syscall(__NR_copy_file_range, jb.in_fd, &in_off, jb.out_fd, &out_off, n, 0u);
+            if (ret >= 0)
+            {
+              _c.methods |= COPY_FILE_RANGE;
+              buffered = false;
+            }
+            else if (errno == EINTR)
+              continue;
+            else if (errno == ENOSYS or errno == EXDEV or errno == EINVAL or errno == EOPNOTSUPP or errno == EBADF)
+              jb.no_copy_file_range.store(true, std::memory_order_relaxed);
+            else
+            {
+              _c.error = -errno;
+              return;
+            }
+          }
+#endif
+        }
+        else
+        {
+#ifdef __linux__
+          if (!jb.no_sendfile.load(std::memory_order_relaxed))
+          {
+            ::off_t off = pos;
+            ret = ::sendfile(jb.out_fd, jb.in_fd, &off, n);
+            if (ret >= 0)
+            {
+              _c.methods |= SENDFILE;
+              buffered = false;
+            }
+            else if (errno == EINTR)
+              continue;
+            else if (errno == EAGAIN or errno == EWOULDBLOCK)
+            {
+              wait_writable(jb.out_fd);
+              continue;
+            }
+            else if (errno == EINVAL or errno == ENOSYS)
+              jb.no_sendfile.store(true, std::memory_order_relaxed);
+            else
+            {
+              _c.error = -errno;
+              return;
+            }
+          }
+#endif
+        }
+
+        if (buffered)
+        {
+          if (!buf)  buf.reset(new char[BUFFER_SIZE]);
+          ret = ::pread(jb.in_fd, buf.get(), n < BUFFER_SIZE ? n : BUFFER_SIZE, pos);
+          if (ret < 0 and errno == EINTR)  continue;
+          if (ret < 0)
+          {
+            _c.error = -errno;
+            return;
+          }
+          if (ret > 0)  _c.methods |= BUFFERED;
+
+          for (ssize_t w = 0; w < ret; )
+          {
+            auto r = jb.out_is_file
+                ? ::pwrite(jb.out_fd, buf.get() + w, ret - w, jb.out_offset + (pos - jb.in_offset) + w)
+                : ::write(jb.out_fd, buf.get() + w, ret - w);
+            if (r < 0 and (errno == EAGAIN or errno == EWOULDBLOCK))  { wait_writable(jb.out_fd); continue; }
+            if (r < 0 and errno == EINTR)  continue;
+            if (r < 0)
+            {
+              _c.error = -errno;
+              return;
+            }
+            w += r;
+          }
+        }
+
+        if (ret == 0)  // the source file is shorter than expected
+        {
+          _c.eof = true;
+          return;
+        }
+        pos += ret;
+        track(pos);
+      }
+    }
+#else
+    _c.error = UV_ENOSYS;
+#endif
+  }
+
+#ifndef _WIN32
+  /* clear the destination range corresponding to the source range [_from, _to) skipped as a hole */
+  static int clear(job &_jb, int64_t _from, int64_t _to)
+  {
+    auto off = _jb.out_offset + (_from - _jb.in_offset);
+    auto len = _to - _from;
+#if defined(__linux__) && defined(FALLOC_FL_PUNCH_HOLE)
+    while (true)
+    {
+      if (::fallocate(_jb.out_fd, FALLOC_FL_PUNCH_HOLE|FALLOC_FL_KEEP_SIZE, off, len) == 0)  return 0;
+      if (errno == EINTR)  continue;
+      if (errno != EOPNOTSUPP and errno != ENOSYS)  return -errno;
+      break;  // not supported by the filesystem: write zeros
+    }
+#endif
+    std::unique_ptr< char[] > zeros(new char[BUFFER_SIZE]());
+    while (len > 0)
+    {
+      auto r = ::pwrite(_jb.out_fd, zeros.get(), len < static_cast< int64_t >(BUFFER_SIZE) ? static_cast< std::size_t >(len) : BUFFER_SIZE, off);
+      if (r < 0 and errno == EINTR)  continue;
+      if (r < 0)  return -errno;
+      off += r;
+      len -= r;
+    }
+    return 0;
+  }
+
+  static void wait_writable(int _fd)
+  {
+    ::pollfd pfd = { _fd, POLLOUT, 0 };
+    while (::poll(&pfd, 1, -1) < 0 and errno == EINTR);
+  }
+#endif
+
+  /* schedule as many chunks as allowed */
+  static int schedule(uv_t *_uv_req)
+  {
+    auto &properties = instance::from(_uv_req)->properties();
+    auto &jb = *properties.jb;
+    auto limit = jb.out_is_file ? greatest(properties.concurrency, 1u) : 1u;
+
+    while (jb.active < limit and (jb.next < jb.length or !jb.started) and !jb.error and !jb.stopped)
+    {
+      auto c = new chunk;
+      c->jb = &jb;
+      c->offset = jb.next;
+      c->length = jb.length - jb.next;
+      if (c->length > properties.chunk_size)  c->length = properties.chunk_size;
+      c->uv_work.data = c;
+
+      auto uv_ret = executors::route(executors::pool::FS, jb.uv_handle_in->loop,
+          [c](){ copy_chunk(*c); return 0; },
+          [c](int _status){ after_work_cb(&c->uv_work, _status); }
+      );
+      if (uv_ret == UV_ENOSYS)  uv_ret = ::uv_queue_work(jb.uv_handle_in->loop, &c->uv_work, work_cb, after_work_cb);
+      if (uv_ret < 0)
+      {
+        delete c;
+        if (jb.active == 0)  return uv_ret;
+        jb.error = uv_ret;  // fail when the running chunks have completed
+        break;
+      }
+
+      jb.next += c->length;
+      jb.started = true;
+      ++jb.active;
+    }
+
+    return 0;
+  }
+
+  /* if the trailing hole has not been written, extend the destination file to the proper size */
+  static int extend(job &_jb, uint64_t _copied)
+  {
+#ifndef _WIN32
+    if (_jb.out_is_file and _jb.sparse and _copied)
+    {
+      struct ::stat st;
+      auto size = _jb.out_offset + static_cast< int64_t >(_copied);
+      if (::fstat(_jb.out_fd, &st) < 0)  return -errno;
+      if (st.st_size < size and ::ftruncate(_jb.out_fd, size) < 0)  return -errno;
+    }
+#endif
+    return 0;
+  }
+
+  static void finish(uv_t *_uv_req)
+  {
+    auto instance_ptr = instance::from(_uv_req);
+    auto &properties = instance_ptr->properties();
+    auto jb = properties.jb;
+    properties.jb = nullptr;
+
+    if (!jb->error)  jb->error = extend(*jb, properties.copied);
+    instance_ptr->uv_error = jb->error ? jb->error : (jb->stopped and properties.copied < properties.total ? UV_ECANCELED : 0);
+
+    ref_guard< io::instance > unref_out(*io::instance::from(jb->uv_handle_out), adopt_ref);
+    ref_guard< file::instance > unref_in(*file::instance::from(jb->uv_handle_in), adopt_ref);
+    ref_guard< instance > unref_req(*instance_ptr, adopt_ref);
+    delete jb;
+
+    auto &copy_cb = instance_ptr->request_cb_storage.value();
+    if (copy_cb)  copy_cb(copy(_uv_req));
+  }
+
+  int start(io &_out, ::uv_file _out_fd, int64_t _out_offset, file &_in, int64_t _in_offset, uint64_t _length)
+  {
+    auto instance_ptr = instance::from(uv_req);
+    auto &properties = instance_ptr->properties();
+    if (properties.jb)  return uv_status(UV_EBUSY);
+
+    if (_in_offset < 0)
+    {
+#ifdef _WIN32
+      _in_offset = _telli64(_in.fd());
+#else
+      _in_offset = lseek64(_in.fd(), 0, SEEK_CUR);
+#endif
+    }
+#ifndef _WIN32
+    if (_length == 0)
+    {
+      struct ::stat st;
+      if (::fstat(_in.fd(), &st) < 0)  return uv_status(-errno);
+      if (st.st_size > _in_offset)  _length = static_cast< uint64_t >(st.st_size - _in_offset);
+    }
+#endif
+
+    auto jb = new job;
+    jb->uv_req = static_cast< uv_t* >(uv_req);
+    jb->uv_handle_out = static_cast< io::uv_t* >(_out);
+    jb->uv_handle_in = static_cast< file::uv_t* >(_in);
+    jb->out_fd = _out_fd;
+    jb->in_fd = _in.fd();
+    jb->out_is_file = _out.type() == UV_FILE;
+    jb->sparse = properties.sparse;
+    jb->out_offset = _out_offset;
+    jb->in_offset = _in_offset;
+    jb->length = _length;
+
+#ifndef _WIN32
+    if (jb->out_is_file and jb->sparse and _length)
+    {
+      struct ::stat st;
+      if (::fstat(jb->in_fd, &st) < 0)
+      {
+        delete jb;
+        return uv_status(-errno);
+      }
+      jb->in_size = st.st_size;
+
+      // the holes are skipped, so the old data of the destination range should not remain there:
+      // when copying up to or beyond the end of the destination, just cut it off, otherwise clear the holes one by one
+      if (::fstat(_out_fd, &st) < 0)
+      {
+        delete jb;
+        return uv_status(-errno);
+      }
+      if (st.st_size <= _out_offset + static_cast< int64_t >(_length))
+      {
+        if (st.st_size > _out_offset and ::ftruncate(_out_fd, _out_offset) < 0)
+        {
+          delete jb;
+          return uv_status(-errno);
+        }
+      }
+      else
+        jb->clear_holes = true;
+    }
+#endif
+
+    static_cast< uv_t* >(uv_req)->loop = static_cast< file::uv_t* >(_in)->loop;
+    properties.copied = 0;
+    properties.total = _length;
+    properties.methods = 0;
+
+    if (!instance_ptr->request_cb_storage.value())
+    {
+      chunk c;
+      c.jb = jb;
+      c.offset = 0;
+      c.length = _length;
+      copy_chunk(c);
+      properties.copied = c.done;
+      properties.methods = c.methods;
+      if (c.eof)  properties.total = c.done;
+      auto uv_ret = c.error ? c.error : extend(*jb, c.done);
+      delete jb;
+      return uv_status(uv_ret);
+    }
+
+    io::instance::from(_out.uv_handle)->ref();
+    file::instance::from(_in.uv_handle)->ref();
+    instance_ptr->ref();
+    properties.jb = jb;
+
+    uv_status(0);
+    auto uv_ret = schedule(static_cast< uv_t* >(uv_req));
+    if (uv_ret < 0)
+    {
+      uv_status(uv_ret);
+      properties.jb = nullptr;
+      delete jb;
+      io::instance::from(_out.uv_handle)->unref();
+      file::instance::from(_in.uv_handle)->unref();
+      instance_ptr->unref();
+    }
+
+    return uv_ret;
+  }
+
+public: /*interface*/
+  on_request_t& on_request() const noexcept  { return instance::from(uv_req)->request_cb_storage.value(); }
+  /*! \brief Set the callback reporting the progress. */
+  on_progress_t& on_progress() const noexcept  { return instance::from(uv_req)->properties().progress_cb; }
+
+  /*! \brief The size of the chunks the range is split into (default is 16 MiB). */
+  std::size_t chunk_size() const noexcept  { return instance::from(uv_req)->properties().chunk_size; }
+  /*! \brief Set the size of the chunks. */
+  void chunk_size(std::size_t _value) noexcept  { instance::from(uv_req)->properties().chunk_size = greatest(_value, std::size_t(1)); }
+
+  /*! \brief The maximum number of the chunks being copied at the same time (default is 4).
+      \details The chunks are always copied sequentially when the destination is not a file. */
+  unsigned concurrency() const noexcept  { return instance::from(uv_req)->properties().concurrency; }
+  /*! \brief Set the maximum number of the chunks being copied at the same time. */
+  void concurrency(unsigned _value) noexcept  { instance::from(uv_req)->properties().concurrency = greatest(_value, 1u); }
+
+  /*! \brief Check if the holes of the source file are preserved. */
+  bool sparse() const noexcept  { return instance::from(uv_req)->properties().sparse; }
+  /*! \brief Set if the holes of the source file should be preserved (default is `true`).
+      \details The holes are found with `lseek(SEEK_DATA/SEEK_HOLE)` on the source file descriptor, which moves its file
+      position shared with the other users of the descriptor. The destination range is cleared where the source has
+      holes: the destination file is truncated to the start of the range if the range reaches its end, otherwise
+      the holes are punched (or filled with zeros where the filesystem does not support punching). */
+  void sparse(bool _value) noexcept  { instance::from(uv_req)->properties().sparse = _value; }
+
+  /*! \brief The number of bytes of the range having been processed so far (including the skipped holes). */
+  uint64_t copied() const noexcept  { return instance::from(uv_req)->properties().copied; }
+  /*! \brief The total length of the range being copied. */
+  uint64_t total() const noexcept  { return instance::from(uv_req)->properties().total; }
+  /*! \brief The copying methods having actually been used (the or'ed `method` values). */
+  unsigned methods() const noexcept  { return instance::from(uv_req)->properties().methods; }
+
+  /*! \brief Stop the request. The chunks that are being copied are completed, the others are not started,
+      and the request callback is called with `UV_ECANCELED` status. */
+  void stop() const noexcept
+  {
+    auto jb = instance::from(uv_req)->properties().jb;
+    if (jb)  jb->stopped = true;
+  }
+
+  /*! \brief Run the request. Copy `_length` bytes from the `_in` file starting from `_in_offset` to the `_out` file
+      starting from `_out_offset`.
+      \details `_length` of **0** means up to the end of the `_in` file. The `_in_offset` value of < 0 means using
+      of the current file position.
+      \note If the request callback is empty (has not been set), the request runs _synchronously_ (on the calling thread
+      and with no progress reporting). */
+  int run(file &_out, int64_t _out_offset, file &_in, int64_t _in_offset, uint64_t _length = 0)
+  {
+    if (_out_offset < 0)
+    {
+#ifdef _WIN32
+      _out_offset = _telli64(_out.fd());
+#else
+      _out_offset = lseek64(_out.fd(), 0, SEEK_CUR);
+#endif
+    }
+    return start(_out, _out.fd(), _out_offset, _in, _in_offset, _length);
+  }
+
+  /*! \brief Run the request. Copy `_length` bytes from the `_in` file starting from `_offset` to the `_out` endpoint.
+      \details If `_out` is a file, the data is written at its current position.
+      \sa `fs::copy::run(file&, int64_t, file&, int64_t, uint64_t)` */
+  int run(io &_out, file &_in, int64_t _offset, uint64_t _length = 0)
+  {
+    if (_out.type() == UV_FILE)  return run(static_cast< file& >(_out), -1, _in, _offset, _length);
+
+    ::uv_file out = sendfile::fd::try_convert(_out.fileno());
+    if (out == -1)  return uv_status(UV_EBADF);
+    return start(_out, out, 0, _in, _offset, _length);
+  }
+
+public: /*conversion operators*/
+  explicit operator const uv_t*() const noexcept  { return static_cast< const uv_t* >(uv_req); }
+  explicit operator       uv_t*()       noexcept  { return static_cast<       uv_t* >(uv_req); }
+
+private: /*constants*/
+  enum : std::size_t  { BUFFER_SIZE = 1024*1024 };
+};
+
+template< typename >
+void fs::copy::work_cb(::uv_work_t *_uv_work)
+{
+  auto c = static_cast< chunk* >(_uv_work->data);
+  copy_chunk(*c);
+}
+
+template< typename >
+void fs::copy::after_work_cb(::uv_work_t *_uv_work, int _status)
+{
+  auto c = static_cast< chunk* >(_uv_work->data);
+  auto jb = c->jb;
+  auto uv_req = jb->uv_req;
+  auto &properties = instance::from(uv_req)->properties();
+
+  --jb->active;
+  properties.copied += c->done;
+  properties.methods |= c->methods;
+  if (!jb->error)  jb->error = _status < 0 ? _status : c->error;
+  if (c->eof)
+  {
+    jb->next = jb->length;  // don't schedule the chunks beyond the end of the source file
+    if (properties.total > c->offset + c->done)  properties.total = c->offset + c->done;
+  }
+  delete c;
+
+  if (properties.progress_cb and !jb->error)  properties.progress_cb(copy(uv_req), properties.copied, properties.total);
+
+  if (schedule(uv_req) < 0 and !jb->error)  jb->error = UV_ENOMEM;
+  if (jb->active == 0)  finish(uv_req);
+}
+
+
+
 /*! \brief Get information about a file. */
 class fs::stat : public fs
 {
@@ -1184,10 +2046,9 @@ public: /*interface*/
       }
 
       uv_status(0);
-      auto uv_ret = uv_fs_stat_func_ptr(
+      auto uv_ret = executors::queue_fs(uv_fs_stat_func_ptr, stat_cb,
           static_cast< uv::loop::uv_t* >(_loop), static_cast< uv_t* >(uv_req),
-          _path,
-          stat_cb
+          _path
       );
       if (uv_ret < 0)
       {
@@ -1231,10 +2092,9 @@ public: /*interface*/
       }
 
       uv_status(0);
-      auto uv_ret = ::uv_fs_fstat(
+      auto uv_ret = executors::queue_fs(::uv_fs_fstat, stat_cb,
           static_cast< file::uv_t* >(_file)->loop, static_cast< uv_t* >(uv_req),
-          _file.fd(),
-          stat_cb
+          _file.fd()
       );
       if (uv_ret < 0)
       {
@@ -1378,10 +2238,9 @@ public: /*interface*/
       }
 
       uv_status(0);
-      auto uv_ret = ::uv_fs_chmod(
+      auto uv_ret = executors::queue_fs(::uv_fs_chmod, chmod_cb,
           static_cast< uv::loop::uv_t* >(_loop), static_cast< uv_t* >(uv_req),
-          _path, _mode,
-          chmod_cb
+          _path, _mode
       );
       if (uv_ret < 0)
       {
@@ -1425,10 +2284,9 @@ public: /*interface*/
       }
 
       uv_status(0);
-      auto uv_ret = ::uv_fs_fchmod(
+      auto uv_ret = executors::queue_fs(::uv_fs_fchmod, chmod_cb,
           static_cast< file::uv_t* >(_file)->loop, static_cast< uv_t* >(uv_req),
-          _file.fd(), _mode,
-          chmod_cb
+          _file.fd(), _mode
       );
       if (uv_ret < 0)
       {
@@ -1571,10 +2429,9 @@ public: /*interface*/
       }
 
       uv_status(0);
-      auto uv_ret = ::uv_fs_chown(
+      auto uv_ret = executors::queue_fs(::uv_fs_chown, chown_cb,
           static_cast< uv::loop::uv_t* >(_loop), static_cast< uv_t* >(uv_req),
-          _path, _uid, _gid,
-          chown_cb
+          _path, _uid, _gid
       );
       if (uv_ret < 0)
       {
@@ -1618,10 +2475,9 @@ public: /*interface*/
       }
 
       uv_status(0);
-      auto uv_ret = ::uv_fs_fchown(
+      auto uv_ret = executors::queue_fs(::uv_fs_fchown, chown_cb,
           static_cast< file::uv_t* >(_file)->loop, static_cast< uv_t* >(uv_req),
-          _file.fd(), _uid, _gid,
-          chown_cb
+          _file.fd(), _uid, _gid
       );
       if (uv_ret < 0)
       {
@@ -1765,10 +2621,9 @@ public: /*interface*/
       }
 
       uv_status(0);
-      auto uv_ret = ::uv_fs_utime(
+      auto uv_ret = executors::queue_fs(::uv_fs_utime, utime_cb,
           static_cast< uv::loop::uv_t* >(_loop), static_cast< uv_t* >(uv_req),
-          _path, _atime, _mtime,
-          utime_cb
+          _path, _atime, _mtime
       );
       if (uv_ret < 0)
       {
@@ -1812,10 +2667,9 @@ public: /*interface*/
       }
 
       uv_status(0);
-      auto uv_ret = ::uv_fs_futime(
+      auto uv_ret = executors::queue_fs(::uv_fs_futime, utime_cb,
           static_cast< file::uv_t* >(_file)->loop, static_cast< uv_t* >(uv_req),
-          _file.fd(), _atime, _mtime,
-          utime_cb
+          _file.fd(), _atime, _mtime
       );
       if (uv_ret < 0)
       {
@@ -1926,10 +2780,9 @@ public: /*interface*/
       instance_ptr->ref();
 
       uv_status(0);
-      auto uv_ret = ::uv_fs_unlink(
+      auto uv_ret = executors::queue_fs(::uv_fs_unlink, unlink_cb,
           static_cast< uv::loop::uv_t* >(_loop), static_cast< uv_t* >(uv_req),
-          _path,
-          unlink_cb
+          _path
       );
       if (uv_ret < 0)
       {
@@ -2026,10 +2879,9 @@ public: /*interface*/
       instance_ptr->ref();
 
       uv_status(0);
-      auto uv_ret = ::uv_fs_mkdir(
+      auto uv_ret = executors::queue_fs(::uv_fs_mkdir, mkdir_cb,
           static_cast< uv::loop::uv_t* >(_loop), static_cast< uv_t* >(uv_req),
-          _path, _mode,
-          mkdir_cb
+          _path, _mode
       );
       if (uv_ret < 0)
       {
@@ -2126,10 +2978,9 @@ public: /*interface*/
       instance_ptr->ref();
 
       uv_status(0);
-      auto uv_ret = ::uv_fs_mkdtemp(
+      auto uv_ret = executors::queue_fs(::uv_fs_mkdtemp, mkdtemp_cb,
           static_cast< uv::loop::uv_t* >(_loop), static_cast< uv_t* >(uv_req),
-          _template,
-          mkdtemp_cb
+          _template
       );
       if (uv_ret < 0)
       {
@@ -2226,10 +3077,9 @@ public: /*interface*/
       instance_ptr->ref();
 
       uv_status(0);
-      auto uv_ret = ::uv_fs_rmdir(
+      auto uv_ret = executors::queue_fs(::uv_fs_rmdir, rmdir_cb,
           static_cast< uv::loop::uv_t* >(_loop), static_cast< uv_t* >(uv_req),
-          _path,
-          rmdir_cb
+          _path
       );
       if (uv_ret < 0)
       {
@@ -2336,10 +3186,9 @@ public: /*interface*/
       instance_ptr->ref();
 
       uv_status(0);
-      auto uv_ret = ::uv_fs_scandir(
+      auto uv_ret = executors::queue_fs(::uv_fs_scandir, scandir_cb,
           static_cast< uv::loop::uv_t* >(_loop), static_cast< uv_t* >(uv_req),
-          _path, 0,
-          scandir_cb
+          _path, 0
       );
       if (uv_ret < 0)
       {
@@ -2370,6 +3219,390 @@ void fs::scandir::scandir_cb(::uv_fs_t *_uv_req)
 
 
 
+/*! \brief Read a directory incrementally, in batches of entries of bounded size.
+    \details Unlike `fs::scandir`, which collects all the entries of a directory before completing, this request reads
+    the directory by chunks of `buffer_size()` bytes, with the memory used being limited by that value irrespective of
+    the directory size. Each completion of the request delivers a batch of entries, with the file type and inode number
+    of each entry as reported by the filesystem; the next batch is read by calling `next()`, so the entries of
+    the current batch can be processed before (or while, with another request) reading the next ones.
+
+    The directory is kept open between the batches and is closed automatically when its end is reached, the request
+    fails, `close()` is called, or the request object is destroyed. The end of the directory is indicated by an empty
+    batch.
+    \note The `.` and `..` entries are skipped. The type of an entry can be `UV_DIRENT_UNKNOWN` if the filesystem
+    does not provide it, in which case `fs::stat` should be used.
+    \sa Linux: [`getdents64()`](http://man7.org/linux/man-pages/man2/getdents.2.html). */
+class fs::readdir : public fs
+{
+  //! \cond
+  friend class request::instance< readdir >;
+  //! \endcond
+
+public: /*types*/
+  using on_request_t = std::function< void(readdir _request) >;
+  /*!< \brief The function type of the callback called when a batch of directory entries has been read. */
+
+  /*! \brief The directory entry. */
+  struct entry
+  {
+    const char *name;         /*!< the entry name; valid until the next batch is read */
+    uint64_t ino;             /*!< the inode number */
+    ::uv_dirent_type_t type;  /*!< the entry type */
+  };
+
+  /*! \brief The iterator over the entries of the current batch. */
+  class const_iterator
+  {
+    //! \cond
+    friend class readdir;
+    //! \endcond
+
+  public: /*types*/
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = entry;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const entry*;
+    using reference = const entry&;
+
+  private: /*data*/
+    const char *pos = nullptr, *end = nullptr;
+    entry e = { nullptr, 0, UV_DIRENT_UNKNOWN };
+
+  private: /*constructors*/
+    const_iterator(const char *_pos, const char *_end) noexcept : pos(_pos), end(_end)  { settle(); }
+
+  public: /*constructors*/
+    const_iterator() = default;
+
+  private: /*functions*/
+    /* the record layout of `struct linux_dirent64`: d_ino, d_off, d_reclen, d_type, d_name */
+    enum : std::size_t  { D_INO = 0, D_RECLEN = 16, D_TYPE = 18, D_NAME = 19 };
+
+    static unsigned short reclen(const char *_p) noexcept
+    {
+      unsigned short ret;
+      std::memcpy(&ret, _p + D_RECLEN, sizeof(ret));
+      return ret;
+    }
+
+    /* stop at the current record unless it is the `.` or `..` entry */
+    void settle() noexcept
+    {
+      for (; pos < end; pos += reclen(pos))
+      {
+        auto name = pos + D_NAME;
+        if (name[0] == '.' and (name[1] == '\0' or (name[1] == '.' and name[2] == '\0')))  continue;
+
+        e.name = name;
+        std::memcpy(&e.ino, pos + D_INO, sizeof(e.ino));
+        e.type = dirent_type(static_cast< unsigned char >(pos[D_TYPE]));
+        return;
+      }
+      pos = end;
+    }
+
+    static ::uv_dirent_type_t dirent_type(unsigned char _d_type) noexcept
+    {
+      switch (_d_type)
+      {
+#ifdef DT_REG
+      case DT_REG:   return UV_DIRENT_FILE;
+      case DT_DIR:   return UV_DIRENT_DIR;
+      case DT_LNK:   return UV_DIRENT_LINK;
+      case DT_FIFO:  return UV_DIRENT_FIFO;
+      case DT_SOCK:  return UV_DIRENT_SOCKET;
+      case DT_CHR:   return UV_DIRENT_CHAR;
+      case DT_BLK:   return UV_DIRENT_BLOCK;
+#endif
+      default:       return UV_DIRENT_UNKNOWN;
+      }
+    }
+
+  public: /*interface*/
+    reference operator *() const noexcept  { return e; }
+    pointer operator ->() const noexcept  { return &e; }
+
+    const_iterator& operator ++() noexcept
+    {
+      pos += reclen(pos);
+      settle();
+      return *this;
+    }
+    const_iterator operator ++(int) noexcept
+    {
+      auto ret = *this;
+      ++*this;
+      return ret;
+    }
+
+    bool operator ==(const const_iterator &_that) const noexcept  { return pos == _that.pos; }
+    bool operator !=(const const_iterator &_that) const noexcept  { return pos != _that.pos; }
+  };
+
+protected: /*types*/
+  //! \cond internals
+  //! \addtogroup doxy_group__internals
+  //! \{
+  struct stream
+  {
+    ::uv_work_t uv_work;
+    uv_t *uv_req = nullptr;
+    std::string path;
+    int fd = -1;
+    std::unique_ptr< char[] > buf;
+    std::size_t size = 0;   // the buffer size
+    std::size_t len = 0;    // the length of the data of the current batch
+    std::size_t count = 0;  // the number of the entries in the current batch
+    int error = 0;
+    bool busy = false;
+    bool eof = false;
+
+    ~stream()  { close(); }
+
+    void close() noexcept
+    {
+#ifndef _WIN32
+      if (fd >= 0)  ::close(fd);
+#endif
+      fd = -1;
+    }
+  };
+
+  struct properties : fs::properties
+  {
+    std::size_t buffer_size = 32*1024;
+    stream *st = nullptr;
+
+    ~properties()  { delete st; }
+  };
+  //! \}
+  //! \endcond
+
+private: /*types*/
+  using instance = request::instance< readdir >;
+
+protected: /*constructors*/
+  //! \cond
+  explicit readdir(uv_t *_uv_req) : fs(_uv_req)  {}
+  //! \endcond
+
+public: /*constructors*/
+  ~readdir() = default;
+  readdir()
+  {
+    uv_req = instance::create();
+    init< UV_FS_UNKNOWN >();  // there is no libuv counterpart for this request
+  }
+
+  readdir(const readdir&) = default;
+  readdir& operator =(const readdir&) = default;
+
+  readdir(readdir&&) noexcept = default;
+  readdir& operator =(readdir&&) noexcept = default;
+
+private: /*functions*/
+  template< typename = void > static void work_cb(::uv_work_t*);
+  template< typename = void > static void after_work_cb(::uv_work_t*, int);
+
+  /* open the directory if needed and read the next batch, it is run on a thread pool thread */
+  static void read_batch(stream &_st)
+  {
+    _st.len = _st.count = 0;
+#if defined(__linux__) && defined(__NR_getdents64)
+    if (_st.fd < 0)
+    {
+      _st.fd = ::open(_st.path.c_str(), O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+      if (_st.fd < 0)
+      {
+        _st.error = -errno;
+        return;
+      }
+    }
+
+    // a chunk may hold only the "." and ".." entries, which are skipped: read on, so that an empty batch means the end
+    while (_st.count == 0)
+    {
+      long ret;
+      while ((ret = ::syscall(__NR_getdents64, _st.fd, _st.buf.get(), _st.size)) < 0 and errno == EINTR);
+      if (ret < 0)
+      {
+        _st.error = -errno;
+        _st.close();
+        return;
+      }
+      if (ret == 0)
+      {
+        _st.len = 0;
+        _st.eof = true;
+        _st.close();
+        return;
+      }
+
+      _st.len = static_cast< std::size_t >(ret);
+      for (const_iterator it(_st.buf.get(), _st.buf.get() + _st.len), end(_st.buf.get() + _st.len, _st.buf.get() + _st.len); it != end; ++it)
+        ++_st.count;
+    }
+#else
+    _st.error = UV_ENOSYS;
+#endif
+  }
+
+  int start()
+  {
+    auto instance_ptr = instance::from(uv_req);
+    auto &st = *instance_ptr->properties().st;
+
+    if (st.busy)  return uv_status(UV_EBUSY);
+    if (st.eof or st.error)
+    {
+      st.len = st.count = 0;
+      return uv_status(st.error);
+    }
+
+    if (!instance_ptr->request_cb_storage.value())
+    {
+      read_batch(st);
+      return uv_status(st.error ? st.error : static_cast< int >(st.count));
+    }
+
+    instance_ptr->ref();
+    st.busy = true;
+    st.uv_req = static_cast< uv_t* >(uv_req);
+    st.uv_work.data = &st;
+
+    uv_status(0);
+    auto st_ptr = &st;
+    auto uv_ret = executors::route(executors::pool::FS, static_cast< uv_t* >(uv_req)->loop,
+        [st_ptr](){ read_batch(*st_ptr); return 0; },
+        [st_ptr](int _status){ after_work_cb(&st_ptr->uv_work, _status); }
+    );
+    if (uv_ret == UV_ENOSYS)  uv_ret = ::uv_queue_work(static_cast< uv_t* >(uv_req)->loop, &st.uv_work, work_cb, after_work_cb);
+    if (uv_ret < 0)
+    {
+      uv_status(uv_ret);
+      st.busy = false;
+      instance_ptr->unref();
+    }
+
+    return uv_ret;
+  }
+
+public: /*interface*/
+  on_request_t& on_request() const noexcept  { return instance::from(uv_req)->request_cb_storage.value(); }
+
+  /*! \brief The path of the directory being read. */
+  const char* path() const noexcept
+  {
+    auto st = instance::from(uv_req)->properties().st;
+    return st ? st->path.c_str() : nullptr;
+  }
+
+  /*! \brief The size of the buffer the batches of entries are read into (default is 32 KiB).
+      \details The setting takes effect on the next `run()` call. */
+  std::size_t buffer_size() const noexcept  { return instance::from(uv_req)->properties().buffer_size; }
+  /*! \brief Set the size of the buffer the batches of entries are read into. */
+  void buffer_size(std::size_t _value) noexcept  { instance::from(uv_req)->properties().buffer_size = greatest(_value, std::size_t(1024)); }
+
+  /*! \brief The number of the entries in the current batch. */
+  std::size_t count() const noexcept
+  {
+    auto st = instance::from(uv_req)->properties().st;
+    return st ? st->count : 0;
+  }
+  /*! \brief Check if the end of the directory has been reached. */
+  bool eof() const noexcept
+  {
+    auto st = instance::from(uv_req)->properties().st;
+    return st and st->eof;
+  }
+
+  /*! \brief The beginning of the current batch of entries. */
+  const_iterator begin() const noexcept
+  {
+    auto st = instance::from(uv_req)->properties().st;
+    return st and !st->busy ? const_iterator(st->buf.get(), st->buf.get() + st->len) : const_iterator();
+  }
+  /*! \brief The end of the current batch of entries. */
+  const_iterator end() const noexcept
+  {
+    auto st = instance::from(uv_req)->properties().st;
+    return st and !st->busy ? const_iterator(st->buf.get() + st->len, st->buf.get() + st->len) : const_iterator();
+  }
+
+  /*! \brief Run the request. Open the directory specified by `_path` and read the first batch of its entries.
+      \note If the request callback is empty (has not been set), the request runs _synchronously_.
+      In this case the function returns the number of the entries in the batch or relevant libuv error code. */
+  int run(uv::loop &_loop, const char *_path)
+  {
+    auto &properties = instance::from(uv_req)->properties();
+    if (properties.st and properties.st->busy)  return uv_status(UV_EBUSY);
+
+    delete properties.st;
+    properties.st = new stream;
+    properties.st->path = _path;
+    properties.st->size = properties.buffer_size;
+    properties.st->buf.reset(new char[properties.buffer_size]);
+
+    static_cast< uv_t* >(uv_req)->loop = static_cast< uv::loop::uv_t* >(_loop);
+    return start();
+  }
+
+  /*! \brief Read the next batch of entries of the directory opened by `run()`.
+      \details The entries of the current batch become invalid. At the end of the directory the request completes
+      with an empty batch.
+      \note If the request callback is empty (has not been set), the request runs _synchronously_.
+      In this case the function returns the number of the entries in the batch or relevant libuv error code. */
+  int next()
+  {
+    if (!instance::from(uv_req)->properties().st)  return uv_status(UV_EINVAL);
+    return start();
+  }
+
+  /*! \brief Close the directory before its end has been reached. */
+  int close() noexcept
+  {
+    auto st = instance::from(uv_req)->properties().st;
+    if (!st)  return 0;
+    if (st->busy)  return uv_status(UV_EBUSY);
+    st->close();
+    st->eof = true;
+    st->len = st->count = 0;
+    return 0;
+  }
+
+public: /*conversion operators*/
+  explicit operator const uv_t*() const noexcept  { return static_cast< const uv_t* >(uv_req); }
+  explicit operator       uv_t*()       noexcept  { return static_cast<       uv_t* >(uv_req); }
+};
+
+template< typename >
+void fs::readdir::work_cb(::uv_work_t *_uv_work)
+{
+  read_batch(*static_cast< stream* >(_uv_work->data));
+}
+
+template< typename >
+void fs::readdir::after_work_cb(::uv_work_t *_uv_work, int _status)
+{
+  auto &st = *static_cast< stream* >(_uv_work->data);
+  auto instance_ptr = instance::from(st.uv_req);
+
+  st.busy = false;
+  if (_status < 0 and !st.error)
+  {
+    st.error = _status;
+    st.close();
+  }
+  instance_ptr->uv_error = st.error;
+
+  ref_guard< instance > unref_req(*instance_ptr, adopt_ref);
+
+  auto &readdir_cb = instance_ptr->request_cb_storage.value();
+  if (readdir_cb)  readdir_cb(readdir(st.uv_req));
+}
+
+
+
 /*! \brief Change the name or location of a file. */
 class fs::rename : public fs
 {
@@ -2454,10 +3687,9 @@ public: /*interface*/
       instance_ptr->ref();
 
       uv_status(0);
-      auto uv_ret = ::uv_fs_rename(
+      auto uv_ret = executors::queue_fs(::uv_fs_rename, rename_cb,
           static_cast< uv::loop::uv_t* >(_loop), static_cast< uv_t* >(uv_req),
-          _path, _new_path,
-          rename_cb
+          _path, _new_path
       );
       if (uv_ret < 0)
       {
@@ -2554,10 +3786,9 @@ public: /*interface*/
       instance_ptr->ref();
 
       uv_status(0);
-      auto uv_ret = ::uv_fs_access(
+      auto uv_ret = executors::queue_fs(::uv_fs_access, access_cb,
           static_cast< uv::loop::uv_t* >(_loop), static_cast< uv_t* >(uv_req),
-          _path, _mode,
-          access_cb
+          _path, _mode
       );
       if (uv_ret < 0)
       {
@@ -2690,15 +3921,13 @@ public: /*interface*/
 
       uv_status(0);
       int uv_ret = 0;
-      if (_symlink)  uv_ret = ::uv_fs_symlink(
+      if (_symlink)  uv_ret = executors::queue_fs(::uv_fs_symlink, link_cb,
           static_cast< uv::loop::uv_t* >(_loop), static_cast< uv_t* >(uv_req),
-          _path, _link_path, _symlink_flags,
-          link_cb
+          _path, _link_path, _symlink_flags
       );
-      else  uv_ret = ::uv_fs_link(
+      else  uv_ret = executors::queue_fs(::uv_fs_link, link_cb,
           static_cast< uv::loop::uv_t* >(_loop), static_cast< uv_t* >(uv_req),
-          _path, _link_path,
-          link_cb
+          _path, _link_path
       );
       if (uv_ret < 0)
       {
@@ -2798,10 +4027,9 @@ public: /*interface*/
       instance_ptr->ref();
 
       uv_status(0);
-      auto uv_ret = ::uv_fs_readlink(
+      auto uv_ret = executors::queue_fs(::uv_fs_readlink, readlink_cb,
           static_cast< uv::loop::uv_t* >(_loop), static_cast< uv_t* >(uv_req),
-          _path,
-          readlink_cb
+          _path
       );
       if (uv_ret < 0)
       {
@@ -2901,10 +4129,9 @@ public: /*interface*/
       instance_ptr->ref();
 
       uv_status(0);
-      auto uv_ret = ::uv_fs_realpath(
+      auto uv_ret = executors::queue_fs(::uv_fs_realpath, realpath_cb,
           static_cast< uv::loop::uv_t* >(_loop), static_cast< uv_t* >(uv_req),
-          _path,
-          realpath_cb
+          _path
       );
       if (uv_ret < 0)
       {
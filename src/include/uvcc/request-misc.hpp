@@ -4,12 +4,21 @@
 
 #include "uvcc/utility.hpp"
 #include "uvcc/request-base.hpp"
+#include "uvcc/executor.hpp"
 
 #include <uv.h>
 
+#include <condition_variable>  // condition_variable
+#include <cstddef>      // size_t
+#include <deque>        // deque
+#include <exception>    // exception_ptr current_exception() rethrow_exception()
 #include <functional>   // function bind placeholders::
 #include <future>       // shared_future packaged_task
-#include <type_traits>  // enable_if is_convertible
+#include <mutex>        // mutex unique_lock lock_guard
+#include <new>          // placement new
+#include <stdexcept>    // runtime_error
+#include <type_traits>  // enable_if is_convertible aligned_storage add_lvalue_reference_t
+#include <utility>      // move()
 
 
 namespace uv
@@ -46,6 +55,7 @@ protected: /*types*/
   {
     std::packaged_task< _Result_() > task;
     std::shared_future< _Result_ > result;
+    executor::task executor_task;
   };
   //! \}
   //! \endcond
@@ -75,6 +85,8 @@ public: /*constructors*/
 private: /*functions*/
   template< typename = void > static void work_cb(::uv_work_t*);
   template< typename = void > static void after_work_cb(::uv_work_t*, int);
+  template< typename = void > static void executor_work_cb(executor::task*);
+  template< typename = void > static void executor_after_work_cb(executor::task*, int);
 
 public: /*interface*/
   on_request_t& on_request() const noexcept  { return instance::from(uv_req)->request_cb_storage.value(); }
@@ -90,6 +102,9 @@ public: /*interface*/
       \details The given `_Task_` function is called with specified `_args` applied and is executed
       on the one of the threads from the thread pool. Once it is completed, `on_request` callback will be called
       on the `_loop` thread.
+
+      If an executor is assigned for the `executors::pool::CPU` request class, the task is queued to that executor
+      with `executor::priority::NORMAL` priority instead of the libuv thread pool (see `uv::executors`).
       \note All arguments are copied (or moved) to the `_task` function object. For passing arguments by reference
       (when parameters are used as output ones), wrap them with `std::ref()` or use raw pointers.
       \sa libuv API documentation: [`uv_queue_work()`](http://docs.libuv.org/en/v1.x/threadpool.html#c.uv_queue_work). */
@@ -110,7 +125,18 @@ public: /*interface*/
     }
 
     uv_status(0);
-    auto uv_ret = ::uv_queue_work(
+    int uv_ret = UV_ENOSYS;
+    if (executors::is_assigned(executors::pool::CPU))
+    {
+      properties.executor_task.on_work() = executor_work_cb<>;
+      properties.executor_task.on_after_work() = executor_after_work_cb<>;
+      properties.executor_task.data() = uv_req;
+      static_cast< uv_t* >(uv_req)->loop = static_cast< uv::loop::uv_t* >(_loop);
+      unqueued(static_cast< uv_t* >(uv_req));
+
+      uv_ret = executors::submit(executors::pool::CPU, static_cast< uv::loop::uv_t* >(_loop), properties.executor_task);
+    }
+    if (uv_ret == UV_ENOSYS)  uv_ret = ::uv_queue_work(
         static_cast< uv::loop::uv_t* >(_loop), static_cast< uv_t* >(uv_req),
         work_cb<>, after_work_cb<>
     );
@@ -123,6 +149,58 @@ public: /*interface*/
     return uv_ret;
   }
 
+  /*! \brief Run the request on the given `uv::executor` instead of the libuv thread pool.
+      \details The `_Task_` function is queued to the `_executor` with the priority `_priority`.
+      Once it is completed, `on_request` callback will be called on the `_loop` thread, just like for
+      the work queued to the libuv thread pool.
+      \note `request::cancel()` returns `UV_EBUSY` for the request run on an executor, use `executor::cancel()`
+      with `executor_task()` instead.
+      \sa `work::run()` */
+  template< class _Task_, typename... _Args_,
+      typename = std::enable_if_t< std::is_convertible< _Task_, on_work_t< _Args_&&... > >::value >
+  >
+  int run(uv::loop &_loop, const executor &_executor, executor::priority _priority, _Task_&& _task, _Args_&&... _args)
+  {
+    auto instance_ptr = instance::from(uv_req);
+
+    instance_ptr->ref();
+
+    auto &properties = instance_ptr->properties();
+    {
+      using task_t = decltype(properties.task);
+      properties.task = task_t{ std::bind(std::forward< _Task_ >(_task), std::forward< _Args_ >(_args)...) };
+      properties.result = properties.task.get_future().share();
+    }
+    properties.executor_task.on_work() = executor_work_cb<>;
+    properties.executor_task.on_after_work() = executor_after_work_cb<>;
+    properties.executor_task.data() = uv_req;
+
+    static_cast< uv_t* >(uv_req)->loop = static_cast< uv::loop::uv_t* >(_loop);
+    unqueued(static_cast< uv_t* >(uv_req));
+
+    uv_status(0);
+    auto uv_ret = _executor.submit(_loop, properties.executor_task, _priority);
+    if (uv_ret < 0)
+    {
+      uv_status(uv_ret);
+      instance_ptr->unref();
+    }
+
+    return uv_ret;
+  }
+  /*! \brief Idem with `executor::priority::NORMAL` priority. */
+  template< class _Task_, typename... _Args_,
+      typename = std::enable_if_t< std::is_convertible< _Task_, on_work_t< _Args_&&... > >::value >
+  >
+  int run(uv::loop &_loop, const executor &_executor, _Task_&& _task, _Args_&&... _args)
+  {
+    return run(_loop, _executor, executor::priority::NORMAL, std::forward< _Task_ >(_task), std::forward< _Args_ >(_args)...);
+  }
+
+  /*! \brief The executor task node used when the request is run on a `uv::executor`.
+      \details It provides the queue waiting time and the run time of the last run (see `executor::task`). */
+  executor::task& executor_task() const noexcept  { return instance::from(uv_req)->properties().executor_task; }
+
 public: /*conversion operators*/
   explicit operator const uv_t*() const noexcept  { return static_cast< const uv_t* >(uv_req); }
   explicit operator       uv_t*()       noexcept  { return static_cast<       uv_t* >(uv_req); }
@@ -149,6 +227,614 @@ void work< _Result_ >::after_work_cb(::uv_work_t *_uv_req, int _status)
   if (after_work_cb)  after_work_cb(work(_uv_req));
 }
 
+template< typename _Result_ >
+template< typename >
+void work< _Result_ >::executor_work_cb(executor::task *_task)
+{
+  work_cb(static_cast< ::uv_work_t* >(_task->data()));
+}
+
+template< typename _Result_ >
+template< typename >
+void work< _Result_ >::executor_after_work_cb(executor::task *_task, int _status)
+{
+  after_work_cb(static_cast< ::uv_work_t* >(_task->data()), _status);
+}
+
+
+
+//! \cond internals
+//! \addtogroup doxy_group__internals
+//! \{
+
+/* in-place storage for the result of the lean_work task */
+template< typename _T_ >
+struct lean_work_result
+{
+  typename std::aligned_storage< sizeof(_T_), alignof(_T_) >::type storage;
+  bool has_value = false;
+
+  ~lean_work_result()  { reset(); }
+
+  void reset() noexcept
+  {
+    if (!has_value)  return;
+    value().~_T_();
+    has_value = false;
+  }
+  template< class _F_ > void emplace_from(_F_ &_f)
+  {
+    new(static_cast< void* >(&storage)) _T_(_f());
+    has_value = true;
+  }
+  _T_& value() noexcept  { return *reinterpret_cast< _T_* >(&storage); }
+};
+
+template<>
+struct lean_work_result< void >
+{
+  void reset() noexcept  {}
+  template< class _F_ > void emplace_from(_F_ &_f)  { _f(); }
+  void value() noexcept  {}
+};
+
+//! \}
+//! \endcond
+
+
+/*! \ingroup doxy_group__request
+    \brief Allocation-free work scheduling request type.
+    \details Unlike `uv::work`, which wraps the task into a `std::packaged_task` with a `std::shared_future` shared
+    state for the result, this request stores the task (together with its bound arguments) and the task result
+    in place inside the request instance, and calls the completion callback directly. So, once the request object
+    has been created, running it again and again (e.g. from its own callback) does not allocate anything and
+    involves no synchronization apart from the libuv thread pool queue itself.
+
+    The size of the task function object with its bound arguments is limited by `MAX_TASK_SIZE`; the result type
+    is limited in size as well, so that both of them fit into the request instance. The limits are checked at
+    compile time. The previous task object and result are destroyed when the request is run again, and the task
+    object is destroyed before the completion callback is called.
+    \sa libuv API documentation: [Thread pool work scheduling](http://docs.libuv.org/en/v1.x/threadpool.html#thread-pool-work-scheduling). */
+template< typename _Result_ = void >
+class lean_work : public request
+{
+  //! \cond
+  friend class request::instance< lean_work >;
+  //! \endcond
+
+public: /*types*/
+  using uv_t = ::uv_work_t;
+  using on_request_t = std::function< void(lean_work _request) >;
+  /*!< \brief The function type of the callback called after the work on the threadpool has been completed.
+       \details This callback is called _on the loop thread_. */
+  template< typename... _Args_ >
+  using on_work_t = std::function< _Result_(_Args_&&... _args) >;
+  /*!< \brief The function type of the task which is scheduled to be run on the thread pool.
+       \details It is used only for checking the task signature; the task itself is never converted to `std::function`. */
+
+  constexpr static const std::size_t MAX_TASK_SIZE = 64;
+  /*!< \brief The maximum size of the task function object with all its bound arguments. */
+
+protected: /*types*/
+  //! \cond internals
+  //! \addtogroup doxy_group__internals
+  //! \{
+  struct properties : request::properties
+  {
+    void (*invoke)(properties&) = nullptr;
+    void (*destroy)(void*) = nullptr;
+    std::exception_ptr exception;
+    lean_work_result< _Result_ > result;
+    typename std::aligned_storage< MAX_TASK_SIZE, MAX_PROPERTY_ALIGN >::type task;
+
+    ~properties()  { reset_task(); }
+
+    void reset_task() noexcept
+    {
+      if (!destroy)  return;
+      destroy(&task);
+      destroy = nullptr;
+      invoke = nullptr;
+    }
+  };
+  //! \}
+  //! \endcond
+
+private: /*types*/
+  using instance = request::instance< lean_work >;
+
+protected: /*constructors*/
+  //! \cond
+  explicit lean_work(uv_t *_uv_req) : request(reinterpret_cast< request::uv_t* >(_uv_req))  {}
+  //! \endcond
+
+public: /*constructors*/
+  ~lean_work() = default;
+  lean_work()
+  {
+    uv_req = instance::create();
+    static_cast< uv_t* >(uv_req)->type = UV_WORK;
+  }
+
+  lean_work(const lean_work&) = default;
+  lean_work& operator =(const lean_work&) = default;
+
+  lean_work(lean_work&&) noexcept = default;
+  lean_work& operator =(lean_work&&) noexcept = default;
+
+private: /*functions*/
+  template< typename = void > static void work_cb(::uv_work_t*);
+  template< typename = void > static void after_work_cb(::uv_work_t*, int);
+
+  template< class _Task_ > static void invoke_task(properties &_properties)
+  {
+    try
+    {
+      _properties.result.emplace_from(*reinterpret_cast< _Task_* >(&_properties.task));
+    }
+    catch (...)
+    {
+      _properties.exception = std::current_exception();
+    }
+  }
+  template< class _Task_ > static void destroy_task(void *_task) noexcept  { static_cast< _Task_* >(_task)->~_Task_(); }
+
+public: /*interface*/
+  on_request_t& on_request() const noexcept  { return instance::from(uv_req)->request_cb_storage.value(); }
+
+  /*! \brief The libuv loop that started this `lean_work` request and where completion will be reported. */
+  uv::loop loop() const noexcept  { return uv::loop(static_cast< uv_t* >(uv_req)->loop); }
+
+  /*! \brief Check if the task has thrown an exception. */
+  bool has_exception() const noexcept  { return instance::from(uv_req)->properties().exception != nullptr; }
+
+  /*! \brief Get the result of the completed work, or rethrow the exception escaped from the task.
+      \details The result is kept in the request until it is run again or destroyed. If the task has not been run
+      (the request has been cancelled or has failed to start, i.e. `uv_status() < 0`), `std::runtime_error` is thrown.
+      Calling this function before the work has been completed is undefined behavior. */
+  std::add_lvalue_reference_t< _Result_ > result() const
+  {
+    auto &properties = instance::from(uv_req)->properties();
+    if (properties.exception)  std::rethrow_exception(properties.exception);
+    if (uv_status() < 0)  throw std::runtime_error(::uv_strerror(uv_status()));
+    return properties.result.value();
+  }
+
+  /*! \brief Run the request. Queue the `_Task_` to the thread pool.
+      \details The given `_Task_` function is called with specified `_args` applied and is executed
+      on the one of the threads from the thread pool. Once it is completed, `on_request` callback will be called
+      on the `_loop` thread.
+
+      If an executor is assigned for the `executors::pool::CPU` request class, the task is routed to that executor
+      instead of the libuv thread pool (see `uv::executors`); the routing itself takes an allocation, and the request
+      cannot be cancelled then (`request::cancel()` returns `UV_EBUSY`).
+      \note All arguments are copied (or moved) into the request instance. For passing arguments by reference
+      wrap them with `std::ref()` or use raw pointers.
+      \sa libuv API documentation: [`uv_queue_work()`](http://docs.libuv.org/en/v1.x/threadpool.html#c.uv_queue_work). */
+  template< class _Task_, typename... _Args_,
+      typename = std::enable_if_t< std::is_convertible< _Task_, on_work_t< _Args_&&... > >::value >
+  >
+  int run(uv::loop &_loop, _Task_&& _task, _Args_&&... _args)
+  {
+    using task_t = decltype(std::bind(std::forward< _Task_ >(_task), std::forward< _Args_ >(_args)...));
+    static_assert(sizeof(task_t) <= MAX_TASK_SIZE, "the task with its bound arguments does not fit into the request");
+    static_assert(alignof(task_t) <= MAX_PROPERTY_ALIGN, "the task with its bound arguments has too strict alignment");
+
+    auto instance_ptr = instance::from(uv_req);
+
+    instance_ptr->ref();
+
+    auto &properties = instance_ptr->properties();
+    properties.reset_task();
+    properties.result.reset();
+    properties.exception = nullptr;
+
+    new(static_cast< void* >(&properties.task)) task_t(std::bind(std::forward< _Task_ >(_task), std::forward< _Args_ >(_args)...));
+    properties.destroy = destroy_task< task_t >;
+    properties.invoke = invoke_task< task_t >;
+
+    uv_status(0);
+    static_cast< uv_t* >(uv_req)->loop = static_cast< uv::loop::uv_t* >(_loop);
+    auto uv_work = static_cast< uv_t* >(uv_req);
+    unqueued(uv_work);
+    auto uv_ret = executors::route(executors::pool::CPU, static_cast< uv::loop::uv_t* >(_loop),
+        [uv_work](){ work_cb<>(uv_work); return 0; },
+        [uv_work](int _status){ after_work_cb<>(uv_work, _status); }
+    );
+    if (uv_ret == UV_ENOSYS)  uv_ret = ::uv_queue_work(
+        static_cast< uv::loop::uv_t* >(_loop), static_cast< uv_t* >(uv_req),
+        work_cb<>, after_work_cb<>
+    );
+    if (uv_ret < 0)
+    {
+      uv_status(uv_ret);
+      properties.reset_task();
+      instance_ptr->unref();
+    }
+
+    return uv_ret;
+  }
+
+public: /*conversion operators*/
+  explicit operator const uv_t*() const noexcept  { return static_cast< const uv_t* >(uv_req); }
+  explicit operator       uv_t*()       noexcept  { return static_cast<       uv_t* >(uv_req); }
+};
+
+template< typename _Result_ >
+template< typename >
+void lean_work< _Result_ >::work_cb(::uv_work_t *_uv_req)
+{
+  auto &properties = instance::from(_uv_req)->properties();
+  if (properties.invoke)  properties.invoke(properties);
+}
+
+template< typename _Result_ >
+template< typename >
+void lean_work< _Result_ >::after_work_cb(::uv_work_t *_uv_req, int _status)
+{
+  auto instance_ptr = instance::from(_uv_req);
+  instance_ptr->uv_error = _status;
+  instance_ptr->properties().reset_task();
+
+  ref_guard< instance > unref_req(*instance_ptr, adopt_ref);
+
+  auto &after_work_cb = instance_ptr->request_cb_storage.value();
+  if (after_work_cb)  after_work_cb(lean_work(_uv_req));
+}
+
+
+
+/*! \ingroup doxy_group__request
+    \brief Work scheduling request type that streams partial results from the task back to the loop.
+    \details The task run on the thread pool gets a `producer` object, and each item passed to `producer::emit()`
+    is delivered to the `on_item` callback on the loop thread, in the order of emitting. When the task returns and
+    all its items have been delivered, the `on_request` callback is called.
+
+    The items are buffered between the task and the loop. When the number of buffered items reaches the request
+    `capacity()` (not counting the ones already taken by the loop for delivery), `producer::emit()` blocks until
+    the loop takes them, so a slow consumer makes the task wait instead of accumulating an unbounded backlog. The consumer can also suspend the delivery with `pause()`
+    (e.g. while the output stream write queue is too large) and continue it with `resume()`.
+    `stop()` drops the buffered items and makes all the further `producer::emit()` calls fail.
+
+    An exception escaped from the task is passed to the loop thread and can be rethrown with `result()` from
+    the `on_request` callback; the items emitted before it are delivered anyway.
+
+    The items are delivered with a `uv_async_t` handle, which is created on every `run()` and closed on completion.
+    \note `pause()`, `resume()`, and `stop()` should be called on the loop thread. */
+template< typename _Item_ >
+class streaming_work : public request
+{
+  //! \cond
+  friend class request::instance< streaming_work >;
+  //! \endcond
+
+public: /*types*/
+  using uv_t = ::uv_work_t;
+  class producer;
+
+  using on_request_t = std::function< void(streaming_work _request) >;
+  /*!< \brief The function type of the callback called on the loop thread after the task has been completed and
+       all the emitted items have been delivered. */
+  using on_item_t = std::function< void(streaming_work _request, _Item_ &_item) >;
+  /*!< \brief The function type of the callback called on the loop thread for each emitted item.
+       \details The item can be moved from. */
+  template< typename... _Args_ >
+  using on_work_t = std::function< void(producer &_producer, _Args_&&... _args) >;
+  /*!< \brief The function type of the task which is scheduled to be run on the thread pool. */
+
+protected: /*types*/
+  //! \cond internals
+  //! \addtogroup doxy_group__internals
+  //! \{
+  struct channel
+  {
+    ::uv_async_t uv_async;
+    ::uv_work_t *uv_req;
+    std::mutex lock;
+    std::condition_variable cv;
+    std::deque< _Item_ > items;
+    std::deque< _Item_ > batch;
+    std::size_t capacity;
+    bool stopped = false;
+    bool paused = false;
+    bool finished = false;
+    bool delivering = false;
+    std::function< void(producer&) > task;
+    std::exception_ptr exception;
+  };
+
+  struct properties : request::properties
+  {
+    on_item_t item_cb;
+    std::size_t capacity = 64;
+    channel *chan = nullptr;
+    std::exception_ptr exception;
+  };
+  //! \}
+  //! \endcond
+
+private: /*types*/
+  using instance = request::instance< streaming_work >;
+
+public: /*types*/
+  /*! \brief The object that the task uses for emitting items. */
+  class producer
+  {
+    //! \cond
+    friend class streaming_work;
+    //! \endcond
+
+  private: /*data*/
+    channel &chan;
+
+  private: /*constructors*/
+    explicit producer(channel &_chan) noexcept : chan(_chan)  {}
+
+  public: /*constructors*/
+    producer(const producer&) = delete;
+    producer& operator =(const producer&) = delete;
+
+    producer(producer&&) = delete;
+    producer& operator =(producer&&) = delete;
+
+  public: /*interface*/
+    /*! \brief Pass the item to the loop.
+        \details Blocks while the buffer is full. Returns `false` if the request has been stopped
+        and the item has been dropped. */
+    bool emit(_Item_ _item)
+    {
+      bool notify;
+      {
+        std::unique_lock< std::mutex > lk(chan.lock);
+        chan.cv.wait(lk, [this](){ return chan.stopped or chan.items.size() < chan.capacity; });
+        if (chan.stopped)  return false;
+
+        notify = chan.items.empty();  // otherwise the loop has already been notified and has not taken the items yet
+        chan.items.push_back(std::move(_item));
+      }
+      if (notify)  ::uv_async_send(&chan.uv_async);
+      return true;
+    }
+
+    /*! \brief Check if the request has been stopped by the consumer. */
+    bool stopped() const
+    {
+      std::lock_guard< std::mutex > lk(chan.lock);
+      return chan.stopped;
+    }
+  };
+
+protected: /*constructors*/
+  //! \cond
+  explicit streaming_work(uv_t *_uv_req) : request(reinterpret_cast< request::uv_t* >(_uv_req))  {}
+  //! \endcond
+
+public: /*constructors*/
+  ~streaming_work() = default;
+  streaming_work()
+  {
+    uv_req = instance::create();
+    static_cast< uv_t* >(uv_req)->type = UV_WORK;
+  }
+
+  streaming_work(const streaming_work&) = default;
+  streaming_work& operator =(const streaming_work&) = default;
+
+  streaming_work(streaming_work&&) noexcept = default;
+  streaming_work& operator =(streaming_work&&) noexcept = default;
+
+private: /*functions*/
+  template< typename = void > static void work_cb(::uv_work_t*);
+  template< typename = void > static void after_work_cb(::uv_work_t*, int);
+  template< typename = void > static void async_cb(::uv_async_t*);
+
+  static void deliver(channel *_chan)
+  {
+    if (_chan->delivering)  return;  // called from an item callback: the outer call checks the state on return
+    _chan->delivering = true;
+
+    auto instance_ptr = instance::from(_chan->uv_req);
+    auto &properties = instance_ptr->properties();
+
+    while (!_chan->paused and !_chan->stopped)
+    {
+      if (_chan->batch.empty())
+      {
+        {
+          std::lock_guard< std::mutex > lk(_chan->lock);
+          _chan->batch.swap(_chan->items);
+        }
+        _chan->cv.notify_one();
+        if (_chan->batch.empty())  break;
+      }
+
+      _Item_ item(std::move(_chan->batch.front()));
+      _chan->batch.pop_front();
+      if (properties.item_cb)  properties.item_cb(streaming_work(_chan->uv_req), item);
+    }
+
+    _chan->delivering = false;
+    if (_chan->finished and properties.chan == _chan and (_chan->stopped or (_chan->batch.empty() and _chan->items.empty())))
+      complete(_chan);
+  }
+
+  static void complete(channel *_chan)
+  {
+    auto instance_ptr = instance::from(_chan->uv_req);
+    instance_ptr->properties().chan = nullptr;
+    instance_ptr->properties().exception = std::move(_chan->exception);
+
+    ::uv_close(reinterpret_cast< ::uv_handle_t* >(&_chan->uv_async), [](::uv_handle_t *_h){ delete static_cast< channel* >(_h->data); });
+
+    ref_guard< instance > unref_req(*instance_ptr, adopt_ref);
+
+    auto &request_cb = instance_ptr->request_cb_storage.value();
+    if (request_cb)  request_cb(streaming_work(_chan->uv_req));
+  }
+
+public: /*interface*/
+  on_request_t& on_request() const noexcept  { return instance::from(uv_req)->request_cb_storage.value(); }
+  /*! \brief Set the callback receiving the emitted items. */
+  on_item_t& on_item() const noexcept  { return instance::from(uv_req)->properties().item_cb; }
+
+  /*! \brief The libuv loop that started this `streaming_work` request and where the items are delivered. */
+  uv::loop loop() const noexcept  { return uv::loop(static_cast< uv_t* >(uv_req)->loop); }
+
+  /*! \brief Check if the task has thrown an exception. */
+  bool has_exception() const noexcept  { return instance::from(uv_req)->properties().exception != nullptr; }
+  /*! \brief Rethrow the exception escaped from the task, if any.
+      \details The exception is kept in the request until it is run again or destroyed. Calling this function before
+      the `on_request` callback is undefined behavior. */
+  void result() const
+  {
+    auto &properties = instance::from(uv_req)->properties();
+    if (properties.exception)  std::rethrow_exception(properties.exception);
+  }
+
+  /*! \brief The maximum number of items buffered before `producer::emit()` blocks. */
+  std::size_t capacity() const noexcept  { return instance::from(uv_req)->properties().capacity; }
+  /*! \brief Set the maximum number of buffered items. It takes effect on the next `run()`. */
+  void capacity(std::size_t _value) const noexcept  { instance::from(uv_req)->properties().capacity = _value ? _value : 1; }
+
+  /*! \brief Suspend the delivery of the items. */
+  void pause() const noexcept
+  {
+    auto chan = instance::from(uv_req)->properties().chan;
+    if (chan)  chan->paused = true;
+  }
+  /*! \brief Continue the delivery of the items.
+      \details The buffered items are delivered immediately from within this function. */
+  void resume() const
+  {
+    auto chan = instance::from(uv_req)->properties().chan;
+    if (!chan or !chan->paused)  return;
+    chan->paused = false;
+    deliver(chan);
+  }
+  /*! \brief Check if the delivery of the items is suspended. */
+  bool is_paused() const noexcept
+  {
+    auto chan = instance::from(uv_req)->properties().chan;
+    return chan and chan->paused;
+  }
+
+  /*! \brief Stop the delivery of the items: drop the buffered items and make all the further `producer::emit()`
+      calls fail. The `on_request` callback is still called when the task returns. */
+  void stop() const
+  {
+    auto chan = instance::from(uv_req)->properties().chan;
+    if (!chan or chan->stopped)  return;
+    {
+      std::lock_guard< std::mutex > lk(chan->lock);
+      chan->stopped = true;
+      chan->items.clear();
+    }
+    chan->batch.clear();
+    chan->cv.notify_all();
+    if (chan->finished)  deliver(chan);
+  }
+
+  /*! \brief Run the request. Queue the `_Task_` to the thread pool.
+      \details The `_Task_` function is called with a `producer&` argument followed by the specified `_args`.
+      Returns `UV_EBUSY` if the request is still running.
+
+      If an executor is assigned for the `executors::pool::CPU` request class, the task is routed to that executor
+      instead of the libuv thread pool (see `uv::executors`). The task occupies an executor thread while it is
+      blocked in `producer::emit()`.
+      \note All arguments are copied (or moved) to the `_task` function object. */
+  template< class _Task_, typename... _Args_,
+      typename = std::enable_if_t< std::is_convertible< _Task_, on_work_t< _Args_&&... > >::value >
+  >
+  int run(uv::loop &_loop, _Task_&& _task, _Args_&&... _args)
+  {
+    auto instance_ptr = instance::from(uv_req);
+    auto &properties = instance_ptr->properties();
+
+    if (properties.chan)  return uv_status(UV_EBUSY);
+
+    properties.exception = nullptr;
+
+    auto chan = new channel;
+    chan->uv_req = static_cast< uv_t* >(uv_req);
+    chan->uv_async.data = chan;
+    chan->capacity = properties.capacity;
+    chan->task = std::bind(std::forward< _Task_ >(_task), std::placeholders::_1, std::forward< _Args_ >(_args)...);
+
+    auto uv_ret = ::uv_async_init(static_cast< uv::loop::uv_t* >(_loop), &chan->uv_async, async_cb<>);
+    if (uv_ret < 0)
+    {
+      delete chan;
+      return uv_status(uv_ret);
+    }
+
+    instance_ptr->ref();
+    properties.chan = chan;
+
+    uv_status(0);
+    static_cast< uv_t* >(uv_req)->loop = static_cast< uv::loop::uv_t* >(_loop);
+    auto uv_work = static_cast< uv_t* >(uv_req);
+    unqueued(uv_work);
+    uv_ret = executors::route(executors::pool::CPU, static_cast< uv::loop::uv_t* >(_loop),
+        [uv_work](){ work_cb<>(uv_work); return 0; },
+        [uv_work](int _status){ after_work_cb<>(uv_work, _status); }
+    );
+    if (uv_ret == UV_ENOSYS)  uv_ret = ::uv_queue_work(
+        static_cast< uv::loop::uv_t* >(_loop), static_cast< uv_t* >(uv_req),
+        work_cb<>, after_work_cb<>
+    );
+    if (uv_ret < 0)
+    {
+      uv_status(uv_ret);
+      properties.chan = nullptr;
+      ::uv_close(reinterpret_cast< ::uv_handle_t* >(&chan->uv_async), [](::uv_handle_t *_h){ delete static_cast< channel* >(_h->data); });
+      instance_ptr->unref();
+    }
+
+    return uv_ret;
+  }
+
+public: /*conversion operators*/
+  explicit operator const uv_t*() const noexcept  { return static_cast< const uv_t* >(uv_req); }
+  explicit operator       uv_t*()       noexcept  { return static_cast<       uv_t* >(uv_req); }
+};
+
+template< typename _Item_ >
+template< typename >
+void streaming_work< _Item_ >::work_cb(::uv_work_t *_uv_req)
+{
+  auto chan = instance::from(_uv_req)->properties().chan;
+  producer p(*chan);
+  try
+  {
+    chan->task(p);
+  }
+  catch (...)
+  {
+    chan->exception = std::current_exception();
+  }
+}
+
+template< typename _Item_ >
+template< typename >
+void streaming_work< _Item_ >::after_work_cb(::uv_work_t *_uv_req, int _status)
+{
+  auto instance_ptr = instance::from(_uv_req);
+  instance_ptr->uv_error = _status;
+
+  auto chan = instance_ptr->properties().chan;
+  chan->task = nullptr;
+  chan->finished = true;
+  deliver(chan);
+}
+
+template< typename _Item_ >
+template< typename >
+void streaming_work< _Item_ >::async_cb(::uv_async_t *_uv_async)
+{
+  auto chan = static_cast< channel* >(_uv_async->data);
+  if (!chan->finished)  deliver(chan);  // after the task has been finished the delivery is driven by after_work_cb() and resume()
+}
+
 
 }
 
@@ -10,8 +10,19 @@
 
 #include <uv.h>
 
+#include <cstddef>      // size_t
 #include <functional>   // function
 #include <type_traits>  // enable_if_t
+#include <vector>       // vector
+
+#ifdef __linux__
+#include <sys/socket.h> // sendmmsg() mmsghdr MSG_DONTWAIT
+#include <sys/uio.h>    // iovec
+#include <unistd.h>     // dup() close()
+#include <cerrno>       // errno EAGAIN EWOULDBLOCK EINTR ENOBUFS
+#include <cstdint>      // uint16_t
+#include <cstring>      // memcpy()
+#endif
 
 
 namespace uv
@@ -71,6 +82,144 @@ public: /*constructors*/
 private: /*functions*/
   template< typename = void > static void udp_send_cb(::uv_udp_send_t*, int);
 
+  static std::size_t length(const uv_t *_uv_req) noexcept
+  {
+    auto uv_buf = instance::from(const_cast< uv_t* >(_uv_req))->properties().uv_buf;
+    std::size_t len = 0;
+    for (std::size_t i = 0, n = buffer::instance::from(uv_buf)->buf_count; i < n; ++i)  len += uv_buf[i].len;
+    return len;
+  }
+
+  /* pass the request to libuv */
+  static int submit(uv_t *_uv_req, udp::uv_t *_uv_handle, bool _connected)
+  {
+    auto &properties = instance::from(_uv_req)->properties();
+    return ::uv_udp_send(
+        _uv_req, _uv_handle,
+        properties.uv_buf, buffer::instance::from(properties.uv_buf)->buf_count,
+#if (UV_VERSION_MAJOR >= 1) && (UV_VERSION_MINOR >= 27)
+        _connected ? nullptr : reinterpret_cast< const ::sockaddr* >(&properties.peer),  // the handle connected with uv_udp_connect() lets the kernel use the cached route
+#else
+        reinterpret_cast< const ::sockaddr* >(&properties.peer),
+#endif
+        udp_send_cb
+    );
+  }
+
+  /* complete the request that has not been passed to libuv */
+  static void drop(uv_t *_uv_req, udp::uv_t *_uv_handle, int _status)
+  {
+    _uv_req->handle = _uv_handle;
+    udp_send_cb(_uv_req, _status);
+  }
+
+  /* apply the egress limits and pass the request to libuv or hold it back */
+  static int send(uv_t *_uv_req, udp::uv_t *_uv_handle, bool _connected)
+  {
+    auto eg = udp::instance::from(_uv_handle)->properties().egress;
+    if (!eg or (eg->max_bytes == 0 and eg->max_count == 0))
+      return eg and !eg->staged.empty() ? stage(eg, _uv_req, _connected) : submit(_uv_req, _uv_handle, _connected);
+
+    auto len = length(_uv_req);
+    auto over = [eg, _uv_handle, len]() -> bool
+    {
+      return
+          (eg->max_count and _uv_handle->send_queue_count + eg->staged.size() + 1 > eg->max_count)
+        or
+          (eg->max_bytes and _uv_handle->send_queue_size + eg->staged_bytes + len > eg->max_bytes);
+    };
+
+    switch (eg->policy)
+    {
+    case udp::egress_policy::DROP_NEWEST:
+        if (over())
+        {
+          ++eg->dropped_count;
+          eg->dropped_bytes += len;
+          return UV_ENOBUFS;
+        }
+        break;
+    case udp::egress_policy::DROP_OLDEST:
+        while (over() and !eg->staged.empty())
+        {
+          auto oldest = eg->staged.front().first;
+          eg->staged.pop_front();
+          auto oldest_len = length(oldest);
+          eg->staged_bytes -= oldest_len;
+          ++eg->dropped_count;
+          eg->dropped_bytes += oldest_len;
+          drop(oldest, _uv_handle, UV_ECANCELED);
+        }
+        if (over())  // everything queued has already been passed to libuv
+        {
+          ++eg->dropped_count;
+          eg->dropped_bytes += len;
+          return UV_ENOBUFS;
+        }
+        if (!eg->staged.empty() or _uv_handle->send_queue_count >= udp::egress_control::WINDOW)
+          return stage(eg, _uv_req, _connected);
+        break;
+    case udp::egress_policy::PAUSE_RECEIVE:
+        if (over() and !eg->paused and eg->receiver)
+        {
+          eg->paused = true;
+          io(static_cast< io::uv_t* >(eg->receiver)).read_pause(true);
+        }
+        break;
+    }
+
+    return submit(_uv_req, _uv_handle, _connected);
+  }
+
+  static int stage(udp::egress_control *_eg, uv_t *_uv_req, bool _connected)
+  {
+    _eg->staged.emplace_back(_uv_req, _connected);
+    _eg->staged_bytes += length(_uv_req);
+    return 0;
+  }
+
+  /* called after a request has been completed by libuv */
+  static void egress_drain(udp::uv_t *_uv_handle)
+  {
+    auto eg = udp::instance::from(_uv_handle)->properties().egress;
+    if (!eg)  return;
+
+    while (!eg->staged.empty() and _uv_handle->send_queue_count < udp::egress_control::WINDOW)
+    {
+      auto next = eg->staged.front();
+      eg->staged.pop_front();
+      eg->staged_bytes -= length(next.first);
+
+      auto uv_ret = submit(next.first, _uv_handle, next.second);
+      if (uv_ret < 0)  drop(next.first, _uv_handle, uv_ret);
+    }
+
+    if (eg->paused)
+    {
+      const bool below =
+          (eg->max_count == 0 or 2*(_uv_handle->send_queue_count + eg->staged.size()) <= eg->max_count)
+        and
+          (eg->max_bytes == 0 or 2*(_uv_handle->send_queue_size + eg->staged_bytes) <= eg->max_bytes);
+      if (below)
+      {
+        eg->paused = false;
+        io(static_cast< io::uv_t* >(eg->receiver)).read_resume(true);
+      }
+    }
+  }
+
+  /* called when libuv has cancelled the requests of the closing handle: the held back ones are never passed to it */
+  static void egress_cancel(udp::uv_t *_uv_handle)
+  {
+    auto eg = udp::instance::from(_uv_handle)->properties().egress;
+    if (!eg or eg->staged.empty())  return;
+
+    decltype(eg->staged) staged;
+    staged.swap(eg->staged);
+    eg->staged_bytes = 0;
+    for (auto &next : staged)  drop(next.first, _uv_handle, UV_ECANCELED);
+  }
+
 public: /*interface*/
   on_request_t& on_request() const noexcept  { return instance::from(uv_req)->request_cb_storage.value(); }
 
@@ -83,7 +232,7 @@ public: /*interface*/
   bool getpeername(_T_ &_sockaddr) const noexcept
   {
     _sockaddr = reinterpret_cast< _T_& >(instance::from(uv_req)->properties().peer);
-    switch (reinterpret_cast< ::sockaddr >(_sockaddr).sa_family)
+    switch (reinterpret_cast< ::sockaddr& >(_sockaddr).sa_family)
     {
       case AF_INET:   return sizeof(_T_) >= sizeof(::sockaddr_in);
       case AF_INET6:  return sizeof(_T_) >= sizeof(::sockaddr_in6);
@@ -114,12 +263,41 @@ public: /*interface*/
     }
 
     uv_status(0);
-    auto uv_ret = ::uv_udp_send(
-        static_cast< uv_t* >(uv_req), static_cast< udp::uv_t* >(_udp),
-        static_cast< const buffer::uv_t* >(_buf), _buf.count(),
-        reinterpret_cast< const ::sockaddr* >(&_sockaddr),
-        udp_send_cb
-    );
+    auto uv_ret = send(static_cast< uv_t* >(uv_req), static_cast< udp::uv_t* >(_udp), false);
+    if (uv_ret < 0)
+    {
+      uv_status(uv_ret);
+      udp::instance::from(_udp.uv_handle)->unref();
+      buffer::instance::from(_buf.uv_buf)->unref();
+      instance_ptr->unref();
+    }
+
+    return uv_ret;
+  }
+
+  /*! \brief Run the request for the connected UDP handle.
+      \details Send data to the peer the socket has been associated with by `udp::connect()`.
+      Returns `UV_ENOTCONN` if the handle has not been connected.
+      \sa `udp::send()` for sending immediately without a request. */
+  int run(udp &_udp, const buffer &_buf)
+  {
+    auto &udp_properties = udp::instance::from(_udp.uv_handle)->properties();
+    if (!udp_properties.connected)  return uv_status(UV_ENOTCONN);
+
+    auto instance_ptr = instance::from(uv_req);
+
+    udp::instance::from(_udp.uv_handle)->ref();
+    buffer::instance::from(_buf.uv_buf)->ref();
+    instance_ptr->ref();
+
+    auto &properties = instance_ptr->properties();
+    {
+      properties.uv_buf = _buf.uv_buf;
+      properties.peer = udp_properties.peer;
+    }
+
+    uv_status(0);
+    auto uv_ret = send(static_cast< uv_t* >(uv_req), static_cast< udp::uv_t* >(_udp), true);
     if (uv_ret < 0)
     {
       uv_status(uv_ret);
@@ -161,6 +339,11 @@ void udp_send::udp_send_cb(::uv_udp_send_t *_uv_req, int _status)
   ref_guard< udp::instance > unref_handle(*udp::instance::from(_uv_req->handle), adopt_ref);
   ref_guard< instance > unref_req(*instance_ptr, adopt_ref);
 
+  if (_status != UV_ECANCELED)
+    egress_drain(_uv_req->handle);  // pass the held back requests to libuv
+  else if (::uv_is_closing(reinterpret_cast< ::uv_handle_t* >(_uv_req->handle)))
+    egress_cancel(_uv_req->handle);
+
   auto &udp_send_cb = instance_ptr->request_cb_storage.value();
   if (udp_send_cb)
     udp_send_cb(udp_send(_uv_req), buffer(instance_ptr->properties().uv_buf, adopt_ref));
@@ -169,6 +352,336 @@ void udp_send::udp_send_cb(::uv_udp_send_t *_uv_req, int _status)
 }
 
 
+
+/*! \ingroup doxy_group__request
+    \brief UDP batch send request type.
+    \details Queues a number of datagrams, each with its own destination address, with `add()` and sends them all with
+    as few [`sendmmsg()`](https://man7.org/linux/man-pages/man2/sendmmsg.2.html) system calls as possible on `run()`.
+    Unlike `udp_send`, there is one request and one callback for the whole batch.
+
+    If the socket send buffer becomes full, the rest of the batch is sent when the socket becomes writable again.
+    A datagram that fails to be sent with an error other than `EAGAIN`/`ENOBUFS` is skipped and counted in `failed()`,
+    and the request completes with the first such error as its `uv_status()`. The `on_request` callback is called on
+    the next loop iteration after the last datagram has been sent; the queued buffers are released and the request is
+    ready for a new batch by then.
+
+    The datagrams are written to the socket directly, so they are not ordered with the ones queued by `udp_send`.
+    \note Only available on Linux; `run()` returns `UV_ENOSYS` on other platforms. */
+class udp_send_batch : public request
+{
+  //! \cond
+  friend class request::instance< udp_send_batch >;
+  //! \endcond
+
+public: /*types*/
+  using uv_t = ::uv_udp_send_t;
+  using on_request_t = std::function< void(udp_send_batch _request) >;
+  /*!< \brief The function type of the callback called after the whole batch has been sent. */
+
+protected: /*types*/
+  //! \cond internals
+  //! \addtogroup doxy_group__internals
+  //! \{
+  struct entry
+  {
+    buffer::uv_t *uv_buf;
+    ::sockaddr_storage peer;
+    std::size_t segment_size;
+  };
+
+  struct flusher
+  {
+    union
+    {
+      ::uv_idle_t uv_idle;
+      ::uv_poll_t uv_poll;
+    };
+    bool initialized = false;
+    bool polling = false;
+    int fd = -1;
+    uv_t *uv_req = nullptr;
+#ifdef __linux__
+    std::vector< ::mmsghdr > msgs;
+    std::vector< char > control;
+#endif
+  };
+
+  struct properties : request::properties
+  {
+    std::vector< entry > entries;
+    std::size_t next = 0;
+    std::size_t sent = 0;
+    std::size_t failed = 0;
+    flusher *fl = nullptr;
+  };
+  //! \}
+  //! \endcond
+
+private: /*types*/
+  using instance = request::instance< udp_send_batch >;
+
+protected: /*constructors*/
+  //! \cond
+  explicit udp_send_batch(uv_t *_uv_req) : request(reinterpret_cast< request::uv_t* >(_uv_req))  {}
+  //! \endcond
+
+public: /*constructors*/
+  ~udp_send_batch() = default;
+  udp_send_batch()
+  {
+    uv_req = instance::create();
+    static_cast< uv_t* >(uv_req)->type = UV_UDP_SEND;
+  }
+
+  udp_send_batch(const udp_send_batch&) = default;
+  udp_send_batch& operator =(const udp_send_batch&) = default;
+
+  udp_send_batch(udp_send_batch&&) noexcept = default;
+  udp_send_batch& operator =(udp_send_batch&&) noexcept = default;
+
+private: /*functions*/
+  template< typename = void > static void idle_cb(::uv_idle_t*);
+  template< typename = void > static void poll_cb(::uv_poll_t*, int, int);
+
+  static void close_flusher(flusher *_fl)
+  {
+    ::uv_close(reinterpret_cast< ::uv_handle_t* >(&_fl->uv_idle), [](::uv_handle_t *_h)
+    {
+      auto fl = static_cast< flusher* >(_h->data);
+#ifdef __linux__
+      if (fl->polling)  ::close(fl->fd);
+#endif
+      delete fl;
+    });
+  }
+
+  static void release(properties &_properties)
+  {
+    for (auto &e : _properties.entries)  buffer::instance::from(e.uv_buf)->unref();
+    _properties.entries.clear();
+    _properties.next = 0;
+  }
+
+  /* send as much as possible; returns `true` when there is nothing left to send */
+  static bool flush(uv_t *_uv_req)
+  {
+#ifdef __linux__
+    auto instance_ptr = instance::from(_uv_req);
+    auto &properties = instance_ptr->properties();
+    auto fd = properties.fl->fd;
+    auto &msgs = properties.fl->msgs;
+
+    while (properties.next < properties.entries.size())
+    {
+      auto n = properties.entries.size() - properties.next;
+      if (n > msgs.size())  n = msgs.size();
+
+      for (std::size_t i = 0; i < n; ++i)
+      {
+        auto &e = properties.entries[properties.next + i];
+        auto &hdr = msgs[i].msg_hdr;
+        hdr = ::msghdr();
+        hdr.msg_name = &e.peer;
+        hdr.msg_namelen = e.peer.ss_family == AF_INET6 ? sizeof(::sockaddr_in6) : sizeof(::sockaddr_in);
+        hdr.msg_iov = reinterpret_cast< ::iovec* >(e.uv_buf);  // uv_buf_t is layout compatible with struct iovec on Unix
+        hdr.msg_iovlen = buffer::instance::from(e.uv_buf)->buf_count;
+        if (e.segment_size)
+        {
+          hdr.msg_control = properties.fl->control.data() + i*CMSG_SPACE(sizeof(std::uint16_t));
+          hdr.msg_controllen = CMSG_SPACE(sizeof(std::uint16_t));
+          auto cmsg = CMSG_FIRSTHDR(&hdr);
+          cmsg->cmsg_level = IPPROTO_UDP;
+          cmsg->cmsg_type = UDP_SEGMENT;
+          cmsg->cmsg_len = CMSG_LEN(sizeof(std::uint16_t));
+          std::uint16_t v = static_cast< std::uint16_t >(e.segment_size);
+          std::memcpy(CMSG_DATA(cmsg), &v, sizeof(v));
+        }
+      }
+
+      auto ret = ::sendmmsg(fd, msgs.data(), n, MSG_DONTWAIT);
+      if (ret < 0)
+      {
+        auto err = errno;
+        if (err == EINTR)  continue;
+        if (err == EAGAIN or err == EWOULDBLOCK or err == ENOBUFS)  return false;
+
+        if (instance_ptr->uv_error == 0)  instance_ptr->uv_error = -err;
+        ++properties.failed;
+        ++properties.next;  // skip the datagram that cannot be sent
+        continue;
+      }
+
+      properties.sent += ret;
+      properties.next += ret;
+    }
+#endif
+    return true;
+  }
+
+  static void complete(uv_t *_uv_req)
+  {
+    auto instance_ptr = instance::from(_uv_req);
+    auto &properties = instance_ptr->properties();
+
+    close_flusher(properties.fl);
+    properties.fl = nullptr;
+
+    release(properties);
+
+    ref_guard< udp::instance > unref_handle(*udp::instance::from(_uv_req->handle), adopt_ref);
+    ref_guard< instance > unref_req(*instance_ptr, adopt_ref);
+
+    auto &request_cb = instance_ptr->request_cb_storage.value();
+    if (request_cb)  request_cb(udp_send_batch(_uv_req));
+  }
+
+public: /*interface*/
+  on_request_t& on_request() const noexcept  { return instance::from(uv_req)->request_cb_storage.value(); }
+
+  /*! \brief The UDP handle where this request has been taking place. */
+  udp handle() const noexcept  { return udp(static_cast< uv_t* >(uv_req)->handle); }
+
+  /*! \brief Queue a datagram to be sent to the specified address.
+      \details If `_segment_size` is non-zero, the payload is sent with UDP generic segmentation offload (GSO), i.e. it is
+      split by the kernel (or the NIC) into the datagrams of `_segment_size` bytes each (the last one can be shorter).
+      Returns `UV_EBUSY` if the request is currently running.
+      \sa `udp::set_gso_segment()` */
+  template<
+      typename _T_,
+      typename = std::enable_if_t< is_one_of< _T_, ::sockaddr, ::sockaddr_in, ::sockaddr_in6, ::sockaddr_storage >::value >
+  >
+  int add(const buffer &_buf, const _T_ &_sockaddr, std::size_t _segment_size = 0)
+  {
+    auto &properties = instance::from(uv_req)->properties();
+    if (properties.fl)  return uv_status(UV_EBUSY);
+
+    properties.entries.emplace_back();
+    auto &e = properties.entries.back();
+    e.uv_buf = _buf.uv_buf;
+    init(e.peer, reinterpret_cast< const ::sockaddr& >(_sockaddr));
+    e.segment_size = _segment_size;
+    buffer::instance::from(e.uv_buf)->ref();
+
+    return uv_status(0);
+  }
+
+  /*! \brief The number of the datagrams queued in the current batch. */
+  std::size_t size() const noexcept  { return instance::from(uv_req)->properties().entries.size(); }
+  /*! \brief The number of the datagrams that have been sent in the last (or current) run. */
+  std::size_t sent() const noexcept  { return instance::from(uv_req)->properties().sent; }
+  /*! \brief The number of the datagrams that have failed to be sent in the last (or current) run. */
+  std::size_t failed() const noexcept  { return instance::from(uv_req)->properties().failed; }
+
+  /*! \brief Drop all the queued datagrams. Has no effect if the request is currently running. */
+  void clear() const noexcept
+  {
+    auto &properties = instance::from(uv_req)->properties();
+    if (!properties.fl)  release(properties);
+  }
+
+  /*! \brief Run the request. Send all the queued datagrams over the UDP socket.
+      \details The socket should have been created or bound before (i.e. `udp::socket()` returns a valid descriptor),
+      otherwise `UV_EBADF` is returned. Returns `UV_EBUSY` if the request is still running. */
+  int run(udp &_udp)
+  {
+#ifdef __linux__
+    auto instance_ptr = instance::from(uv_req);
+    auto &properties = instance_ptr->properties();
+
+    if (properties.fl)  return uv_status(UV_EBUSY);
+
+    auto sock = _udp.socket();
+    if (sock < 0)  return uv_status(UV_EBADF);
+
+    auto fl = new flusher;
+    fl->uv_req = static_cast< uv_t* >(uv_req);
+    fl->fd = sock;
+    fl->msgs.resize(properties.entries.size() < 1024 ? properties.entries.size() : 1024);  // UIO_MAXIOV
+    fl->control.resize(fl->msgs.size()*CMSG_SPACE(sizeof(std::uint16_t)));
+
+    static_cast< uv_t* >(uv_req)->handle = static_cast< udp::uv_t* >(_udp);
+    udp::instance::from(_udp.uv_handle)->ref();
+    instance_ptr->ref();
+
+    properties.fl = fl;
+    properties.sent = 0;
+    properties.failed = 0;
+
+    uv_status(0);
+    int uv_ret;
+    if (flush(fl->uv_req))
+    {
+      // nothing left to send, complete on the next loop iteration
+      uv_ret = ::uv_idle_init(static_cast< udp::uv_t* >(_udp)->loop, &fl->uv_idle);
+      fl->uv_idle.data = fl;
+      fl->initialized = uv_ret == 0;
+      if (uv_ret == 0)  uv_ret = ::uv_idle_start(&fl->uv_idle, idle_cb);
+    }
+    else
+    {
+      // wait for the socket to become writable through a duplicate descriptor,
+      // the original one may already be watched by libuv
+      fl->fd = ::dup(sock);
+      fl->polling = fl->fd >= 0;
+      uv_ret = fl->polling ? ::uv_poll_init(static_cast< udp::uv_t* >(_udp)->loop, &fl->uv_poll, fl->fd) : -errno;
+      fl->uv_poll.data = fl;
+      fl->initialized = uv_ret == 0;
+      if (uv_ret == 0)  uv_ret = ::uv_poll_start(&fl->uv_poll, UV_WRITABLE, poll_cb);
+    }
+
+    if (uv_ret < 0)
+    {
+      uv_status(uv_ret);
+      properties.fl = nullptr;
+      if (fl->initialized)
+        close_flusher(fl);
+      else
+      {
+        if (fl->polling)  ::close(fl->fd);
+        delete fl;
+      }
+      release(properties);
+      udp::instance::from(_udp.uv_handle)->unref();
+      instance_ptr->unref();
+    }
+
+    return uv_ret;
+#else
+    return uv_status(UV_ENOSYS);
+#endif
+  }
+
+public: /*conversion operators*/
+  explicit operator const uv_t*() const noexcept  { return static_cast< const uv_t* >(uv_req); }
+  explicit operator       uv_t*()       noexcept  { return static_cast<       uv_t* >(uv_req); }
+};
+
+template< typename >
+void udp_send_batch::idle_cb(::uv_idle_t *_uv_idle)
+{
+  complete(static_cast< flusher* >(_uv_idle->data)->uv_req);
+}
+
+template< typename >
+void udp_send_batch::poll_cb(::uv_poll_t *_uv_poll, int _status, int _events)
+{
+  auto uv_req = static_cast< flusher* >(_uv_poll->data)->uv_req;
+
+  if (_status < 0)
+  {
+    auto instance_ptr = instance::from(uv_req);
+    auto &properties = instance_ptr->properties();
+
+    if (instance_ptr->uv_error == 0)  instance_ptr->uv_error = _status;
+    properties.failed += properties.entries.size() - properties.next;
+    complete(uv_req);
+    return;
+  }
+
+  if (flush(uv_req))  complete(uv_req);
+}
+
+
 }
 
 
@@ -27,6 +27,7 @@ class shutdown;
 class udp_send;
 class fs;
 template< typename > class work;
+template< typename > class lean_work;
 class getaddrinfo;
 class getnameinfo;
 
@@ -0,0 +1,365 @@
+
+#ifndef UVCC_SESSION_TABLE__HPP
+#define UVCC_SESSION_TABLE__HPP
+
+#include "uvcc/utility.hpp"
+#include "uvcc/loop.hpp"
+#include "uvcc/buffer.hpp"
+#include "uvcc/handle-io.hpp"
+#include "uvcc/handle-udp.hpp"
+#include "uvcc/handle-misc.hpp"
+#include "uvcc/netstruct.hpp"
+
+#include <cstddef>      // size_t
+#include <cstdint>      // uint32_t uint64_t
+#include <cstring>      // memset()
+#include <uv.h>
+
+#include <functional>   // function
+#include <utility>      // forward() swap()
+#include <vector>       // vector
+
+
+namespace uv
+{
+
+
+/*! \ingroup doxy_group__handle
+    \brief The table of per-peer sessions for UDP servers.
+    \details Maps the remote peer addresses (`sockaddr_in`/`sockaddr_in6`) to the user's `_Session_` objects and
+    dispatches the received datagrams to them. The table is an open addressing hash table with linear probing and
+    backward shift deletion, using `sockaddr_hash` and `sockaddr_equal` over the binary addresses, so neither
+    formatting of the addresses nor any allocation besides the session objects themselves takes place.
+
+    A datagram from an unknown peer creates a new session (default-constructed `_Session_` object), which can be
+    initialized or refused by the `on_accept()` callback. Then the datagram, and all further ones from the same peer,
+    is passed to the `on_packet()` callback together with the peer session.
+
+    If the idle timeout is set, the sessions having not received any datagram for longer than that are evicted, the
+    `on_evict()` callback being called before destroying the session object. The check is performed by an internal
+    timer with the period of a quarter of the timeout, and takes only the sessions actually being expired as they are
+    kept in the order of their last activity.
+
+    The table object is not copyable and not movable, as the callbacks it provides refer to it.
+    \note The table is not thread-safe and all its operations should be performed on the loop thread. */
+template< class _Session_ >
+class udp_session_table
+{
+public: /*types*/
+  using session_type = _Session_;
+
+  using on_accept_t = std::function< bool(const ::sockaddr *_peer, _Session_ &_session) >;
+  /*!< \brief The function type of the callback called when a datagram from a new peer is received.
+       \details The callback can initialize the new session. Returning `false` refuses the session: it is destroyed and
+       the datagram is dropped. */
+  using on_packet_t = std::function< void(_Session_ &_session, const uv_buf_t &_data, const buffer &_buffer, const udp::io_info &_info) >;
+  /*!< \brief The function type of the callback called with each datagram received from a peer having a session.
+       \details `_data` is the datagram payload lying within `_buffer`; the buffer can be copied to retain the data
+       after the callback returns. */
+  using on_evict_t = std::function< void(const ::sockaddr *_peer, _Session_ &_session) >;
+  /*!< \brief The function type of the callback called before an idle session is evicted from the table. */
+
+private: /*types*/
+  struct link
+  {
+    link *prev = this, *next = this;  // the list ordered by the last activity time
+
+    void unlink() noexcept
+    {
+      prev->next = next;
+      next->prev = prev;
+      prev = next = this;
+    }
+  };
+
+  struct node : link
+  {
+    ::sockaddr_storage peer;
+    uint64_t last_seen = 0;
+    _Session_ session;
+  };
+
+  struct slot
+  {
+    std::size_t hash;
+    node *n;
+  };
+
+private: /*data*/
+  std::vector< slot > slots;
+  std::size_t count = 0;
+  link lru;  // the list head, the least recently active session is the first one
+  uint64_t idle_timeout_value = 0;
+  timer evictor;
+  on_accept_t accept_cb;
+  on_packet_t packet_cb;
+  on_evict_t evict_cb;
+
+public: /*constructors*/
+  ~udp_session_table()
+  {
+    evictor.stop();
+    evictor.on_timer() = nullptr;
+    clear();
+  }
+
+  /*! \brief Create a session table for the loop `_loop` with initial capacity for `_capacity` sessions. */
+  explicit udp_session_table(uv::loop &_loop, std::size_t _capacity = 1024) : evictor(_loop)
+  {
+    reserve(_capacity);
+    evictor.on_timer() = [this](timer){ evict(); };
+  }
+
+  udp_session_table(const udp_session_table&) = delete;
+  udp_session_table& operator =(const udp_session_table&) = delete;
+
+  udp_session_table(udp_session_table&&) = delete;
+  udp_session_table& operator =(udp_session_table&&) = delete;
+
+private: /*functions*/
+  std::size_t mask() const noexcept  { return slots.size() - 1; }
+
+  uint64_t now() const noexcept  { return evictor.loop().now(); }
+
+  /* the index of the slot holding the peer or of the empty slot where it should be inserted */
+  std::size_t probe(const ::sockaddr &_peer, std::size_t _hash) const noexcept
+  {
+    auto i = _hash & mask();
+    while (slots[i].n and (slots[i].hash != _hash or !sockaddr_equal()(reinterpret_cast< const ::sockaddr& >(slots[i].n->peer), _peer)))
+      i = (i + 1) & mask();
+    return i;
+  }
+
+  void rehash(std::size_t _size)
+  {
+    std::vector< slot > old(_size, slot{ 0, nullptr });
+    old.swap(slots);
+    for (auto &s : old)  if (s.n)
+    {
+      auto i = s.hash & mask();
+      while (slots[i].n)  i = (i + 1) & mask();
+      slots[i] = s;
+    }
+  }
+
+  void remove_slot(std::size_t _i) noexcept
+  {
+    // backward shift deletion: move the following entries of the probe sequence into the hole
+    auto hole = _i;
+    for (auto i = (_i + 1) & mask(); slots[i].n; i = (i + 1) & mask())
+    {
+      auto home = slots[i].hash & mask();
+      if (((i - home) & mask()) >= ((i - hole) & mask()))
+      {
+        slots[hole] = slots[i];
+        hole = i;
+      }
+    }
+    slots[hole] = slot{ 0, nullptr };
+    --count;
+  }
+
+  void touch(node *_n) noexcept
+  {
+    _n->last_seen = now();
+    _n->unlink();
+    _n->prev = lru.prev;
+    _n->next = &lru;
+    lru.prev->next = _n;
+    lru.prev = _n;
+  }
+
+  void evict()
+  {
+    auto t = now();
+    while (lru.next != &lru and t - static_cast< node* >(lru.next)->last_seen >= idle_timeout_value)
+    {
+      auto n = static_cast< node* >(lru.next);
+      if (evict_cb)  evict_cb(reinterpret_cast< const ::sockaddr* >(&n->peer), n->session);
+      if (n == lru.next and t - n->last_seen >= idle_timeout_value)  erase(reinterpret_cast< const ::sockaddr& >(n->peer));  // unless the callback has touched or erased it
+    }
+    if (count == 0)  evictor.stop();
+  }
+
+public: /*interface*/
+  /*! \brief Set the callback called for a new peer session. */
+  on_accept_t& on_accept() noexcept  { return accept_cb; }
+  /*! \brief Set the callback receiving the datagrams. */
+  on_packet_t& on_packet() noexcept  { return packet_cb; }
+  /*! \brief Set the callback called before evicting an idle session. */
+  on_evict_t& on_evict() noexcept  { return evict_cb; }
+
+  /*! \brief The number of sessions in the table. */
+  std::size_t size() const noexcept  { return count; }
+  /*! \brief Check if the table is empty. */
+  bool empty() const noexcept  { return count == 0; }
+
+  /*! \brief Make sure the table can hold `_n` sessions without rehashing. */
+  void reserve(std::size_t _n)
+  {
+    std::size_t size = 16;
+    while (size*3 < _n*4)  size <<= 1;  // keep the load factor below 0.75
+    if (size > slots.size())  rehash(size);
+  }
+
+  /*! \brief The idle timeout (in milliseconds). **0** means the sessions are never evicted. */
+  uint64_t idle_timeout() const noexcept  { return idle_timeout_value; }
+  /*! \brief Set the idle timeout (in milliseconds). */
+  void idle_timeout(uint64_t _value)
+  {
+    idle_timeout_value = _value;
+    evictor.stop();
+    if (_value and count)
+    {
+      evictor.repeat_interval(greatest(_value/4, uint64_t(1)));
+      evictor.start(evictor.repeat_interval());
+    }
+  }
+
+  /*! \brief Find the session for the peer. Returns `nullptr` if there is no such a session. */
+  template< typename _T_, typename = std::enable_if_t< is_one_of< _T_, ::sockaddr, ::sockaddr_in, ::sockaddr_in6, ::sockaddr_storage >::value > >
+  _Session_* find(const _T_ &_peer) noexcept
+  {
+    auto &sa = reinterpret_cast< const ::sockaddr& >(_peer);
+    auto n = slots[probe(sa, sockaddr_hash()(sa))].n;
+    return n ? &n->session : nullptr;
+  }
+
+  /*! \brief Get the session for the peer, creating a new one (with no `on_accept()` call) if there is no such a session.
+      \details The session is marked as active. Returns `nullptr` for an address of unsupported family. */
+  template< typename _T_, typename = std::enable_if_t< is_one_of< _T_, ::sockaddr, ::sockaddr_in, ::sockaddr_in6, ::sockaddr_storage >::value > >
+  _Session_* get(const _T_ &_peer)
+  {
+    bool created;
+    auto n = insert(reinterpret_cast< const ::sockaddr& >(_peer), created);
+    return n ? &n->session : nullptr;
+  }
+
+  /*! \brief Remove the session for the peer. Returns `false` if there is no such a session. */
+  template< typename _T_, typename = std::enable_if_t< is_one_of< _T_, ::sockaddr, ::sockaddr_in, ::sockaddr_in6, ::sockaddr_storage >::value > >
+  bool erase(const _T_ &_peer)
+  {
+    auto &sa = reinterpret_cast< const ::sockaddr& >(_peer);
+    auto i = probe(sa, sockaddr_hash()(sa));
+    auto n = slots[i].n;
+    if (!n)  return false;
+
+    remove_slot(i);
+    n->unlink();
+    delete n;
+    return true;
+  }
+
+  /*! \brief Remove all the sessions. The `on_evict()` callback is not called. */
+  void clear()
+  {
+    while (lru.next != &lru)
+    {
+      auto n = static_cast< node* >(lru.next);
+      n->unlink();
+      delete n;
+    }
+    for (auto &s : slots)  s = slot{ 0, nullptr };
+    count = 0;
+    evictor.stop();
+  }
+
+  /*! \brief Pass the received datagram `_data` lying within `_buffer` to its peer session.
+      \details Looks up or creates the session for `_info.peer` and calls the `on_packet()` callback.
+      The datagrams without the peer address (i.e. the `recv_start()` notifications with nothing to read)
+      and the ones refused by `on_accept()` are ignored. Returns the session or `nullptr`. */
+  _Session_* dispatch(const uv_buf_t &_data, const buffer &_buffer, const udp::io_info &_info)
+  {
+    if (!_info.peer)  return nullptr;
+
+    bool created;
+    auto n = insert(*_info.peer, created);
+    if (!n)  return nullptr;
+
+    if (created and accept_cb and !accept_cb(_info.peer, n->session))
+    {
+      erase(*_info.peer);
+      return nullptr;
+    }
+
+    if (packet_cb)  packet_cb(n->session, _data, _buffer, _info);
+    return &n->session;
+  }
+
+  /*! \brief Pass the batch of datagrams received by `udp::recv_batch_start()` to their peer sessions.
+      \details The datagrams refused by `on_accept()` are ignored. */
+  void dispatch(const buffer &_buffer, const std::vector< udp::datagram > &_batch)
+  {
+    for (auto &d : _batch)  dispatch(d.data, _buffer, d.info);
+  }
+
+  /*! \brief The read callback for `udp::recv_start()` dispatching the datagrams to this table.
+      \details Example:
+      ```
+      uv::udp_session_table< session > table(loop);
+      udp.recv_start(uv::slab_allocator(), table.receiver());
+      ``` */
+  io::on_read_t receiver()
+  {
+    return [this](io, ssize_t _nread, buffer _buffer, int64_t, void *_info)
+    {
+      if (_nread < 0)  return;
+      dispatch(::uv_buf_init(_buffer.base(), static_cast< unsigned int >(_nread)), _buffer, *static_cast< const udp::io_info* >(_info));
+    };
+  }
+
+  /*! \brief Idem for `udp::recv_batch_start()`. */
+  udp::on_recv_batch_t batch_receiver()
+  {
+    return [this](udp, buffer _buffer, const std::vector< udp::datagram > &_batch){ dispatch(_buffer, _batch); };
+  }
+
+  /*! \brief Call the function `_f(const ::sockaddr *_peer, _Session_ &_session)` for each session,
+      from the least to the most recently active one. */
+  template< class _F_ >
+  void for_each(_F_ &&_f)
+  {
+    for (auto l = lru.next; l != &lru; )
+    {
+      auto n = static_cast< node* >(l);
+      l = l->next;
+      _f(reinterpret_cast< const ::sockaddr* >(&n->peer), n->session);
+    }
+  }
+
+private: /*functions*/
+  node* insert(const ::sockaddr &_peer, bool &_created)
+  {
+    _created = false;
+    if (_peer.sa_family != AF_INET and _peer.sa_family != AF_INET6)  return nullptr;
+
+    auto hash = sockaddr_hash()(_peer);
+    auto i = probe(_peer, hash);
+    auto n = slots[i].n;
+    if (!n)
+    {
+      if ((count + 1)*4 > slots.size()*3)
+      {
+        rehash(slots.size()*2);
+        i = probe(_peer, hash);
+      }
+
+      n = new node;
+      init(n->peer, _peer);
+      slots[i] = slot{ hash, n };
+      ++count;
+      _created = true;
+
+      if (idle_timeout_value and count == 1)  idle_timeout(idle_timeout_value);
+    }
+
+    touch(n);
+    return n;
+  }
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,336 @@
+
+#ifndef UVCC_STAT_CACHE__HPP
+#define UVCC_STAT_CACHE__HPP
+
+#include "uvcc/utility.hpp"
+#include "uvcc/loop.hpp"
+#include "uvcc/handle-fs.hpp"
+#include "uvcc/request-fs.hpp"
+
+#include <cstddef>      // size_t
+#include <cstdint>      // uint64_t
+#include <uv.h>
+
+#include <functional>   // function
+#include <memory>       // shared_ptr make_shared()
+#include <string>       // string
+#include <unordered_map>  // unordered_map
+#include <utility>      // move() piecewise_construct forward_as_tuple()
+#include <vector>       // vector
+
+
+namespace uv
+{
+
+
+/*! \ingroup doxy_group__request
+    \brief The cache of the file status information keyed by the file paths.
+    \details Serves repeated `fs::stat` lookups for the same paths from memory instead of a thread pool round trip each.
+
+    A cached entry is valid for `ttl()` milliseconds (of the loop time). The failed lookups with `UV_ENOENT` or
+    `UV_ENOTDIR` result are cached as well, as negative entries valid for `negative_ttl()` milliseconds; the other errors
+    are not cached. Before the TTL expires an entry is invalidated as soon as the file is changed, created, deleted, or
+    renamed: the parent directories of the cached paths are watched with `uv::fs_event` handles, a single one per
+    directory. If the watch cannot be set up (e.g. the directory does not exist) the entries rely on the TTL only.
+    The watch handles are detached from the loop (see `handle::attached()`), so they do not keep it running.
+
+    Concurrent lookups of a path missing in the cache share the same in-flight `fs::stat` request.
+
+    The number of the entries is limited by `capacity()`; the ones having been fetched earliest are evicted first.
+
+    The paths are used as given, with no normalization, so `"a/b"` and `"./a/b"` are different entries.
+    \note The cache is not thread-safe and all its operations should be performed on the loop thread.
+    The cache object is not copyable and not movable. It can be destroyed while some lookups are still in progress,
+    their callbacks will be called anyway. */
+class stat_cache
+{
+public: /*types*/
+  using on_stat_t = std::function< void(int _uv_status, const ::uv_stat_t &_stat) >;
+  /*!< \brief The function type of the callback called with the lookup result.
+       \details `_uv_status` is the status value of the `fs::stat` request; `_stat` is meaningful only if it is >= 0. */
+
+private: /*types*/
+  struct link
+  {
+    link *prev = this, *next = this;  // the list ordered by the fetch time
+
+    void unlink() noexcept
+    {
+      prev->next = next;
+      next->prev = prev;
+      prev = next = this;
+    }
+    void link_before(link &_that) noexcept
+    {
+      prev = _that.prev;
+      next = &_that;
+      prev->next = this;
+      _that.prev = this;
+    }
+  };
+
+  struct watch
+  {
+    fs_event handle;
+    const std::string *prefix = nullptr;
+    std::size_t nrefs = 0;  // the number of the entries in the watched directory
+    bool active = false;
+
+    explicit watch(uv::loop &_loop) : handle(_loop)  {}
+    ~watch()  { if (active)  handle.stop(); }
+  };
+
+  struct entry : link
+  {
+    const std::string *path = nullptr;
+    watch *dir = nullptr;
+    uint64_t expiry = 0;
+    int status = 0;
+    ::uv_stat_t statbuf;
+    bool in_flight = false;
+    bool dirty = false;  // invalidated while the request is in flight
+    std::vector< on_stat_t > waiters;
+  };
+
+  struct state
+  {
+    uv::loop loop;
+    uint64_t ttl, negative_ttl;
+    std::size_t capacity = 65536;
+    bool follow_symlinks;
+    bool closed = false;
+    uint64_t hits = 0, misses = 0;
+    link lru;
+    std::unordered_map< std::string, entry > entries;
+    std::unordered_map< std::string, watch > watches;  // keyed by the directory prefix of the paths, including the trailing slash
+
+    state(uv::loop &_loop, uint64_t _ttl, uint64_t _negative_ttl, bool _follow_symlinks)
+      : loop(_loop), ttl(_ttl), negative_ttl(_negative_ttl), follow_symlinks(_follow_symlinks)
+    {}
+
+    void invalidate(entry &_e) noexcept
+    {
+      if (_e.in_flight)
+        _e.dirty = true;
+      else
+        _e.expiry = 0;
+    }
+
+    void invalidate(const std::string &_path) noexcept
+    {
+      auto it = entries.find(_path);
+      if (it != entries.end())  invalidate(it->second);
+    }
+
+    void invalidate(watch *_dir) noexcept
+    {
+      for (auto &e : entries)  if (e.second.dir == _dir)  invalidate(e.second);
+    }
+
+    void erase(entry &_e)
+    {
+      _e.unlink();
+      auto dir = _e.dir;
+      entries.erase(*_e.path);
+      if (dir and --dir->nrefs == 0)  watches.erase(watches.find(*dir->prefix));
+    }
+
+    watch* attach(const std::string &_path)
+    {
+      if (closed)  return nullptr;
+
+      auto slash = _path.rfind('/');
+      auto prefix = slash == std::string::npos ? std::string() : _path.substr(0, slash + 1);
+
+      auto it = watches.find(prefix);
+      if (it == watches.end())
+      {
+        it = watches.emplace(std::piecewise_construct, std::forward_as_tuple(prefix), std::forward_as_tuple(loop)).first;
+
+        auto &w = it->second;
+        w.prefix = &it->first;
+        w.handle.path() = prefix.empty() ? std::string(".") : prefix.size() == 1 ? prefix : prefix.substr(0, prefix.size() - 1);
+        w.handle.on_fs_event() = [this, &w, prefix](fs_event _handle, const char *_filename, int)
+        {
+          if (!_handle or !_filename)
+            invalidate(&w);
+          else
+            invalidate(prefix + _filename);
+        };
+        w.active = w.handle and w.handle.start() >= 0;
+        if (w.active)  w.handle.attached(false);  // the watches should not keep the loop running
+      }
+
+      ++it->second.nrefs;
+      return &it->second;
+    }
+
+    void close()
+    {
+      closed = true;
+      for (auto &e : entries)  e.second.dir = nullptr;
+      watches.clear();
+    }
+  };
+
+private: /*data*/
+  std::shared_ptr< state > st;
+
+private: /*functions*/
+  static int fetch(const std::shared_ptr< state > &_st, entry &_e, on_stat_t &&_cb)
+  {
+    _e.in_flight = true;
+    _e.dirty = false;
+    _e.waiters.push_back(std::move(_cb));
+
+    fs::stat req;
+    req.on_request() = [st = _st, &_e](fs::stat _req)
+    {
+      auto status = _req.uv_status();
+      auto statbuf = _req.result();
+
+      _e.in_flight = false;
+      if (_e.dirty or (status < 0 and status != UV_ENOENT and status != UV_ENOTDIR))
+        _e.expiry = 0;
+      else
+        _e.expiry = ::uv_now(static_cast< uv::loop::uv_t* >(st->loop)) + (status < 0 ? st->negative_ttl : st->ttl);
+      _e.status = status;
+      _e.statbuf = statbuf;
+      _e.unlink();
+      _e.link_before(st->lru);
+
+      // the callbacks may run other lookups evicting this entry
+      std::vector< on_stat_t > waiters;
+      waiters.swap(_e.waiters);
+      for (auto &cb : waiters)  cb(status, statbuf);
+    };
+
+    auto uv_ret = req.run(_st->loop, _e.path->c_str(), _st->follow_symlinks);
+    if (uv_ret < 0)
+    {
+      _e.in_flight = false;
+      _e.waiters.pop_back();
+    }
+    return uv_ret;
+  }
+
+public: /*constructors*/
+  ~stat_cache()  { st->close(); }
+
+  /*! \brief Create a stat cache for the `_loop`.
+      \details `_ttl` and `_negative_ttl` are in milliseconds. If `_follow_symlinks` is `true` the status of the files
+      the symbolic links refer to is looked up (`stat()`), otherwise the status of the links themselves (`lstat()`). */
+  explicit stat_cache(uv::loop &_loop, uint64_t _ttl = 1000, uint64_t _negative_ttl = 1000, bool _follow_symlinks = true)
+    : st(std::make_shared< state >(_loop, _ttl, _negative_ttl, _follow_symlinks))
+  {}
+
+  stat_cache(const stat_cache&) = delete;
+  stat_cache& operator =(const stat_cache&) = delete;
+
+  stat_cache(stat_cache&&) = delete;
+  stat_cache& operator =(stat_cache&&) = delete;
+
+public: /*interface*/
+  /*! \brief Look up the status information of the file specified by `_path`.
+      \details If there is a valid cached entry for the `_path` the `_cb` callback is called with it before the function
+      returns. Otherwise an `fs::stat` request is run, or the one already in progress for the `_path` is joined, and
+      the callback is called on its completion.
+      \returns The status value of running the `fs::stat` request, or **0** on a cache hit or joining a request in progress.
+      If the request has failed to start the callback is not called. */
+  int lookup(const std::string &_path, on_stat_t _cb)
+  {
+    auto &s = *st;
+
+    auto it = s.entries.find(_path);
+    if (it != s.entries.end())
+    {
+      auto &e = it->second;
+      if (e.in_flight)
+      {
+        ++s.misses;
+        e.waiters.push_back(std::move(_cb));
+        return 0;
+      }
+      if (::uv_now(static_cast< uv::loop::uv_t* >(s.loop)) < e.expiry)
+      {
+        ++s.hits;
+        auto status = e.status;
+        auto statbuf = e.statbuf;
+        _cb(status, statbuf);
+        return 0;
+      }
+      ++s.misses;
+      return fetch(st, e, std::move(_cb));
+    }
+
+    ++s.misses;
+
+    // make room for the new entry, the ones in progress cannot be evicted
+    for (auto l = s.lru.next; s.entries.size() >= s.capacity and l != &s.lru; )
+    {
+      auto &e = static_cast< entry& >(*l);
+      l = l->next;
+      if (!e.in_flight)  s.erase(e);
+    }
+
+    it = s.entries.emplace(std::piecewise_construct, std::forward_as_tuple(_path), std::forward_as_tuple()).first;
+    auto &e = it->second;
+    e.path = &it->first;
+    e.link_before(s.lru);
+    e.dir = s.attach(_path);
+
+    auto uv_ret = fetch(st, e, std::move(_cb));
+    if (uv_ret < 0)  s.erase(e);
+    return uv_ret;
+  }
+
+  /*! \brief Invalidate the cached entry for the `_path`, if any. */
+  void invalidate(const std::string &_path) noexcept  { st->invalidate(_path); }
+
+  /*! \brief Remove all the cached entries except the ones being fetched at the moment, which are invalidated. */
+  void clear()
+  {
+    auto &s = *st;
+    for (auto l = s.lru.next; l != &s.lru; )
+    {
+      auto &e = static_cast< entry& >(*l);
+      l = l->next;
+      if (e.in_flight)
+        e.dirty = true;
+      else
+        s.erase(e);
+    }
+  }
+
+  /*! \brief The number of the cached entries. */
+  std::size_t size() const noexcept  { return st->entries.size(); }
+  /*! \brief The number of the directories being watched. */
+  std::size_t watched_dirs() const noexcept  { return st->watches.size(); }
+
+  /*! \brief The number of the lookups served from the cache. */
+  uint64_t hits() const noexcept  { return st->hits; }
+  /*! \brief The number of the lookups having required an `fs::stat` request, including the ones that have joined
+      a request already in progress. */
+  uint64_t misses() const noexcept  { return st->misses; }
+
+  /*! \brief _Get_ the time to live of the cached entries in milliseconds. */
+  uint64_t ttl() const noexcept  { return st->ttl; }
+  /*! \brief _Set_ the time to live of the cached entries in milliseconds. It affects the entries fetched afterwards. */
+  void ttl(uint64_t _value) noexcept  { st->ttl = _value; }
+
+  /*! \brief _Get_ the time to live of the negative entries in milliseconds. */
+  uint64_t negative_ttl() const noexcept  { return st->negative_ttl; }
+  /*! \brief _Set_ the time to live of the negative entries in milliseconds. It affects the entries fetched afterwards. */
+  void negative_ttl(uint64_t _value) noexcept  { st->negative_ttl = _value; }
+
+  /*! \brief _Get_ the maximum number of the cached entries. */
+  std::size_t capacity() const noexcept  { return st->capacity; }
+  /*! \brief _Set_ the maximum number of the cached entries. */
+  void capacity(std::size_t _value) noexcept  { st->capacity = _value ? _value : 1; }
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,567 @@
+
+#ifndef UVCC_TIMER_WHEEL__HPP
+#define UVCC_TIMER_WHEEL__HPP
+
+#include "uvcc/utility.hpp"
+#include "uvcc/loop.hpp"
+#include "uvcc/handle-io.hpp"
+#include "uvcc/handle-stream.hpp"
+#include "uvcc/handle-misc.hpp"
+
+#include <cstddef>      // size_t
+#include <cstdint>      // uint64_t int64_t
+#include <uv.h>
+
+#include <functional>   // function
+#include <vector>       // vector
+#include <utility>      // swap()
+
+
+namespace uv
+{
+
+
+/*! \defgroup doxy_group__timer_wheel  Timer wheel
+    \brief Hierarchical timing wheel for managing large numbers of timeouts with a single timer handle. */
+
+/*! \ingroup doxy_group__timer_wheel
+    \brief A hierarchical timing wheel driven by a single `uv::timer` handle.
+    \details Every `uv::timer` is a separate handle kept in the libuv loop's timer heap, so starting, restarting,
+    and stopping it costs O(log n). The timer wheel keeps an arbitrary number of `timer_wheel::timeout` entries in
+    four levels of 256 slots each and provides O(1) arm, re-arm, and cancel operations. The wheel is advanced by one
+    internal repeating timer with the period equal to the wheel tick, which is running only while there is at least
+    one armed timeout.
+
+    All timeouts expiring at the same tick are processed as one batch within a single timer callback call.
+    Each timeout may have its own callback (`timeout::on_timeout()`); expired timeouts with no callback of their own
+    are collected and delivered all at once to the wheel callback (`timer_wheel::on_expire()`).
+
+    The timeout resolution is equal to the wheel tick: a timeout never expires earlier than requested and expires not
+    later than one tick after the requested time (plus the loop latency). Timeouts longer than 2<sup>32</sup> ticks are
+    cascaded down repeatedly until they reach their expiration time.
+    \note The timer wheel is not thread-safe and all its operations should be performed on the loop thread. */
+class timer_wheel
+{
+public: /*types*/
+  class timeout;
+  class stream_timeouts;
+
+  using on_expire_t = std::function< void(timer_wheel _wheel, std::vector< timeout* > &_batch) >;
+  /*!< \brief The function type of the callback called with a batch of expired timeouts that have no callback of their own.
+       \details The timeouts in the `_batch` vector are already disarmed and can be immediately re-armed from the callback. */
+
+private: /*types*/
+  class instance;
+
+  enum : unsigned  { LEVEL_BITS = 8, LEVEL_SIZE = 1U << LEVEL_BITS, LEVEL_MASK = LEVEL_SIZE - 1, LEVELS = 4 };
+
+  struct link
+  {
+    link *prev = this, *next = this;
+
+    link() = default;
+    link(const link&) = delete;
+    link& operator =(const link&) = delete;
+
+    bool empty() const noexcept  { return next == this; }
+    void unlink() noexcept
+    {
+      prev->next = next;
+      next->prev = prev;
+      prev = next = this;
+    }
+    void push_back(link &_l) noexcept
+    {
+      _l.prev = prev;
+      _l.next = this;
+      prev->next = &_l;
+      prev = &_l;
+    }
+    void splice(link &_that) noexcept  // move all the nodes from _that list to the end of this one
+    {
+      if (_that.empty())  return;
+      _that.next->prev = prev;
+      prev->next = _that.next;
+      _that.prev->next = this;
+      prev = _that.prev;
+      _that.prev = _that.next = &_that;
+    }
+  };
+
+public: /*types*/
+  /*! \brief A timeout entry that can be armed on a `timer_wheel`.
+      \details This is an intrusive list node which is designed to be embedded into the user's per-connection (or
+      whatever else) data structure. It is not copyable and not movable. The destructor cancels an armed timeout. */
+  class timeout : private link
+  {
+    //! \cond
+    friend class timer_wheel;
+    friend class instance;
+    //! \endcond
+
+  public: /*types*/
+    using on_timeout_t = std::function< void(timeout &_timeout) >;
+    /*!< \brief The function type of the callback called when the timeout expires.
+         \details The timeout is already disarmed and can be immediately re-armed from the callback. */
+
+  private: /*data*/
+    instance *wheel = nullptr;
+    instance *home = nullptr;  // the wheel the timeout has last been armed on, a reference to it is held for rearm()
+    uint64_t expires = 0;
+    on_timeout_t timeout_cb;
+
+  public: /*constructors*/
+    ~timeout()
+    {
+      cancel();
+      if (home)  home->unref();
+    }
+
+    timeout() = default;
+    /*! \brief Create a timeout entry with the given callback. */
+    explicit timeout(const on_timeout_t &_timeout_cb) : timeout_cb(_timeout_cb)  {}
+
+    timeout(const timeout&) = delete;
+    timeout& operator =(const timeout&) = delete;
+
+    timeout(timeout&&) = delete;
+    timeout& operator =(timeout&&) = delete;
+
+  public: /*interface*/
+    /*! \brief Set the timeout callback. */
+    on_timeout_t& on_timeout() noexcept  { return timeout_cb; }
+
+    /*! \brief Check if the timeout is currently armed. */
+    bool is_armed() const noexcept  { return wheel != nullptr; }
+
+    /*! \brief The loop time (in milliseconds) this timeout is scheduled to expire at.
+        \details Returns **0** if the timeout is not armed. */
+    uint64_t due() const noexcept;
+
+    /*! \brief Arm the timeout on the timer wheel to expire after `_timeout` milliseconds.
+        \details If the timeout is currently armed (on the same or another wheel) it is re-armed.
+        \sa `timer_wheel::arm()` */
+    int arm(timer_wheel &_wheel, uint64_t _timeout)  { return _wheel.arm(*this, _timeout); }
+
+    /*! \brief Re-arm the timeout on the same wheel it is currently armed (or has been expired or cancelled) on.
+        \details Returns `UV_EINVAL` if the timeout has never been armed.
+        \note The timeout holds a reference to the wheel it has last been armed on, so that the wheel exists as long as
+        the timeout does. */
+    int rearm(uint64_t _timeout);
+
+    /*! \brief Cancel the timeout. It is a no-op if the timeout is not armed. */
+    void cancel() noexcept;
+  };
+
+private: /*types*/
+  class instance
+  {
+  public: /*data*/
+    mutable int uv_error = 0;
+    ref_count refs;
+    timer driver;
+    uint64_t tick;
+    uint64_t base_time;
+    uint64_t curr_tick = 0;  // the next tick to be processed
+    std::size_t count = 0;  // the number of armed timeouts
+    on_expire_t expire_cb;
+    std::vector< timeout* > batch;
+    link slots[LEVELS][LEVEL_SIZE];
+
+  private: /*constructors*/
+    instance(uv::loop &_loop, uint64_t _tick)
+      : driver(_loop, _tick ? _tick : 1), tick(_tick ? _tick : 1), base_time(_loop.now())
+    {
+      uv_error = driver.uv_status();
+      driver.on_timer() = [this](timer){ expire(); };
+    }
+
+  public: /*constructors*/
+    ~instance()
+    {
+      driver.stop();
+      driver.on_timer() = nullptr;
+    }
+
+    instance(const instance&) = delete;
+    instance& operator =(const instance&) = delete;
+
+    instance(instance&&) = delete;
+    instance& operator =(instance&&) = delete;
+
+  private: /*functions*/
+    void destroy()  { delete this; }
+
+    uint64_t now() noexcept  { return ::uv_now(static_cast< timer::uv_t* >(driver)->loop); }
+    uint64_t elapsed_ticks(uint64_t _now) const noexcept  { return (_now - base_time)/tick; }
+
+    void insert(timeout &_t) noexcept
+    {
+      unsigned level = 0;
+      auto expires = _t.expires;
+      if (expires < curr_tick)
+        expires = curr_tick;
+      else
+      {
+        auto delta = expires - curr_tick;
+        if (delta >= (uint64_t(1) << (LEVEL_BITS*LEVELS)))  // place it into the farthest slot; its expiration time is kept intact
+        {
+          delta = (uint64_t(1) << (LEVEL_BITS*LEVELS)) - 1;
+          expires = curr_tick + delta;
+        }
+        while (level+1 < LEVELS and delta >= (uint64_t(1) << (LEVEL_BITS*(level+1))))  ++level;
+      }
+      slots[level][(expires >> (LEVEL_BITS*level)) & LEVEL_MASK].push_back(_t);
+    }
+
+    unsigned cascade(unsigned _level) noexcept
+    {
+      unsigned idx = (curr_tick >> (LEVEL_BITS*_level)) & LEVEL_MASK;
+
+      link l;
+      l.splice(slots[_level][idx]);
+      while (!l.empty())
+      {
+        auto t = static_cast< timeout* >(l.next);
+        t->link::unlink();
+        insert(*t);
+      }
+
+      return idx;
+    }
+
+    void acquire()
+    {
+      ref();  // REF:ARM -- make sure the wheel will exist while there are armed timeouts
+      driver.start(tick);
+    }
+    void release()
+    {
+      driver.stop();
+      unref();  // UNREF:EMPTY -- release the reference from acquire()
+    }
+
+    void expire()
+    {
+      ref_guard< instance > unref_wheel(*this);
+
+      auto target = elapsed_ticks(now());
+      while (count and curr_tick <= target)
+      {
+        unsigned idx = curr_tick & LEVEL_MASK;
+        if (idx == 0)  for (unsigned level = 1; level < LEVELS and cascade(level) == 0; ++level);
+        ++curr_tick;
+
+        link due;
+        due.splice(slots[0][idx]);
+        dispatch(due);
+      }
+    }
+
+    void dispatch(link &_due)
+    {
+      for (auto l = _due.next; l != &_due; )
+      {
+        auto t = static_cast< timeout* >(l);
+        l = l->next;
+        if (!t->timeout_cb)
+        {
+          t->link::unlink();
+          t->wheel = nullptr;
+          batch.push_back(t);
+        }
+      }
+      if (!batch.empty())
+      {
+        count -= batch.size();
+        if (count == 0)  release();  // the callback is able to re-arm the timeouts, which acquires the wheel again
+        if (expire_cb)  expire_cb(timer_wheel(this), batch);
+        batch.clear();
+      }
+
+      while (!_due.empty())  // the user callbacks are able to cancel or destroy the timeouts that are still in the list
+      {
+        auto t = static_cast< timeout* >(_due.next);
+        t->link::unlink();
+        t->wheel = nullptr;
+        if (--count == 0)  release();
+        t->timeout_cb(*t);
+      }
+    }
+
+  public: /*interface*/
+    static instance* create(uv::loop &_loop, uint64_t _tick)  { return new instance(_loop, _tick); }
+
+    void ref()  { refs.inc(); }
+    void unref()  { if (refs.dec() == 0)  destroy(); }
+
+    int arm(timeout &_t, uint64_t _timeout)
+    {
+      if (_t.wheel == this)
+        _t.link::unlink();
+      else
+        _t.cancel();
+
+      auto t = now();
+      if (count == 0 and curr_tick < elapsed_ticks(t))  curr_tick = elapsed_ticks(t);  // the wheel is empty, so fast forward it
+
+      _t.expires = (t - base_time + _timeout + tick - 1)/tick;
+      insert(_t);
+
+      if (_t.wheel != this)
+      {
+        _t.wheel = this;
+        if (count++ == 0)
+        {
+          acquire();
+          if (driver.uv_status() < 0)
+          {
+            _t.link::unlink();
+            _t.wheel = nullptr;
+            --count;
+            unref();
+            return uv_error = driver.uv_status();
+          }
+        }
+        if (_t.home != this)
+        {
+          ref();  // REF:HOME -- released when the timeout is armed on another wheel or destroyed
+          if (_t.home)  _t.home->unref();
+          _t.home = this;
+        }
+      }
+
+      return uv_error = 0;
+    }
+
+    void cancel(timeout &_t) noexcept
+    {
+      if (_t.wheel != this)  return;
+
+      _t.link::unlink();
+      _t.wheel = nullptr;
+      if (--count == 0)  release();
+    }
+
+    uint64_t due(const timeout &_t) const noexcept  { return base_time + _t.expires*tick; }
+  };
+
+private: /*data*/
+  instance *instance_ptr;
+
+private: /*constructors*/
+  explicit timer_wheel(instance *_instance_ptr)
+  {
+    if (_instance_ptr)  _instance_ptr->ref();
+    instance_ptr = _instance_ptr;
+  }
+
+public: /*constructors*/
+  ~timer_wheel()  { if (instance_ptr)  instance_ptr->unref(); }
+
+  /*! \brief Create a timer wheel on the given loop.
+      \details `_tick` is the wheel resolution in milliseconds. */
+  explicit timer_wheel(uv::loop &_loop, uint64_t _tick = 1) : instance_ptr(instance::create(_loop, _tick))  {}
+
+  timer_wheel(const timer_wheel &_that) : timer_wheel(_that.instance_ptr)  {}
+  timer_wheel& operator =(const timer_wheel &_that)
+  {
+    if (this != &_that)
+    {
+      if (_that.instance_ptr)  _that.instance_ptr->ref();
+      auto t = instance_ptr;
+      instance_ptr = _that.instance_ptr;
+      if (t)  t->unref();
+    }
+    return *this;
+  }
+
+  timer_wheel(timer_wheel &&_that) noexcept : instance_ptr(_that.instance_ptr)  { _that.instance_ptr = nullptr; }
+  timer_wheel& operator =(timer_wheel &&_that) noexcept
+  {
+    if (this != &_that)
+    {
+      auto t = instance_ptr;
+      instance_ptr = _that.instance_ptr;
+      _that.instance_ptr = nullptr;
+      if (t)  t->unref();
+    }
+    return *this;
+  }
+
+private: /*functions*/
+  static int64_t io_rdoffset(const io &_io) noexcept
+  { return io::instance::from(_io.uv_handle)->properties().rdoffset; }
+
+  static bool io_is_reading(const io &_io) noexcept
+  {
+    auto rdcmd_state = io::instance::from(_io.uv_handle)->properties().rdcmd_state;
+    return rdcmd_state == io::rdcmd::START or rdcmd_state == io::rdcmd::RESUME;
+  }
+
+public: /*interface*/
+  void swap(timer_wheel &_that) noexcept  { std::swap(instance_ptr, _that.instance_ptr); }
+  /*! \brief The current number of existing references to the same timer wheel as this variable refers to. */
+  long nrefs() const noexcept  { return instance_ptr->refs.get_value(); }
+  /*! \brief The status value returned by the last executed libuv API function. */
+  int uv_status() const noexcept  { return instance_ptr->uv_error; }
+
+  /*! \brief The libuv loop that drives the timer wheel. */
+  uv::loop loop() const noexcept  { return instance_ptr->driver.loop(); }
+
+  /*! \brief The timer wheel resolution in milliseconds. */
+  uint64_t tick() const noexcept  { return instance_ptr->tick; }
+
+  /*! \brief The number of currently armed timeouts. */
+  std::size_t size() const noexcept  { return instance_ptr->count; }
+
+  /*! \brief Set the callback receiving a batch of expired timeouts that have no callback of their own. */
+  on_expire_t& on_expire() const noexcept  { return instance_ptr->expire_cb; }
+
+  /*! \brief Arm the timeout to expire after `_timeout` milliseconds.
+      \details If the timeout is currently armed it is re-armed in O(1) time.
+      \note While there is at least one armed timeout the wheel holds an extra reference to itself,
+      which is released when the last timeout expires or is cancelled. */
+  int arm(timeout &_timeout, uint64_t _timeout_value) const  { return instance_ptr->arm(_timeout, _timeout_value); }
+
+  /*! \brief Cancel the timeout if it is armed on this wheel. */
+  void cancel(timeout &_timeout) const noexcept  { instance_ptr->cancel(_timeout); }
+
+public: /*conversion operators*/
+  explicit operator bool() const noexcept  { return (uv_status() >= 0); }  /*!< \brief Equivalent to `(uv_status() >= 0)`. */
+};
+
+
+inline uint64_t timer_wheel::timeout::due() const noexcept  { return wheel ? wheel->due(*this) : 0; }
+
+inline int timer_wheel::timeout::rearm(uint64_t _timeout)
+{
+  if (!home)  return UV_EINVAL;
+  return home->arm(*this, _timeout);
+}
+
+inline void timer_wheel::timeout::cancel() noexcept  { if (wheel)  wheel->cancel(*this); }
+
+
+
+/*! \ingroup doxy_group__timer_wheel
+    \brief Read and write inactivity timeouts for a `uv::stream` handle armed on a timer wheel.
+    \details The read timeout expires when no data has been read from the stream being in reading state
+    (see `io::read_start()`) during the read timeout interval. The write timeout expires when the stream has
+    pending data in its write queue (see `io::write_queue_size()`) and the write queue size has not decreased
+    during the write timeout interval.
+
+    The stream activity is not tracked on every read or write operation. Instead, the timeouts are armed once and
+    the stream state is checked when they expire: if there has been some progress since the previous check,
+    the timeout is silently re-armed. So there is no per-operation cost at all, and the timeout callback is called
+    no earlier than after one and no later than after two timeout intervals of inactivity.
+
+    After the timeout callback has been called the corresponding timeout is not re-armed automatically.
+    The object is not copyable and not movable. */
+class timer_wheel::stream_timeouts
+{
+public: /*types*/
+  using on_timeout_t = std::function< void(stream _handle, bool _write_side) >;
+  /*!< \brief The function type of the callback called when the read (`_write_side == false`) or
+       write (`_write_side == true`) timeout expires. */
+
+private: /*data*/
+  timer_wheel wheel;
+  stream stream_handle;
+  uint64_t rd_interval = 0;
+  uint64_t wr_interval = 0;
+  int64_t rd_mark = 0;
+  std::size_t wr_mark = 0;
+  timeout rd;
+  timeout wr;
+  on_timeout_t timeout_cb;
+
+public: /*constructors*/
+  ~stream_timeouts() = default;
+
+  /*! \brief Create the read/write timeouts for the stream `_stream` that are to be armed on the timer wheel `_wheel`. */
+  stream_timeouts(const timer_wheel &_wheel, const stream &_stream) : wheel(_wheel), stream_handle(_stream)
+  {
+    rd.on_timeout() = [this](timeout&){ read_check(); };
+    wr.on_timeout() = [this](timeout&){ write_check(); };
+  }
+
+  stream_timeouts(const stream_timeouts&) = delete;
+  stream_timeouts& operator =(const stream_timeouts&) = delete;
+
+  stream_timeouts(stream_timeouts&&) = delete;
+  stream_timeouts& operator =(stream_timeouts&&) = delete;
+
+private: /*functions*/
+  void read_check()
+  {
+    auto offset = io_rdoffset(stream_handle);
+    if (offset != rd_mark or !io_is_reading(stream_handle))
+    {
+      rd_mark = offset;
+      wheel.arm(rd, rd_interval);
+      return;
+    }
+    if (timeout_cb)  timeout_cb(stream_handle, false);
+  }
+
+  void write_check()
+  {
+    auto size = stream_handle.write_queue_size();
+    if (size == 0 or wr_mark == 0 or size < wr_mark)
+    {
+      wr_mark = size;
+      wheel.arm(wr, wr_interval);
+      return;
+    }
+    if (timeout_cb)  timeout_cb(stream_handle, true);
+  }
+
+public: /*interface*/
+  /*! \brief The stream which these timeouts are attached to. */
+  stream handle() const noexcept  { return stream_handle; }
+
+  /*! \brief Set the timeout callback. */
+  on_timeout_t& on_timeout() noexcept  { return timeout_cb; }
+
+  /*! \brief Arm the read timeout with the interval of `_timeout` milliseconds.
+      \details The zero value cancels the read timeout. */
+  int read_timeout(uint64_t _timeout)
+  {
+    rd_interval = _timeout;
+    if (_timeout == 0)
+    {
+      rd.cancel();
+      return 0;
+    }
+    rd_mark = io_rdoffset(stream_handle);
+    return wheel.arm(rd, _timeout);
+  }
+
+  /*! \brief Arm the write timeout with the interval of `_timeout` milliseconds.
+      \details The zero value cancels the write timeout. */
+  int write_timeout(uint64_t _timeout)
+  {
+    wr_interval = _timeout;
+    if (_timeout == 0)
+    {
+      wr.cancel();
+      return 0;
+    }
+    wr_mark = stream_handle.write_queue_size();
+    return wheel.arm(wr, _timeout);
+  }
+
+  /*! \brief Cancel both the read and write timeouts. */
+  void cancel() noexcept
+  {
+    rd.cancel();
+    wr.cancel();
+  }
+};
+
+
+}
+
+
+#endif
@@ -5,7 +5,7 @@
 #include "uvcc/debug.hpp"
 
 #include <cstddef>      // nullptr_t
-#include <type_traits>  // is_void is_convertible enable_if_t decay common_type aligned_storage
+#include <type_traits>  // is_void is_convertible enable_if_t decay common_type aligned_storage invoke_result_t result_of_t
 #include <atomic>       // atomic memory_order_* atomic_flag ATOMIC_FLAG_INIT
 #include <utility>      // forward() move()
 #include <memory>       // addressof()
@@ -138,6 +138,14 @@ template< std::size_t _index_, typename _T_, typename... _Ts_ > struct type_at<
 { using type = typename type_at< _index_-1, _Ts_... >::type; };
 //! \endcond
 
+/*! \brief The type of the result of calling a callable object of type `_F_` with the arguments of types `_Args_`.
+    \details The portable replacement for `std::result_of_t< _F_(_Args_...) >`, which is removed in C++20. */
+#if __cplusplus >= 201703L
+template< typename _F_, typename... _Args_ > using invoke_result_t = std::invoke_result_t< _F_, _Args_... >;
+#else
+template< typename _F_, typename... _Args_ > using invoke_result_t = std::result_of_t< _F_(_Args_...) >;
+#endif
+
 
 //! \cond
 template< typename _T_ >
@@ -0,0 +1,83 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <exception>
+#include <stdexcept>
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+uv::task< int64_t > file_size(uv::loop &_loop, const char *_path)
+{
+  uv::fs::stat st;
+  int status = co_await uv::co_run(st, _loop, _path);
+  if (status < 0)  throw std::runtime_error(uv_strerror(status));
+  co_return st.result().st_size;
+}
+
+uv::task<> sizes(uv::loop &_loop, int _argc, char *_argv[])
+{
+  for (int i = 1; i < _argc; ++i)
+  {
+    try
+    {
+      auto size = co_await file_size(_loop, _argv[i]);
+      fprintf(stdout, "%s: size=%lli\n", _argv[i], (long long)size);
+    }
+    catch (const std::exception &_e)
+    {
+      fprintf(stdout, "%s: %s\n", _argv[i], _e.what());
+    }
+    fflush(stdout);
+  }
+
+  uv::work< int > w;
+  int status = co_await uv::co_run(w, _loop, [](int _x){ return _x*_x; }, 12);
+  fprintf(stdout, "work: status=%i result=%i\n", status, w.result().get());
+  fflush(stdout);
+}
+
+uv::task<> failing(uv::loop &_loop)
+{
+  uv::work<> w;
+  co_await uv::co_run(w, _loop, [](){});
+  throw std::runtime_error("detached coroutine failure");
+}
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+
+  sizes(loop, _argc, _argv).wait(loop);
+
+  uv::on_detached_exception() = [](std::exception_ptr _e)
+  {
+    try  { std::rethrow_exception(_e); }
+    catch (const std::exception &_e)
+    {
+      fprintf(stdout, "on_detached_exception: %s\n", _e.what());
+      fflush(stdout);
+    }
+  };
+  {
+    auto t = failing(loop);  // detached when it goes out of scope
+  }
+  loop.run(UV_RUN_DEFAULT);
+
+  return 0;
+}
+
+#else
+
+int main(int _argc, char *_argv[])
+{
+  fprintf(stdout, "C++20 coroutines are not supported by the compiler\n");
+  fflush(stdout);
+  return 0;
+}
+
+#endif
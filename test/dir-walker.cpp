@@ -0,0 +1,151 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include <fcntl.h>  // O_*
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+constexpr const int FANOUT = 5;
+constexpr const int LEVELS = 3;
+constexpr const int FILES = 20;
+
+
+/* make a tree of FANOUT^LEVELS directories having FILES files each, and a subtree to be pruned */
+void make_tree(uv::loop &_loop, const std::string &_dir, int _level, int &_dirs, int &_files, uint64_t &_bytes)
+{
+  for (int i = 0; i < FILES; ++i)
+  {
+    uv::file f(_loop, (_dir + "/file" + std::to_string(i) + (i % 2 ? ".log" : ".dat")).c_str(), O_CREAT|O_WRONLY, 0644);
+    uv::fs::truncate tr;
+    tr.run(f, i);
+    ++_files;
+    _bytes += i;
+  }
+  if (_level == LEVELS)  return;
+
+  uv::fs::mkdir mkdir;
+  for (int i = 0; i < FANOUT; ++i)
+  {
+    auto sub = _dir + "/dir" + std::to_string(i);
+    mkdir.run(_loop, sub.c_str(), 0755);
+    ++_dirs;
+    make_tree(_loop, sub, _level + 1, _dirs, _files, _bytes);
+  }
+  if (_level == 0)
+  {
+    mkdir.run(_loop, (_dir + "/skip").c_str(), 0755);
+    uv::file(_loop, (_dir + "/skip/file.log").c_str(), O_CREAT|O_WRONLY, 0644);
+  }
+}
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+  const std::string parent = _argc > 1 ? _argv[1] : ".";
+
+  uv::fs::mkdtemp mkdtemp;
+  if (mkdtemp.run(loop, (parent + "/dir-walker-XXXXXX").c_str()) < 0)
+  {
+    fprintf(stdout, "mkdtemp: %s\n", uv_strerror(mkdtemp.uv_status()));
+    fflush(stdout);
+    return 0;
+  }
+  const std::string root = mkdtemp.path();
+
+  int dirs = 0, files = 0;
+  uint64_t bytes = 0;
+  make_tree(loop, root, 0, dirs, files, bytes);
+  loop.run(UV_RUN_DEFAULT);
+  fprintf(stdout, "tree: dirs=%i files=%i bytes=%llu (not counting the pruned subtree)\n", dirs, files, (unsigned long long)bytes);
+  fflush(stdout);
+
+  uv::dir_walker walker(loop);
+
+  // the *.log files with their sizes, the "skip" subtree pruned, with different concurrency
+  for (unsigned concurrency : { 1u, 8u })
+  {
+    uint64_t found = 0, size = 0, deepest = 0;
+    walker.concurrency(concurrency);
+    walker.stat_mode(uv::dir_walker::stat_kind::STATX);
+    walker.on_filter() = [](const uv::dir_walker::entry &_e)
+    {
+      auto len = std::strlen(_e.name);
+      return _e.type == UV_DIRENT_FILE and len > 4 and std::strcmp(_e.name + len - 4, ".log") == 0;
+    };
+    walker.on_prune() = [](const uv::dir_walker::entry &_e){ return std::strcmp(_e.name, "skip") == 0; };
+    walker.on_entries() = [&](const uv::dir_walker::entry *_entries, std::size_t _count)
+    {
+      for (std::size_t i = 0; i < _count; ++i)
+      {
+        ++found;
+        if (_entries[i].stat)  size += _entries[i].stat->st_size;
+        deepest = std::max(deepest, uint64_t(_entries[i].depth));
+      }
+    };
+    const uint64_t start = uv_hrtime();
+    walker.on_done() = [&, concurrency, start](int _status)
+    {
+      fprintf(stdout, "concurrency=%u: status=%i directories=%llu *.log files=%llu size=%llu deepest=%llu time=%.3fms\n", concurrency, _status,
+          (unsigned long long)walker.directories(), (unsigned long long)found, (unsigned long long)size, (unsigned long long)deepest, (uv_hrtime() - start)/1e6);
+      fflush(stdout);
+    };
+    walker.run(root);
+    loop.run(UV_RUN_DEFAULT);
+  }
+
+  walker.on_filter() = nullptr;
+  walker.on_prune() = nullptr;
+  walker.stat_mode(uv::dir_walker::stat_kind::NONE);
+
+  // stopped after the first batch
+  walker.on_entries() = [&walker](const uv::dir_walker::entry*, std::size_t){ walker.stop(); };
+  walker.on_done() = [&walker](int _status)
+  {
+    fprintf(stdout, "stopped: status=%s entries=%llu\n", _status < 0 ? uv_err_name(_status) : "0", (unsigned long long)walker.entries());
+    fflush(stdout);
+  };
+  walker.run(root);
+  loop.run(UV_RUN_DEFAULT);
+
+  // a missing root
+  walker.on_done() = [](int _status)
+  {
+    fprintf(stdout, "missing root: status=%s\n", _status < 0 ? uv_err_name(_status) : "0");
+    fflush(stdout);
+  };
+  walker.run(root + "/missing");
+  loop.run(UV_RUN_DEFAULT);
+
+  // remove the tree: the files first, then the directories, the deepest ones first
+  std::vector< std::string > files_found;
+  std::vector< std::pair< unsigned, std::string > > dirs_found;
+  walker.on_entries() = [&](const uv::dir_walker::entry *_entries, std::size_t _count)
+  {
+    for (std::size_t i = 0; i < _count; ++i)
+      if (_entries[i].type == UV_DIRENT_DIR)
+        dirs_found.emplace_back(_entries[i].depth, _entries[i].path);
+      else
+        files_found.emplace_back(_entries[i].path);
+  };
+  walker.on_done() = nullptr;
+  walker.run(root);
+  loop.run(UV_RUN_DEFAULT);
+
+  uv::fs::unlink unlink;
+  for (auto &f : files_found)  unlink.run(loop, f.c_str());
+  std::sort(dirs_found.begin(), dirs_found.end(), [](const std::pair< unsigned, std::string > &_a, const std::pair< unsigned, std::string > &_b){ return _a.first > _b.first; });
+  uv::fs::rmdir rmdir;
+  for (auto &d : dirs_found)  rmdir.run(loop, d.second.c_str());
+  fprintf(stdout, "cleanup: rmdir root=%i\n", rmdir.run(loop, root.c_str()));
+  fflush(stdout);
+
+  return 0;
+}
@@ -0,0 +1,49 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <chrono>
+#include <thread>
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::executor executor(4);
+
+  int low_done = 0;
+  for (int i = 0; i < 16; ++i)
+  {
+    uv::work< int > w;
+    w.on_request() = [&low_done](uv::work< int >){ ++low_done; };
+    w.run(uv::loop::Default(), executor, uv::executor::priority::LOW,
+        [i](){ std::this_thread::sleep_for(std::chrono::milliseconds(50)); return i; }
+    );
+  }
+
+  for (int i = 0; i < 8; ++i)
+  {
+    uv::work< int > w;
+    w.on_request() = [&low_done](uv::work< int > _work)
+    {
+      fprintf(stdout, "high priority work %i: wait=%.3fms run=%.3fms (low priority works done: %i)\n",
+          _work.result().get(), _work.executor_task().wait_time()/1e6, _work.executor_task().run_time()/1e6, low_done);
+      fflush(stdout);
+    };
+    w.run(uv::loop::Default(), executor, uv::executor::priority::HIGH,
+        [i](){ std::this_thread::sleep_for(std::chrono::milliseconds(1)); return i; }
+    );
+  }
+
+  executor.threads(8);
+
+  uv::loop::Default().run(UV_RUN_DEFAULT);
+
+  auto stats = executor.stats(uv::executor::priority::LOW);
+  fprintf(stdout, "low priority works: completed=%llu max_wait=%.3fms; stolen=%llu\n",
+      (unsigned long long)stats.completed, stats.max_wait_time/1e6, (unsigned long long)executor.stolen());
+  fflush(stdout);
+
+  return 0;
+}
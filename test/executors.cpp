@@ -0,0 +1,70 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <chrono>
+#include <thread>
+#include <fcntl.h>  // O_*
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+  const char *path = _argc > 1 ? _argv[1] : "/etc/hostname";
+
+  for (int isolated = 0; isolated < 2; ++isolated)
+  {
+    if (isolated)  uv::executors::isolate(2, 1, 4);
+
+    const uint64_t start = uv_hrtime();
+
+    // a burst of CPU-heavy work delays the file and DNS requests queued after it, unless they are isolated
+    for (int i = 0; i < 8; ++i)
+    {
+      uv::work<> w;
+      w.run(loop, [](){ std::this_thread::sleep_for(std::chrono::milliseconds(100)); });
+    }
+
+    uv::file f(loop, path, O_RDONLY, 0, [start](uv::file _f)
+    {
+      fprintf(stdout, "open: status=%i after %.1fms\n", _f.uv_status(), (uv_hrtime() - start)/1e6);
+      fflush(stdout);
+    });
+
+    uv::fs::stat st;
+    st.on_request() = [start](uv::fs::stat _st)
+    {
+      fprintf(stdout, "stat: status=%i size=%lli after %.1fms\n", _st.uv_status(), (long long)_st.result().st_size, (uv_hrtime() - start)/1e6);
+      fflush(stdout);
+    };
+    st.run(loop, path);
+    fprintf(stdout, "stat cancel: %i\n", st.cancel());  // UV_EBUSY for a routed request
+    fflush(stdout);
+
+    uv::getaddrinfo gai;
+    gai.on_request() = [start](uv::getaddrinfo _gai)
+    {
+      fprintf(stdout, "getaddrinfo: status=%i after %.1fms\n", _gai.uv_status(), (uv_hrtime() - start)/1e6);
+      fflush(stdout);
+    };
+    gai.run(loop, "localhost", nullptr);
+
+    fprintf(stdout, "isolated=%i: cpu queued=%zu fs pending=%zu dns pending=%zu\n", isolated,
+        uv::executors::queued(uv::executors::pool::CPU), uv::executors::pending(uv::executors::pool::FS), uv::executors::pending(uv::executors::pool::DNS));
+    fflush(stdout);
+
+    loop.run(UV_RUN_DEFAULT);
+
+    // the requests keep their own copies of the paths after completion
+    fprintf(stdout, "isolated=%i: file path=%s stat path=%s done after %.1fms\n", isolated, f.path(), st.path(), (uv_hrtime() - start)/1e6);
+    fflush(stdout);
+  }
+
+  uv::executors::reset(uv::executors::pool::FS);
+  uv::executors::reset(uv::executors::pool::DNS);
+  uv::executors::reset(uv::executors::pool::CPU);
+
+  return 0;
+}
@@ -0,0 +1,103 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <fcntl.h>  // O_*
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+void append(uv::file &_file, const std::string &_line)
+{
+  uv::buffer b{ _line.size() };
+  std::memcpy(b.base(), _line.data(), _line.size());
+  uv::fs::write wr;
+  wr.run(_file, b, -1);
+}
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+  const std::string path = _argc > 1 ? _argv[1] : "file-tailer.tmp";
+  const std::string rotated = path + ".1";
+
+  uv::file out(loop, path.c_str(), O_CREAT|O_WRONLY|O_TRUNC|O_APPEND, 0644);
+  append(out, "written before the start\n");
+
+  // only the data appended after the start is delivered
+  std::string expected, received;
+  int reads = 0;
+  uv::file_tailer tailer(loop, path);
+  tailer.on_reset() = [](uv::file _f, uv::file_tailer::reset _reason)
+  {
+    fprintf(stdout, "reset: %s\n", _reason == uv::file_tailer::reset::TRUNCATED ? "truncated" : "rotated");
+    fflush(stdout);
+  };
+  int ret = tailer.start(
+      [](uv::handle, std::size_t _suggested_size){ return uv::buffer{ _suggested_size }; },
+      [&received, &reads](uv::io, ssize_t _nread, uv::buffer _buf, int64_t, void*)
+      {
+        if (_nread < 0)
+        {
+          fprintf(stdout, "read: %s\n", uv_strerror(_nread));
+          fflush(stdout);
+        }
+        else
+        {
+          received.append(_buf.base(), _nread);
+          ++reads;
+        }
+      },
+      -1
+  );
+  fprintf(stdout, "start: %i\n", ret);
+  fflush(stdout);
+  if (ret < 0)  return 0;
+
+  int step = 0;
+  uv::timer writer(loop);
+  writer.on_timer() = [&](uv::timer _t)
+  {
+    std::string line = "line " + std::to_string(step) + "\n";
+    switch (step++)
+    {
+    case 10:
+        {
+          uv::fs::truncate tr;
+          tr.run(out, 0);
+        }
+        break;
+    case 15:
+        {
+          uv::fs::rename rn;
+          rn.run(loop, path.c_str(), rotated.c_str());
+          out = uv::file(loop, path.c_str(), O_CREAT|O_WRONLY|O_TRUNC|O_APPEND, 0644);
+        }
+        break;
+    case 20:
+        return;
+    case 25:
+        _t.stop();
+        tailer.stop();
+        return;
+    }
+    append(out, line);
+    expected += line;
+  };
+  writer.repeat_interval(20);
+  writer.start(20);
+
+  loop.run(UV_RUN_DEFAULT);
+
+  fprintf(stdout, "received %zu bytes in %i reads, equal to the appended data=%i, offset=%lli\n", received.size(), reads, received == expected, (long long)tailer.offset());
+  fflush(stdout);
+
+  uv::fs::unlink unlink;
+  unlink.run(loop, path.c_str());
+  unlink.run(loop, rotated.c_str());
+
+  return 0;
+}
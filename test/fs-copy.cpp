@@ -0,0 +1,120 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>     // O_*
+#include <sys/stat.h>  // stat()
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+constexpr const std::size_t MiB = 1 << 20;
+
+
+/* the source file is 1 MiB of data, 1 MiB hole, and 1 MiB of data */
+bool source_byte_ok(std::size_t _pos, char _c)  { return _c == (_pos >= MiB and _pos < 2*MiB ? 0 : 'D'); }
+
+
+void check(uv::loop &_loop, const char *_label, const char *_path, int _status, const uv::fs::copy &_copy)
+{
+  struct stat st;
+  ::stat(_path, &st);
+
+  uv::file f(_loop, _path, O_RDONLY, 0);
+  uv::mapped_file m(f);
+  std::size_t bad = 0;
+  for (std::size_t i = 0; m and i < m.size(); ++i)  bad += !source_byte_ok(i, m.data()[i]);
+
+  fprintf(stdout, "%s: status=%s copied=%llu total=%llu methods=%u size=%lli allocated=%lli bad=%zu\n", _label,
+      _status < 0 ? uv_err_name(_status) : "0", (unsigned long long)_copy.copied(), (unsigned long long)_copy.total(), _copy.methods(),
+      (long long)st.st_size, (long long)st.st_blocks*512, bad);
+  fflush(stdout);
+}
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+  const char *src_path = _argc > 1 ? _argv[1] : "fs-copy.src.tmp";
+  const char *dst_path = _argc > 2 ? _argv[2] : "fs-copy.dst.tmp";
+
+  {
+    uv::file f(loop, src_path, O_CREAT|O_WRONLY|O_TRUNC, 0644);
+    uv::buffer b{ MiB };
+    std::memset(b.base(), 'D', b.len());
+    uv::fs::write wr;
+    wr.run(f, b, 0);
+    wr.run(f, b, 2*MiB);
+  }
+
+  uv::file src(loop, src_path, O_RDONLY, 0);
+
+  // asynchronous sparse copy in concurrent chunks
+  {
+    uv::file dst(loop, dst_path, O_CREAT|O_RDWR|O_TRUNC, 0644);
+    uv::fs::copy c;
+    c.chunk_size(256*1024);
+    c.concurrency(4);
+    int progress = 0;
+    c.on_progress() = [&progress](uv::fs::copy, uint64_t, uint64_t){ ++progress; };
+    c.on_request() = [&loop, dst_path, &progress](uv::fs::copy _c)
+    {
+      fprintf(stdout, "progress callbacks: %i\n", progress);
+      check(loop, "sparse", dst_path, _c.uv_status(), _c);
+    };
+    c.run(dst, 0, src, 0);
+    loop.run(UV_RUN_DEFAULT);
+  }
+
+  // synchronous copy with the holes filled with zeros
+  {
+    uv::file dst(loop, dst_path, O_CREAT|O_RDWR|O_TRUNC, 0644);
+    uv::fs::copy c;
+    c.sparse(false);
+    int ret = c.run(dst, 0, src, 0);
+    check(loop, "not sparse", dst_path, ret, c);
+  }
+
+  // the range requested beyond the end of the source is cut at its end
+  {
+    uv::file dst(loop, dst_path, O_CREAT|O_RDWR|O_TRUNC, 0644);
+    uv::fs::copy c;
+    c.chunk_size(MiB);
+    c.on_request() = [&loop, dst_path](uv::fs::copy _c){ check(loop, "beyond the end", dst_path, _c.uv_status(), _c); };
+    c.run(dst, 0, src, 0, 10*MiB);
+    loop.run(UV_RUN_DEFAULT);
+  }
+
+  // the copy to an I/O endpoint is written at its current position
+  {
+    uv::file dst(loop, dst_path, O_CREAT|O_RDWR|O_TRUNC, 0644);
+    uv::io &out = dst;
+    uv::fs::copy c;
+    c.on_request() = [&loop, dst_path](uv::fs::copy _c){ check(loop, "to io", dst_path, _c.uv_status(), _c); };
+    c.run(out, src, 0);
+    loop.run(UV_RUN_DEFAULT);
+  }
+
+  // the copy stopped after the first chunk
+  {
+    uv::file dst(loop, dst_path, O_CREAT|O_RDWR|O_TRUNC, 0644);
+    uv::fs::copy c;
+    c.chunk_size(256*1024);
+    c.concurrency(1);
+    c.on_progress() = [](uv::fs::copy _c, uint64_t, uint64_t){ _c.stop(); };
+    c.on_request() = [](uv::fs::copy _c)
+    {
+      fprintf(stdout, "stopped: status=%s copied=%llu total=%llu\n", _c.uv_status() < 0 ? uv_err_name(_c.uv_status()) : "0", (unsigned long long)_c.copied(), (unsigned long long)_c.total());
+      fflush(stdout);
+    };
+    c.run(dst, 0, src, 0);
+    loop.run(UV_RUN_DEFAULT);
+  }
+
+  uv::fs::unlink unlink;
+  unlink.run(loop, src_path);
+  unlink.run(loop, dst_path);
+
+  return 0;
+}
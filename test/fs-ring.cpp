@@ -0,0 +1,116 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>  // O_*
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+constexpr const int BLOCKS = 2000;
+constexpr const std::size_t CHUNK = 4096;
+
+
+void pass(uv::loop &_loop, const char *_path, const char *_mode)
+{
+  uv::file f(_loop, _path, O_CREAT|O_RDWR|O_TRUNC, 0644);
+  if (!f)
+  {
+    fprintf(stdout, "%s: %s\n", _path, uv_strerror(f.uv_status()));
+    fflush(stdout);
+    return;
+  }
+
+  int failed = 0;
+  std::size_t bytes = 0;
+
+  uint64_t start = uv_hrtime();
+  for (int i = 0; i < BLOCKS; ++i)
+  {
+    uv::buffer b{ CHUNK };
+    std::memset(b.base(), 'a' + i % 26, b.len());
+    uv::fs::write wr;
+    wr.on_request() = [&failed, &bytes](uv::fs::write _wr, uv::buffer){ if (!_wr)  ++failed; else  bytes += _wr.uv_status(); };
+    wr.run(f, b, int64_t(i)*CHUNK);
+  }
+  _loop.run(UV_RUN_DEFAULT);
+  fprintf(stdout, "%s: write: bytes=%zu failed=%i time=%.3fms\n", _mode, bytes, failed, (uv_hrtime() - start)/1e6);
+
+  start = uv_hrtime();
+  uv::fs::sync sync;
+  sync.on_request() = [](uv::fs::sync _sync){ if (!_sync)  fprintf(stdout, "sync: %s\n", uv_strerror(_sync.uv_status())); };
+  sync.run(f);
+  _loop.run(UV_RUN_DEFAULT);
+  fprintf(stdout, "%s: sync: time=%.3fms\n", _mode, (uv_hrtime() - start)/1e6);
+
+  int mismatched = 0;
+  failed = 0;
+  start = uv_hrtime();
+  for (int i = 0; i < BLOCKS; ++i)
+  {
+    uv::buffer b{ CHUNK };
+    uv::fs::read rd;
+    rd.on_request() = [&failed, &mismatched, i](uv::fs::read _rd, uv::buffer _b)
+    {
+      if (!_rd or _rd.uv_status() != int(CHUNK))  ++failed;
+      else if (_b.base()[0] != 'a' + i % 26 or _b.base()[CHUNK - 1] != 'a' + i % 26)  ++mismatched;
+    };
+    rd.run(f, b, int64_t(i)*CHUNK);
+  }
+  _loop.run(UV_RUN_DEFAULT);
+  fprintf(stdout, "%s: read: failed=%i mismatched=%i time=%.3fms\n", _mode, failed, mismatched, (uv_hrtime() - start)/1e6);
+
+  start = uv_hrtime();
+  for (int i = 0; i < BLOCKS; ++i)
+  {
+    uv::fs::stat st;
+    st.on_request() = [&failed](uv::fs::stat _st){ if (!_st or _st.result().st_size != int64_t(BLOCKS*CHUNK))  ++failed; };
+    st.run(_loop, _path);
+  }
+  _loop.run(UV_RUN_DEFAULT);
+  fprintf(stdout, "%s: stat: failed=%i time=%.3fms\n", _mode, failed, (uv_hrtime() - start)/1e6);
+
+  // the file reads driven by the handle itself
+  bytes = 0;
+  start = uv_hrtime();
+  f.read_start(
+      [](uv::handle, std::size_t _suggested_size){ return uv::buffer{ _suggested_size }; },
+      [&bytes](uv::io _io, ssize_t _nread, uv::buffer, int64_t, void*)
+      {
+        if (_nread > 0)  bytes += _nread;
+        else  _io.read_stop();
+      },
+      0
+  );
+  _loop.run(UV_RUN_DEFAULT);
+  fprintf(stdout, "%s: read_start: bytes=%zu time=%.3fms\n", _mode, bytes, (uv_hrtime() - start)/1e6);
+  fflush(stdout);
+}
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+  const char *path = _argc > 1 ? _argv[1] : "fs-ring.tmp";
+
+  pass(loop, path, "thread pool");
+  {
+    uv::fs_ring ring(loop);
+    fprintf(stdout, "fs_ring: %s entries=%u enabled=%i\n", ring ? "ok" : uv_strerror(ring.uv_status()), ring.entries(), uv::fs_ring::is_enabled(loop));
+    fflush(stdout);
+    if (ring)
+    {
+      pass(loop, path, "io_uring");
+      fprintf(stdout, "fs_ring: pending=%zu status=%i\n", ring.pending(), ring.uv_status());
+      fflush(stdout);
+    }
+  }
+  fprintf(stdout, "fs_ring: enabled=%i after destruction\n", uv::fs_ring::is_enabled(loop));
+  fflush(stdout);
+
+  uv::fs::unlink unlink;
+  unlink.run(loop, path);
+
+  return 0;
+}
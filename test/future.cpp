@@ -0,0 +1,75 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+
+  auto answer = uv::queue_work(loop, [](int _x){ return _x*2; }, 21);
+  auto failure = uv::queue_work(loop, [](){ throw std::runtime_error("task failure"); });
+
+  // a continuation returning a future is unwrapped
+  answer.then([](uv::future< int > _f){ return _f.get() + 1; })
+        .then([&loop](uv::future< int > _f){ return uv::queue_work(loop, [](int _x){ return std::to_string(_x); }, _f.get()); })
+        .on_ready([](uv::future< std::string > _f)
+        {
+          fprintf(stdout, "then: %s\n", _f.get().c_str());
+          fflush(stdout);
+        });
+
+  uv::when_all(answer, failure).then([](uv::future< std::tuple< uv::future< int >, uv::future< void > > > _f)
+  {
+    auto &t = _f.get();
+    fprintf(stdout, "when_all: %i, exception=%i\n", std::get< 0 >(t).get(), std::get< 1 >(t).has_exception());
+    fflush(stdout);
+  });
+
+  std::vector< uv::future< int > > squares;
+  for (int i = 0; i < 10; ++i)  squares.push_back(uv::queue_work(loop, [](int _i){ return _i*_i; }, i));
+  uv::when_all(squares).then([](uv::future< std::vector< uv::future< int > > > _f)
+  {
+    int sum = 0;
+    for (auto &s : _f.get())  sum += s.get();
+    fprintf(stdout, "when_all: sum of squares=%i\n", sum);
+    fflush(stdout);
+  });
+  uv::when_any(squares).then([](uv::future< uv::when_any_result< std::vector< uv::future< int > > > > _f)
+  {
+    auto &r = _f.get();
+    fprintf(stdout, "when_any: first ready=%i\n", r.futures[r.index].get());
+    fflush(stdout);
+  });
+
+  for (int i = 1; i < _argc; ++i)
+  {
+    uv::fs::stat st;
+    uv::make_future(st, loop, _argv[i]).then([](uv::future< uv::fs::stat > _f)
+    {
+      if (_f.uv_status() < 0)
+        fprintf(stdout, "%s: %s\n", _f.get().path(), uv_strerror(_f.uv_status()));
+      else
+        fprintf(stdout, "%s: size=%lli\n", _f.get().path(), (long long)_f.get().result().st_size);
+      fflush(stdout);
+    });
+  }
+
+  loop.run(UV_RUN_DEFAULT);
+
+  try  { failure.get(); }
+  catch (const std::exception &_e)
+  {
+    fprintf(stdout, "failure: %s\n", _e.what());
+    fflush(stdout);
+  }
+
+  return 0;
+}
@@ -0,0 +1,78 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <fcntl.h>  // O_*
+#include <functional>
+#include <vector>
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+constexpr const int WRITERS = 50;
+constexpr const int RECORDS = 20;
+constexpr const std::size_t RECORD_SIZE = 100;
+
+
+/* each writer appends a record, syncs the file, and repeats after the sync is completed */
+void pass(uv::loop &_loop, const char *_path, bool _group_commit, uint64_t _window = 0)
+{
+  uv::file f(_loop, _path, O_CREAT|O_RDWR|O_TRUNC, 0644);
+  f.coalesce_writes(true);
+  f.group_commit(_group_commit, _window);
+
+  // the sync callbacks called in the same loop iteration are of the same commit round
+  long iteration = 0, last_iteration = -1, rounds = 0;
+  uv::prepare counter(_loop);
+  counter.start([&iteration](uv::prepare){ ++iteration; });
+
+  int written = 0, synced = 0, failed = 0, unordered = 0;
+  std::vector< int > records(WRITERS, 0);
+  std::vector< bool > record_written(WRITERS, false);
+  std::function< void(int) > next;
+
+  next = [&](int _writer)
+  {
+    uv::buffer b{ RECORD_SIZE };
+    uv::fs::write wr;
+    wr.on_request() = [&, _writer](uv::fs::write _wr, uv::buffer){ if (!_wr)  ++failed; ++written; record_written[_writer] = true; };
+    record_written[_writer] = false;
+    wr.run(f, b, -1);
+
+    uv::fs::sync sync;
+    sync.on_request() = [&, _writer](uv::fs::sync _sync)
+    {
+      if (!_sync)  ++failed;
+      if (!record_written[_writer])  ++unordered;  // the sync should cover the write run before it
+      if (iteration != last_iteration)  { last_iteration = iteration; ++rounds; }
+
+      if (++synced == WRITERS*RECORDS)  counter.stop();
+      if (++records[_writer] < RECORDS)  next(_writer);
+    };
+    sync.run(f);
+  };
+
+  const uint64_t start = uv_hrtime();
+  for (int i = 0; i < WRITERS; ++i)  next(i);
+  _loop.run(UV_RUN_DEFAULT);
+
+  fprintf(stdout, "group_commit=%i window=%llums: written=%i synced=%i failed=%i unordered=%i completion rounds=%li time=%.3fms\n",
+      _group_commit, (unsigned long long)_window, written, synced, failed, unordered, rounds, (uv_hrtime() - start)/1e6);
+  fflush(stdout);
+}
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+  const char *path = _argc > 1 ? _argv[1] : "group-commit.tmp";
+
+  pass(loop, path, false);
+  pass(loop, path, true);
+  pass(loop, path, true, 2);
+
+  uv::fs::unlink unlink;
+  unlink.run(loop, path);
+
+  return 0;
+}
@@ -0,0 +1,89 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+static unsigned long allocations = 0;
+
+void* operator new(std::size_t _size)
+{
+  ++allocations;
+  if (auto p = std::malloc(_size ? _size : 1))  return p;
+  throw std::bad_alloc();
+}
+void operator delete(void *_p) noexcept  { std::free(_p); }
+void operator delete(void *_p, std::size_t) noexcept  { std::free(_p); }
+
+
+constexpr const int RUNS = 100000;
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+
+  // lean_work run again from its own callback
+  {
+    long sum = 0;
+    int n = 0;
+    uv::lean_work< long > w;
+    w.on_request() = [&loop, &sum, &n](uv::lean_work< long > _w)
+    {
+      sum += _w.result();
+      if (++n < RUNS)  _w.run(loop, [](long _x){ return _x; }, long(n));
+    };
+    w.run(loop, [](long _x){ return _x; }, 0L);
+    loop.run(UV_RUN_ONCE);  // let the thread pool start up
+
+    auto a0 = allocations;
+    auto t0 = uv_hrtime();
+    loop.run(UV_RUN_DEFAULT);
+    fprintf(stdout, "lean_work: runs=%i sum=%li allocations=%lu (%.3f per run) %.3fus per run\n",
+        n, sum, allocations - a0, double(allocations - a0)/n, (uv_hrtime() - t0)/1e3/n);
+    fflush(stdout);
+  }
+
+  // the same with uv::work
+  {
+    long sum = 0;
+    int n = 0;
+    uv::work< long > w;
+    w.on_request() = [&loop, &sum, &n](uv::work< long > _w)
+    {
+      sum += _w.result().get();
+      if (++n < RUNS)  _w.run(loop, [](long _x){ return _x; }, long(n));
+    };
+
+    auto a0 = allocations;
+    auto t0 = uv_hrtime();
+    w.run(loop, [](long _x){ return _x; }, 0L);
+    loop.run(UV_RUN_DEFAULT);
+    fprintf(stdout, "work: runs=%i sum=%li allocations=%lu (%.3f per run) %.3fus per run\n",
+        n, sum, allocations - a0, double(allocations - a0)/n, (uv_hrtime() - t0)/1e3/n);
+    fflush(stdout);
+  }
+
+  // an exception escaped from the task
+  {
+    uv::lean_work<> w;
+    w.on_request() = [](uv::lean_work<> _w)
+    {
+      try  { _w.result(); }
+      catch (const std::exception &_e)
+      {
+        fprintf(stdout, "lean_work exception: has_exception=%i what=%s\n", _w.has_exception(), _e.what());
+        fflush(stdout);
+      }
+    };
+    w.run(loop, [](){ throw std::runtime_error("task failure"); });
+    loop.run(UV_RUN_DEFAULT);
+  }
+
+  return 0;
+}
@@ -0,0 +1,78 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>  // O_*
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+constexpr const std::size_t SIZE = 1 << 20;
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+  const char *src_path = _argc > 1 ? _argv[1] : "mapped-file.src.tmp";
+  const char *dst_path = _argc > 2 ? _argv[2] : "mapped-file.dst.tmp";
+
+  // a source file of distinguishable bytes
+  {
+    uv::file f(loop, src_path, O_CREAT|O_WRONLY|O_TRUNC, 0644);
+    uv::buffer b{ SIZE };
+    for (std::size_t i = 0; i < SIZE; ++i)  b.base()[i] = static_cast< char >(i % 251);
+    uv::fs::write wr;
+    fprintf(stdout, "source: %s written=%i\n", src_path, wr.run(f, b, 0));
+    fflush(stdout);
+  }
+
+  uv::file src(loop, src_path, O_RDONLY, 0);
+  uv::mapped_file m(src);
+  fprintf(stdout, "map: status=%i size=%zu offset=%lli nrefs=%li\n", m.uv_status(), m.size(), (long long)m.offset(), m.nrefs());
+  fflush(stdout);
+  if (!m)  return 0;
+  m.advise(uv::mapped_file::advice::SEQUENTIAL);
+
+  bool same = true;
+  for (std::size_t i = 0; i < SIZE; ++i)  if (m.data()[i] != static_cast< char >(i % 251))  { same = false; break; }
+
+  // the views refer to the mapping
+  uv::buffer whole = m.view();
+  uv::buffer part = m.view(1000, 10);
+  uv::buffer beyond = m.view(SIZE);
+  fprintf(stdout, "view: same=%i whole=%zu part=%zu at data+%lli beyond=%i nrefs=%li\n", same, whole.len(), part.len(),
+      (long long)(part.base() - m.data()), beyond.base() != nullptr, m.nrefs());
+  fflush(stdout);
+
+  // the data is written from the mapping without an intermediate copy
+  uv::file dst(loop, dst_path, O_CREAT|O_RDWR|O_TRUNC, 0644);
+  uv::fs::write wr;
+  wr.on_request() = [&dst](uv::fs::write _wr, uv::buffer _buf)
+  {
+    uv::mapped_file copy(dst);
+    fprintf(stdout, "fs::write: status=%i equal=%i\n", _wr.uv_status(), copy and copy.size() == _buf.len() and std::memcmp(copy.data(), _buf.base(), _buf.len()) == 0);
+    fflush(stdout);
+  };
+  wr.run(dst, whole, 0);
+  loop.run(UV_RUN_DEFAULT);
+
+  // moving the window keeps the previous mapping alive for the buffers obtained earlier
+  m.map(src, 300000, 4096);
+  fprintf(stdout, "window: status=%i size=%zu offset=%lli first byte ok=%i, old view still readable=%i\n", m.uv_status(), m.size(),
+      (long long)m.offset(), m.data()[0] == static_cast< char >(300000 % 251), part.base()[0] == static_cast< char >(1000 % 251));
+  int locked = m.lock();
+  fprintf(stdout, "lock: %i unlock: %i\n", locked, m.unlock());
+  fflush(stdout);
+
+  whole = uv::buffer();
+  part = uv::buffer();
+  fprintf(stdout, "release: nrefs=%li\n", m.nrefs());
+  fflush(stdout);
+
+  uv::fs::unlink unlink;
+  unlink.run(loop, src_path);
+  unlink.run(loop, dst_path);
+
+  return 0;
+}
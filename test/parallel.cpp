@@ -0,0 +1,69 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+
+  std::vector< int > v(1000000);
+  std::mt19937 rng(1);
+  for (auto &x : v)  x = rng() % 1000000;
+
+  fprintf(stdout, "workers: %u\n", uv::parallel_workers());
+  fflush(stdout);
+
+  uv::parallel_reduce(loop, v.begin(), v.end(), 0LL).then([&v](uv::future< long long > _f)
+  {
+    long long sum = 0;
+    for (auto x : v)  sum += x;
+    fprintf(stdout, "parallel_reduce: %lli (expected %lli)\n", _f.get(), sum);
+    fflush(stdout);
+  });
+  uv::parallel_count_if(loop, v.begin(), v.end(), [](int _x){ return _x < 1000; }).then([&v](uv::future< long > _f)
+  {
+    fprintf(stdout, "parallel_count_if: %li (expected %li)\n", _f.get(), (long)std::count_if(v.begin(), v.end(), [](int _x){ return _x < 1000; }));
+    fflush(stdout);
+  });
+  uv::parallel_for(loop, v.begin(), v.end(), [](int &_x){ if (_x < 10)  throw std::runtime_error("small value"); }).then([](uv::future< void > _f)
+  {
+    fprintf(stdout, "parallel_for: exception=%i\n", _f.has_exception());
+    fflush(stdout);
+  });
+  loop.run(UV_RUN_DEFAULT);
+
+  auto t0 = uv_hrtime();
+  uv::parallel_sort(loop, v.begin(), v.end()).then([&v, t0](uv::future< void > _f)
+  {
+    _f.get();
+    fprintf(stdout, "parallel_sort: sorted=%i time=%.3fms\n", std::is_sorted(v.begin(), v.end()), (uv_hrtime() - t0)/1e6);
+    fflush(stdout);
+  });
+  loop.run(UV_RUN_DEFAULT);
+
+  // the tasks are routed to the CPU executor and are as many as its threads
+  uv::executor cpu(3);
+  uv::executors::assign(uv::executors::pool::CPU, cpu);
+  fprintf(stdout, "workers with the CPU executor: %u\n", uv::parallel_workers());
+  fflush(stdout);
+
+  std::vector< long > out(v.size());
+  uv::parallel_transform(loop, v.begin(), v.end(), out.begin(), [](int _x){ return -long(_x); }).then([&v, &out](uv::future< std::vector< long >::iterator > _f)
+  {
+    fprintf(stdout, "parallel_transform: complete=%i out[10]=%li v[10]=%i\n", _f.get() == out.end(), out[10], v[10]);
+    fflush(stdout);
+  });
+  loop.run(UV_RUN_DEFAULT);
+
+  uv::executors::reset(uv::executors::pool::CPU);
+
+  return 0;
+}
@@ -0,0 +1,68 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+constexpr const int TASKS = 10000;
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+
+  // the batch completes once
+  {
+    std::vector< std::function< long() > > tasks;
+    for (int i = 0; i < TASKS; ++i)  tasks.emplace_back([i](){ return long(i)*i; });
+
+    const uint64_t start = uv_hrtime();
+    uv::queue_batch(loop, std::move(tasks)).then([start](uv::future< std::vector< long > > _f)
+    {
+      long sum = 0;
+      for (auto r : _f.get())  sum += r;
+      fprintf(stdout, "queue_batch: tasks=%zu sum=%li time=%.3fms\n", _f.get().size(), sum, (uv_hrtime() - start)/1e6);
+      fflush(stdout);
+    });
+    loop.run(UV_RUN_DEFAULT);
+  }
+
+  // the same tasks as separate work requests
+  {
+    long sum = 0;
+    int completed = 0;
+    const uint64_t start = uv_hrtime();
+    for (int i = 0; i < TASKS; ++i)
+    {
+      uv::work< long > w;
+      w.on_request() = [&sum, &completed](uv::work< long > _w){ sum += _w.result().get(); ++completed; };
+      w.run(loop, [i](){ return long(i)*i; });
+    }
+    loop.run(UV_RUN_DEFAULT);
+    fprintf(stdout, "work: tasks=%i sum=%li time=%.3fms\n", completed, sum, (uv_hrtime() - start)/1e6);
+    fflush(stdout);
+  }
+
+  // a failing task stops the batch
+  {
+    std::vector< std::function< void() > > tasks(TASKS, [](){});
+    tasks[TASKS/2] = [](){ throw std::runtime_error("task failure"); };
+    uv::queue_batch(loop, std::move(tasks)).then([](uv::future< void > _f)
+    {
+      try  { _f.get(); }
+      catch (const std::exception &_e)
+      {
+        fprintf(stdout, "queue_batch: %s\n", _e.what());
+        fflush(stdout);
+      }
+    });
+    loop.run(UV_RUN_DEFAULT);
+  }
+
+  return 0;
+}
@@ -0,0 +1,105 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <string>
+#include <fcntl.h>  // O_*
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+constexpr const int FILES = 20000;
+constexpr const int DIRS = 10;
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+  const std::string parent = _argc > 1 ? _argv[1] : ".";
+
+  uv::fs::mkdtemp mkdtemp;
+  if (mkdtemp.run(loop, (parent + "/readdir-XXXXXX").c_str()) < 0)
+  {
+    fprintf(stdout, "mkdtemp: %s\n", uv_strerror(mkdtemp.uv_status()));
+    fflush(stdout);
+    return 0;
+  }
+  const std::string dir = mkdtemp.path();
+
+  for (int i = 0; i < FILES; ++i)  uv::file(loop, (dir + "/file" + std::to_string(i)).c_str(), O_CREAT|O_WRONLY, 0644);
+  uv::fs::mkdir mkdir;
+  for (int i = 0; i < DIRS; ++i)  mkdir.run(loop, (dir + "/dir" + std::to_string(i)).c_str(), 0755);
+  uv::fs::link symlink;
+  symlink.run(loop, "file0", (dir + "/link").c_str(), true);
+  loop.run(UV_RUN_DEFAULT);
+
+  // the entries are streamed in batches of the buffer size
+  {
+    uv::fs::readdir rd;
+    rd.buffer_size(4096);
+    int files = 0, dirs = 0, links = 0, other = 0, batches = 0;
+    std::size_t max_batch = 0;
+    double first = 0;
+    const uint64_t start = uv_hrtime();
+    rd.on_request() = [&](uv::fs::readdir _rd)
+    {
+      if (_rd.uv_status() < 0)
+      {
+        fprintf(stdout, "readdir: %s\n", uv_strerror(_rd.uv_status()));
+        fflush(stdout);
+        return;
+      }
+      if (batches++ == 0)  first = (uv_hrtime() - start)/1e6;
+      if (_rd.count() > max_batch)  max_batch = _rd.count();
+      for (auto &e : _rd)  switch (e.type)
+      {
+        case UV_DIRENT_FILE:  ++files;  break;
+        case UV_DIRENT_DIR:   ++dirs;   break;
+        case UV_DIRENT_LINK:  ++links;  break;
+        default:              ++other;  break;
+      }
+      if (!_rd.eof())  _rd.next();
+    };
+    rd.run(loop, dir.c_str());
+    loop.run(UV_RUN_DEFAULT);
+    fprintf(stdout, "readdir: files=%i dirs=%i links=%i other=%i batches=%i max batch=%zu first batch after %.3fms, time=%.3fms\n",
+        files, dirs, links, other, batches, max_batch, first, (uv_hrtime() - start)/1e6);
+    fflush(stdout);
+  }
+
+  // synchronous reading, closed before the end
+  {
+    uv::fs::readdir rd;
+    int n = rd.run(loop, dir.c_str());
+    int m = rd.next();
+    rd.close();
+    fprintf(stdout, "readdir sync: first batch=%i second batch=%i eof after close=%i\n", n, m, rd.eof());
+    fflush(stdout);
+  }
+
+  // the whole directory loaded at once
+  {
+    uv::fs::scandir sd;
+    const uint64_t start = uv_hrtime();
+    sd.on_request() = [start](uv::fs::scandir _sd)
+    {
+      double first = (uv_hrtime() - start)/1e6;
+      int n = 0;
+      uv_dirent_t e;
+      while (_sd.scandir_next(e) == 0)  ++n;
+      fprintf(stdout, "scandir: entries=%i first entry after %.3fms\n", n, first);
+      fflush(stdout);
+    };
+    sd.run(loop, dir.c_str());
+    loop.run(UV_RUN_DEFAULT);
+  }
+
+  uv::fs::unlink unlink;
+  for (int i = 0; i < FILES; ++i)  unlink.run(loop, (dir + "/file" + std::to_string(i)).c_str());
+  unlink.run(loop, (dir + "/link").c_str());
+  uv::fs::rmdir rmdir;
+  for (int i = 0; i < DIRS; ++i)  rmdir.run(loop, (dir + "/dir" + std::to_string(i)).c_str());
+  rmdir.run(loop, dir.c_str());
+
+  return 0;
+}
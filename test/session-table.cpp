@@ -0,0 +1,136 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <vector>
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+constexpr const int PEERS = 100000;
+constexpr const int CLIENTS = 5;
+constexpr const int DATAGRAMS = 100;
+
+
+struct session
+{
+  int id = -1;
+  long packets = 0;
+  std::size_t bytes = 0;
+};
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+
+  // lookups over synthetic IPv4 and IPv6 peer addresses
+  {
+    uv::udp_session_table< session > table(loop);
+    std::vector< sockaddr_in > v4(PEERS);
+    std::vector< sockaddr_in6 > v6(PEERS);
+    for (int i = 0; i < PEERS; ++i)
+    {
+      uv_ip4_addr("10.0.0.0", 1024 + i % 50000, &v4[i]);
+      v4[i].sin_addr.s_addr = uv::hton32(0x0A000000 | i/50000);
+      uv_ip6_addr("fd00::1", 1024 + i % 50000, &v6[i]);
+      v6[i].sin6_addr.s6_addr[0] ^= i/50000;
+    }
+
+    uint64_t start = uv_hrtime();
+    for (int i = 0; i < PEERS; ++i)
+    {
+      table.get(v4[i])->id = i;
+      table.get(v6[i])->id = PEERS + i;
+    }
+    fprintf(stdout, "get: sessions=%zu time=%.3fms\n", table.size(), (uv_hrtime() - start)/1e6);
+
+    start = uv_hrtime();
+    int found = 0;
+    for (int i = 0; i < PEERS; ++i)
+    {
+      auto s4 = table.find(v4[i]);
+      auto s6 = table.find(v6[i]);
+      found += (s4 and s4->id == i) + (s6 and s6->id == PEERS + i);
+    }
+    fprintf(stdout, "find: found=%i time=%.3fms\n", found, (uv_hrtime() - start)/1e6);
+
+    int erased = 0;
+    for (int i = 0; i < PEERS; i += 2)  erased += table.erase(v4[i]);
+    found = 0;
+    for (int i = 0; i < PEERS; ++i)  found += (table.find(v4[i]) != nullptr) + (table.find(v6[i]) != nullptr);
+    fprintf(stdout, "erase: erased=%i sessions=%zu found=%i\n", erased, table.size(), found);
+    fflush(stdout);
+  }
+
+  // datagrams from several clients, one of them refused, dispatched to the sessions which are evicted when idle
+  uv::udp_session_table< session > table(loop);
+  table.idle_timeout(100);
+
+  uv::udp rx(loop, AF_INET);
+  sockaddr_in addr;
+  uv_ip4_addr("127.0.0.1", 0, &addr);
+  rx.bind(addr);
+  rx.getsockname(addr);
+  rx.recv_buffer_size(8 << 20);
+
+  std::vector< uv::udp > clients;
+  std::vector< sockaddr_in > client_addr(CLIENTS);
+  for (int i = 0; i < CLIENTS; ++i)
+  {
+    clients.emplace_back(loop, AF_INET);
+    uv_ip4_addr("127.0.0.1", 0, &client_addr[i]);
+    clients[i].bind(client_addr[i]);
+    clients[i].getsockname(client_addr[i]);
+  }
+
+  int accepted = 0;
+  table.on_accept() = [&](const sockaddr *_peer, session &_s)
+  {
+    auto port = reinterpret_cast< const sockaddr_in* >(_peer)->sin_port;
+    if (port == client_addr[CLIENTS - 1].sin_port)  return false;
+    _s.id = accepted++;
+    return true;
+  };
+  table.on_packet() = [](session &_s, const uv_buf_t &_data, const uv::buffer&, const uv::udp::io_info&)
+  {
+    ++_s.packets;
+    _s.bytes += _data.len;
+  };
+  table.on_evict() = [](const sockaddr*, session &_s)
+  {
+    fprintf(stdout, "evict: session %i packets=%li bytes=%zu\n", _s.id, _s.packets, _s.bytes);
+    fflush(stdout);
+  };
+  rx.recv_batch_start(table.batch_receiver());
+
+  for (int i = 0; i < CLIENTS; ++i)
+    for (int j = 0; j < DATAGRAMS; ++j)
+    {
+      uv::udp_send s;
+      s.run(clients[i], uv::buffer{ std::size_t(10*(i + 1)) }, addr);
+    }
+
+  loop.update_time();  // the lookups above have taken a while
+  uv::timer t1(loop);
+  t1.on_timer() = [&](uv::timer)
+  {
+    fprintf(stdout, "sessions=%zu accepted=%i\n", table.size(), accepted);
+    table.for_each([](const sockaddr*, session &_s){ fprintf(stdout, "session %i: packets=%li\n", _s.id, _s.packets); });
+    fflush(stdout);
+  };
+  t1.start(50);
+
+  uv::timer t2(loop);
+  t2.on_timer() = [&](uv::timer)
+  {
+    fprintf(stdout, "sessions=%zu after the idle timeout\n", table.size());
+    fflush(stdout);
+    rx.recv_batch_stop();
+  };
+  t2.start(400);
+
+  loop.run(UV_RUN_DEFAULT);
+
+  return 0;
+}
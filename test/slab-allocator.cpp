@@ -0,0 +1,84 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <deque>
+#include <utility>
+#include <sys/socket.h>  // socket() sendto()
+#include <unistd.h>      // close()
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+constexpr const int DATAGRAMS = 20000;
+constexpr const std::size_t HELD = 100;
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+
+  uv::udp rx(loop, AF_INET);
+  sockaddr_in addr;
+  uv_ip4_addr("127.0.0.1", 0, &addr);
+  rx.bind(addr);
+  rx.getsockname(addr);
+  rx.recv_buffer_size(8 << 20);
+
+  // 1500 bytes per datagram at most, 64 KiB slabs, two released slabs kept for reuse
+  uv::slab_allocator slab(1500, 64*1024, 2);
+
+  // hold the last received packets to check that the slab memory is not reused while they are alive
+  std::deque< std::pair< uv::buffer, char > > held;
+  long received = 0, adjacent = 0;
+  bool intact = true;
+  const char *prev = nullptr;
+
+  rx.recv_start(slab, [&](uv::io, ssize_t _nread, uv::buffer _buf, int64_t, void*)
+  {
+    if (_nread <= 0)  return;
+    ++received;
+    if (_buf.len() != static_cast< std::size_t >(_nread))  intact = false;
+    if (prev and _buf.base() > prev and _buf.base() - prev < 300)  ++adjacent;
+    prev = _buf.base();
+
+    for (auto &h : held)  if (h.first.base()[0] != h.second)  intact = false;
+    held.emplace_back(_buf, _buf.base()[0]);
+    if (held.size() > HELD)  held.pop_front();
+  });
+
+  int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+  int sent = 0;
+
+  uv::timer sender(loop);
+  sender.on_timer() = [&](uv::timer _t)
+  {
+    char msg[200] = {};
+    for (int i = 0; i < 100 and sent < DATAGRAMS; ++i)
+    {
+      msg[0] = static_cast< char >(++sent & 0x7F);
+      ::sendto(fd, msg, sizeof(msg), 0, reinterpret_cast< sockaddr* >(&addr), sizeof(addr));
+    }
+    if (sent < DATAGRAMS)  return;
+
+    _t.stop();
+    uv::timer stopper(loop);
+    stopper.on_timer() = [&rx](uv::timer){ rx.read_stop(); };
+    stopper.start(100);
+  };
+  sender.repeat_interval(1);
+  sender.start(1);
+
+  loop.run(UV_RUN_DEFAULT);
+  ::close(fd);
+
+  fprintf(stdout, "slab_allocator: received=%li intact=%i adjacent=%li slabs=%zu (holding %zu packets)\n",
+      received, intact, adjacent, slab.slab_count(), held.size());
+  fflush(stdout);
+
+  held.clear();
+  fprintf(stdout, "slab_allocator: slabs=%zu after release (max kept %zu)\n", slab.slab_count(), slab.max_free());
+  fflush(stdout);
+
+  return 0;
+}
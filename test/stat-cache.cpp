@@ -0,0 +1,103 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <string>
+#include <fcntl.h>  // O_*
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+constexpr const int LOOKUPS = 10000;
+
+
+/* let the loop process the file system events */
+void settle(uv::loop &_loop)
+{
+  uv::timer t(_loop);
+  t.start(100, [](uv::timer){});
+  _loop.run(UV_RUN_DEFAULT);
+}
+
+void append(uv::loop &_loop, const std::string &_path, std::size_t _size)
+{
+  uv::file f(_loop, _path.c_str(), O_CREAT|O_WRONLY|O_APPEND, 0644);
+  uv::fs::write wr;
+  wr.run(f, uv::buffer{ _size }, -1);
+}
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+  const std::string path = _argc > 1 ? _argv[1] : "stat-cache.tmp";
+  const std::string missing = path + ".missing";
+
+  uv::fs::unlink unlink;
+  unlink.run(loop, path.c_str());
+  unlink.run(loop, missing.c_str());
+  append(loop, path, 100);
+
+  uv::stat_cache cache(loop, 60000, 60000);
+
+  auto report = [&cache](const char *_label)
+  {
+    return [&cache, _label](int _status, const uv_stat_t &_st)
+    {
+      if (_status < 0)
+        fprintf(stdout, "%s: %s hits=%llu misses=%llu\n", _label, uv_err_name(_status), (unsigned long long)cache.hits(), (unsigned long long)cache.misses());
+      else
+        fprintf(stdout, "%s: size=%lli hits=%llu misses=%llu\n", _label, (long long)_st.st_size, (unsigned long long)cache.hits(), (unsigned long long)cache.misses());
+      fflush(stdout);
+    };
+  };
+
+  // concurrent lookups share one request, the following ones are served from the cache
+  {
+    int completed = 0;
+    uint64_t start = uv_hrtime();
+    for (int i = 0; i < LOOKUPS; ++i)  cache.lookup(path, [&completed](int, const uv_stat_t&){ ++completed; });
+    loop.run(UV_RUN_DEFAULT);
+    for (int i = 0; i < LOOKUPS; ++i)  cache.lookup(path, [&completed](int, const uv_stat_t&){ ++completed; });
+    fprintf(stdout, "stat_cache: lookups=%i hits=%llu misses=%llu watched dirs=%zu time=%.3fms\n", completed,
+        (unsigned long long)cache.hits(), (unsigned long long)cache.misses(), cache.watched_dirs(), (uv_hrtime() - start)/1e6);
+
+    completed = 0;
+    start = uv_hrtime();
+    for (int i = 0; i < 2*LOOKUPS; ++i)
+    {
+      uv::fs::stat st;
+      st.on_request() = [&completed](uv::fs::stat){ ++completed; };
+      st.run(loop, path.c_str());
+    }
+    loop.run(UV_RUN_DEFAULT);
+    fprintf(stdout, "fs::stat: lookups=%i time=%.3fms\n", completed, (uv_hrtime() - start)/1e6);
+    fflush(stdout);
+  }
+
+  // a change of the file invalidates the entry before the TTL expires
+  append(loop, path, 50);
+  settle(loop);
+  cache.lookup(path, report("after append"));
+  loop.run(UV_RUN_DEFAULT);
+
+  // negative entries
+  cache.lookup(missing, report("missing"));
+  loop.run(UV_RUN_DEFAULT);
+  cache.lookup(missing, report("missing again"));
+  append(loop, missing, 10);
+  settle(loop);
+  cache.lookup(missing, report("after creation"));
+  loop.run(UV_RUN_DEFAULT);
+
+  unlink.run(loop, path.c_str());
+  unlink.run(loop, missing.c_str());
+  settle(loop);
+  cache.lookup(path, report("after deletion"));
+  loop.run(UV_RUN_DEFAULT);
+
+  fprintf(stdout, "stat_cache: entries=%zu\n", cache.size());
+  fflush(stdout);
+
+  return 0;
+}
@@ -0,0 +1,107 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+
+  // a slow consumer throttles the producer to the request capacity
+  {
+    uv::streaming_work< int > w;
+    w.capacity(4);
+
+    int expected = 0, delivered = 0;
+    bool ordered = true;
+    std::atomic< int > emitted{0};
+    int max_ahead = 0;
+
+    w.on_item() = [&](uv::streaming_work< int > _w, int &_i)
+    {
+      if (_i != expected++)  ordered = false;
+      ++delivered;
+      if (emitted - delivered > max_ahead)  max_ahead = emitted - delivered;
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+      if (_i == 500)
+      {
+        // suspend the delivery for a while
+        _w.pause();
+        uv::timer t(loop);
+        t.on_timer() = [_w](uv::timer){ _w.resume(); };
+        t.start(50);
+      }
+    };
+    w.on_request() = [&](uv::streaming_work< int > _w)
+    {
+      fprintf(stdout, "streaming_work: status=%i delivered=%i ordered=%i max_ahead=%i capacity=%zu\n",
+          _w.uv_status(), delivered, ordered, max_ahead, _w.capacity());
+      fflush(stdout);
+    };
+
+    w.run(loop, [&emitted](uv::streaming_work< int >::producer &_p, int _n)
+    {
+      for (int i = 0; i < _n; ++i)
+      {
+        if (!_p.emit(i))  break;
+        ++emitted;
+      }
+    }, 1000);
+    loop.run(UV_RUN_DEFAULT);
+  }
+
+  // stop() makes the further emitting fail
+  {
+    uv::streaming_work< std::string > w;
+    int delivered = 0;
+    std::atomic< bool > failed{false};
+
+    w.on_item() = [&delivered](uv::streaming_work< std::string > _w, std::string&){ if (++delivered == 10)  _w.stop(); };
+    w.on_request() = [&](uv::streaming_work< std::string >)
+    {
+      fprintf(stdout, "streaming_work: stopped after %i items, emit failed=%i\n", delivered, (int)failed);
+      fflush(stdout);
+    };
+
+    w.run(loop, [&failed](uv::streaming_work< std::string >::producer &_p)
+    {
+      for (int i = 0; i < 100000; ++i)  if (!_p.emit(std::to_string(i)))  { failed = true; break; }
+    });
+    loop.run(UV_RUN_DEFAULT);
+  }
+
+  // the items emitted before an exception are delivered anyway
+  {
+    uv::streaming_work< int > w;
+    int delivered = 0;
+
+    w.on_item() = [&delivered](uv::streaming_work< int >, int&){ ++delivered; };
+    w.on_request() = [&delivered](uv::streaming_work< int > _w)
+    {
+      try  { _w.result(); }
+      catch (const std::exception &_e)
+      {
+        fprintf(stdout, "streaming_work: %s after %i items\n", _e.what(), delivered);
+        fflush(stdout);
+      }
+    };
+
+    w.run(loop, [](uv::streaming_work< int >::producer &_p)
+    {
+      _p.emit(1);
+      _p.emit(2);
+      throw std::runtime_error("task failure");
+    });
+    loop.run(UV_RUN_DEFAULT);
+  }
+
+  return 0;
+}
@@ -0,0 +1,51 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <cinttypes>
+#include <functional>
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::timer_wheel wheel(uv::loop::Default(), 10);
+
+  const uint64_t start = uv::loop::Default().now();
+
+  uv::timer_wheel::timeout timeouts[100];
+  int count = 0;
+  for (int i = 0; i < 100; ++i)
+  {
+    timeouts[i].on_timeout() = [start, &count](uv::timer_wheel::timeout &_t)
+    {
+      ++count;
+      if (uv::loop::Default().now() < _t.due())
+      {
+        fprintf(stdout, "timeout: early expiration (due=%" PRIu64 ")\n", _t.due() - start);
+        fflush(stdout);
+      }
+    };
+    wheel.arm(timeouts[i], 30*i);
+  }
+  for (int i = 0; i < 100; i += 3)  timeouts[i].cancel();
+
+  uv::timer_wheel::timeout batch[10];
+  wheel.on_expire() = [start](uv::timer_wheel _wheel, std::vector< uv::timer_wheel::timeout* > &_batch)
+  {
+    fprintf(stdout, "batch: size=%zu elapsed=%" PRIu64 "\n", _batch.size(), uv::loop::Default().now() - start);
+    fflush(stdout);
+  };
+  for (auto &t : batch)  t.arm(wheel, 4000);
+
+  fprintf(stdout, "armed: %zu\n", wheel.size());
+  fflush(stdout);
+
+  uv::loop::Default().run(UV_RUN_DEFAULT);
+
+  fprintf(stdout, "expired: %i remaining: %zu\n", count, wheel.size());
+  fflush(stdout);
+
+  return 0;
+}
@@ -0,0 +1,79 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+constexpr const int DATAGRAMS = 10000;
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+
+  uv::udp rx(loop, AF_INET), tx(loop, AF_INET), stranger(loop, AF_INET);
+  sockaddr_in rx_addr, tx_addr;
+  uv_ip4_addr("127.0.0.1", 0, &rx_addr);
+  uv_ip4_addr("127.0.0.1", 0, &tx_addr);
+  rx.bind(rx_addr);
+  rx.getsockname(rx_addr);
+  rx.recv_buffer_size(16 << 20);
+  tx.bind(tx_addr);
+  tx.getsockname(tx_addr);
+
+  uv::slab_allocator slab;
+  long received = 0;
+  rx.recv_start(slab, [&received](uv::io, ssize_t _nread, uv::buffer, int64_t, void*){ if (_nread > 0)  ++received; });
+
+  // only the datagrams from the peer are received by a connected socket
+  long from_stranger = 0;
+  tx.recv_start(slab, [&from_stranger](uv::io, ssize_t _nread, uv::buffer, int64_t, void*){ if (_nread > 0)  ++from_stranger; });
+
+  fprintf(stdout, "send before connect: %s\n", uv_err_name(tx.send(uv::buffer{ 100 })));
+  int ret = tx.connect(rx_addr);
+  fprintf(stdout, "connect: %i is_connected=%i\n", ret, tx.is_connected());
+  sockaddr_in peer = {};
+  bool has_peer = tx.getpeername(peer);
+  fprintf(stdout, "getpeername: %i port match=%i\n", has_peer, peer.sin_port == rx_addr.sin_port);
+  fflush(stdout);
+
+  // immediate sends without a request and an address
+  uv::buffer payload{ 100 };
+  int sent = 0, again = 0;
+  const uint64_t start = uv_hrtime();
+  for (int i = 0; i < DATAGRAMS; ++i)
+  {
+    ret = tx.send(payload);
+    if (ret > 0)  ++sent;
+    else if (ret == UV_EAGAIN)  ++again;
+  }
+  fprintf(stdout, "send: sent=%i again=%i time=%.3fms\n", sent, again, (uv_hrtime() - start)/1e6);
+  fflush(stdout);
+
+  // a request without an address
+  uv::udp_send s;
+  s.on_request() = [](uv::udp_send _s, uv::buffer){ fprintf(stdout, "udp_send: status=%i\n", _s.uv_status()); fflush(stdout); };
+  s.run(tx, payload);
+
+  uv::udp_send ss;
+  ss.run(stranger, payload, tx_addr);
+
+  uv::timer t(loop);
+  t.on_timer() = [&](uv::timer)
+  {
+    fprintf(stdout, "received=%li from stranger=%li\n", received, from_stranger);
+    int ret = tx.disconnect();
+    fprintf(stdout, "disconnect: %i send after disconnect: %s\n", ret, uv_err_name(tx.send(payload)));
+    fflush(stdout);
+    rx.recv_stop();
+    tx.recv_stop();
+  };
+  loop.update_time();  // the sending has taken a while
+  t.start(200);
+
+  loop.run(UV_RUN_DEFAULT);
+
+  return 0;
+}
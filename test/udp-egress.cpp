@@ -0,0 +1,78 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+constexpr const int DATAGRAMS = 1000;
+constexpr const std::size_t MAX_COUNT = 100;
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+  uv::slab_allocator slab;
+
+  uv::udp sink(loop, AF_INET);
+  sockaddr_in sink_addr;
+  uv_ip4_addr("127.0.0.1", 0, &sink_addr);
+  sink.bind(sink_addr);
+  sink.getsockname(sink_addr);
+  sink.recv_buffer_size(8 << 20);
+  long received = 0;
+  sink.recv_start(slab, [&received](uv::io, ssize_t _nread, uv::buffer, int64_t, void*){ if (_nread > 0)  ++received; });
+
+  // the receive side of a relay to be paused while its egress is over the limit
+  uv::udp ingress(loop, AF_INET);
+  sockaddr_in ingress_addr;
+  uv_ip4_addr("127.0.0.1", 0, &ingress_addr);
+  ingress.bind(ingress_addr);
+  ingress.recv_start(slab, [](uv::io, ssize_t, uv::buffer, int64_t, void*){});
+
+  const char *names[] = { "DROP_NEWEST", "DROP_OLDEST", "PAUSE_RECEIVE" };
+  const uv::udp::egress_policy policies[] = {
+      uv::udp::egress_policy::DROP_NEWEST, uv::udp::egress_policy::DROP_OLDEST, uv::udp::egress_policy::PAUSE_RECEIVE
+  };
+  uv::udp tx[] = { uv::udp(loop, AF_INET), uv::udp(loop, AF_INET), uv::udp(loop, AF_INET) };
+  int sent[3] = {}, cancelled[3] = {};
+
+  for (int p = 0; p < 3; ++p)
+  {
+    tx[p].set_egress_limits(0, MAX_COUNT, policies[p], ingress);
+
+    int refused = 0;
+    for (int i = 0; i < DATAGRAMS; ++i)
+    {
+      uv::udp_send s;
+      s.on_request() = [&sent, &cancelled, p](uv::udp_send _s, uv::buffer)
+      {
+        if (_s.uv_status() == 0)  ++sent[p];
+        else if (_s.uv_status() == UV_ECANCELED)  ++cancelled[p];
+      };
+      if (s.run(tx[p], uv::buffer{ 100 }, sink_addr) == UV_ENOBUFS)  ++refused;
+    }
+
+    fprintf(stdout, "%s: refused=%i cancelled=%i queued=%zu backlog=%zu dropped=%zu/%zu bytes ingress active=%i\n",
+        names[p], refused, cancelled[p], tx[p].write_queue_size(), tx[p].egress_backlog(),
+        tx[p].egress_dropped_count(), tx[p].egress_dropped_bytes(), ingress.is_active());
+    fflush(stdout);
+  }
+
+  uv::timer t(loop);
+  t.on_timer() = [&](uv::timer)
+  {
+    for (int p = 0; p < 3; ++p)
+      fprintf(stdout, "%s: sent=%i cancelled=%i dropped=%zu\n", names[p], sent[p], cancelled[p], tx[p].egress_dropped_count());
+    fprintf(stdout, "received=%li ingress active=%i\n", received, ingress.is_active());
+    fflush(stdout);
+    sink.recv_stop();
+    ingress.recv_stop();
+  };
+  t.start(200);
+
+  loop.run(UV_RUN_DEFAULT);
+
+  return 0;
+}
@@ -0,0 +1,79 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <vector>
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+
+  // a receiver with GRO gets the coalesced payload and its segment size, one without GRO gets the separate datagrams
+  uv::udp rx[2] = { uv::udp(loop, AF_INET), uv::udp(loop, AF_INET) };
+  sockaddr_in addr[2];
+  for (int gro = 0; gro < 2; ++gro)
+  {
+    uv_ip4_addr("127.0.0.1", 0, &addr[gro]);
+    rx[gro].bind(addr[gro]);
+    rx[gro].getsockname(addr[gro]);
+    if (gro)
+    {
+      fprintf(stdout, "set_gro: %i\n", rx[gro].set_gro(true));
+      fflush(stdout);
+    }
+
+    int ret = rx[gro].recv_batch_start([gro](uv::udp, uv::buffer, const std::vector< uv::udp::datagram > &_batch)
+    {
+      for (auto &d : _batch)
+        fprintf(stdout, "gro=%i: received len=%zu segment_size=%zu\n", gro, static_cast< std::size_t >(d.data.len), d.info.segment_size);
+      fflush(stdout);
+    }, 8, 65536);
+    if (ret < 0)
+    {
+      fprintf(stdout, "recv_batch_start: %s\n", uv_strerror(ret));
+      fflush(stdout);
+      return 0;
+    }
+  }
+
+  uv::udp tx(loop, AF_INET);
+  sockaddr_in any;
+  uv_ip4_addr("0.0.0.0", 0, &any);
+  tx.bind(any);
+
+  auto stop = [&rx, &loop]()
+  {
+    uv::timer t(loop);
+    t.on_timer() = [&rx](uv::timer){ for (auto &r : rx)  r.recv_batch_stop(); };
+    t.start(100);
+  };
+
+  // a 10000 bytes payload split into 1000 bytes segments per datagram of the batch
+  uv::buffer payload{ 10000 };
+  uv::udp_send_batch batch;
+  for (auto &a : addr)  batch.add(payload, a, 1000);
+  batch.on_request() = [&](uv::udp_send_batch _batch)
+  {
+    fprintf(stdout, "udp_send_batch: status=%i sent=%zu\n", _batch.uv_status(), _batch.sent());
+    fflush(stdout);
+
+    // a 2000 bytes payload split into 500 bytes segments for every datagram sent through the socket
+    fprintf(stdout, "set_gso_segment: %i\n", tx.set_gso_segment(500));
+    fflush(stdout);
+    uv::buffer small{ 2000 };
+    for (auto &a : addr)
+    {
+      uv::udp_send s;
+      s.run(tx, small, a);
+    }
+    stop();
+  };
+  if (batch.run(tx) < 0)  stop();
+
+  loop.run(UV_RUN_DEFAULT);
+
+  return 0;
+}
@@ -0,0 +1,79 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <vector>
+#include <sys/socket.h>  // socket() sendto()
+#include <unistd.h>      // close()
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+constexpr const int DATAGRAMS = 100000;
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+
+  uv::udp rx(loop, AF_INET);
+  sockaddr_in addr;
+  uv_ip4_addr("127.0.0.1", 0, &addr);
+  rx.bind(addr);
+  rx.getsockname(addr);
+  rx.recv_buffer_size(8 << 20);
+
+  long received = 0, batches = 0, bytes = 0, truncated = 0;
+  uv::buffer retained;
+
+  int ret = rx.recv_batch_start([&](uv::udp _rx, uv::buffer _buf, const std::vector< uv::udp::datagram > &_batch)
+  {
+    if (_batch.empty())
+    {
+      fprintf(stdout, "recv_batch: error %i\n", _rx.uv_status());
+      fflush(stdout);
+      return;
+    }
+    ++batches;
+    received += _batch.size();
+    for (auto &d : _batch)
+    {
+      bytes += d.data.len;
+      if (d.info.flags & UV_UDP_PARTIAL)  ++truncated;
+    }
+    if (!retained)  retained = _buf;  // the next batch gets a new buffer
+  }, 64, 256);
+  fprintf(stdout, "recv_batch_start: %i\n", ret);
+  fflush(stdout);
+  if (ret < 0)  return 0;
+
+  // send the datagrams in bursts, every 1000th one longer than the slice size
+  int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+  char msg[300] = "datagram";
+  int sent = 0;
+  const uint64_t start = uv_hrtime();
+
+  uv::timer sender(loop);
+  sender.on_timer() = [&](uv::timer _t)
+  {
+    for (int i = 0; i < 1000 and sent < DATAGRAMS; ++i, ++sent)
+      ::sendto(fd, msg, sent % 1000 == 0 ? 300 : 100, 0, reinterpret_cast< sockaddr* >(&addr), sizeof(addr));
+    if (sent < DATAGRAMS)  return;
+
+    _t.stop();
+    uv::timer stopper(loop);
+    stopper.on_timer() = [&rx](uv::timer){ rx.recv_batch_stop(); };
+    stopper.start(200);
+  };
+  sender.repeat_interval(1);
+  sender.start(1);
+
+  loop.run(UV_RUN_DEFAULT);
+  ::close(fd);
+
+  fprintf(stdout, "recv_batch: datagrams=%li/%i batches=%li avg=%.1f truncated=%li bytes=%li retained=%i time=%.3fms\n",
+      received, DATAGRAMS, batches, batches ? double(received)/batches : 0., truncated, bytes, retained.base() != nullptr, (uv_hrtime() - start)/1e6);
+  fflush(stdout);
+
+  return 0;
+}
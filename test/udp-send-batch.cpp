@@ -0,0 +1,69 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <vector>
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+constexpr const int RECEIVERS = 4;
+constexpr const int DATAGRAMS = 10000;
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+
+  std::vector< uv::udp > rx;
+  std::vector< sockaddr_in > addr(RECEIVERS);
+  long received = 0;
+  for (int i = 0; i < RECEIVERS; ++i)
+  {
+    rx.emplace_back(loop, AF_INET);
+    uv_ip4_addr("127.0.0.1", 0, &addr[i]);
+    rx[i].bind(addr[i]);
+    rx[i].getsockname(addr[i]);
+    rx[i].recv_buffer_size(8 << 20);
+    rx[i].recv_batch_start([&received](uv::udp, uv::buffer, const std::vector< uv::udp::datagram > &_batch){ received += _batch.size(); });
+  }
+
+  uv::udp tx(loop, AF_INET);
+  sockaddr_in any;
+  uv_ip4_addr("0.0.0.0", 0, &any);
+  tx.bind(any);
+  tx.send_buffer_size(64 << 10);  // let the socket send buffer become full to make the batch be sent in parts
+
+  uv::buffer payload{ 100 };
+  sockaddr_in6 foreign;  // an address of the family the socket does not support
+  uv_ip6_addr("::1", 9, &foreign);
+
+  uv::udp_send_batch batch;
+  for (int i = 0; i < DATAGRAMS; ++i)  batch.add(payload, addr[i % RECEIVERS]);
+  batch.add(payload, foreign);
+  fprintf(stdout, "udp_send_batch: queued=%zu\n", batch.size());
+  fflush(stdout);
+
+  const uint64_t start = uv_hrtime();
+  batch.on_request() = [&](uv::udp_send_batch _batch)
+  {
+    fprintf(stdout, "udp_send_batch: status=%i sent=%zu failed=%zu queued=%zu time=%.3fms\n",
+        _batch.uv_status(), _batch.sent(), _batch.failed(), _batch.size(), (uv_hrtime() - start)/1e6);
+    fflush(stdout);
+
+    uv::timer stopper(loop);
+    stopper.on_timer() = [&rx](uv::timer){ for (auto &r : rx)  r.recv_batch_stop(); };
+    stopper.start(100);
+  };
+  int ret = batch.run(tx);
+  fprintf(stdout, "udp_send_batch: run=%i\n", ret);
+  fflush(stdout);
+  if (ret < 0)  for (auto &r : rx)  r.recv_batch_stop();
+
+  loop.run(UV_RUN_DEFAULT);
+
+  fprintf(stdout, "received=%li\n", received);
+  fflush(stdout);
+
+  return 0;
+}
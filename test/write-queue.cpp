@@ -0,0 +1,71 @@
+
+#include "uvcc.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>  // O_*
+
+
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+
+constexpr const int WRITES = 100000;
+constexpr const std::size_t LINE = 9;  // "%08i\n"
+
+
+void pass(uv::loop &_loop, const char *_path, bool _coalesce)
+{
+  uv::file f(_loop, _path, O_CREAT|O_RDWR|O_TRUNC, 0644);
+  f.coalesce_writes(_coalesce);
+
+  int completed = 0, failed = 0;
+  bool ordered = true;
+  std::size_t max_queued = 0;
+
+  const uint64_t start = uv_hrtime();
+  for (int i = 0; i < WRITES; ++i)
+  {
+    uv::buffer b{ LINE + 1 };
+    snprintf(b.base(), b.len(), "%08i\n", i);
+    b.len() = LINE;
+
+    uv::fs::write wr;
+    wr.on_request() = [&completed, &failed, &ordered, i](uv::fs::write _wr, uv::buffer)
+    {
+      if (!_wr)  ++failed;
+      if (completed++ != i)  ordered = false;
+    };
+    // appending at the end of the last queued write when coalescing
+    wr.run(f, b, _coalesce ? -1 : int64_t(i)*LINE);
+    if (f.write_queue_size() > max_queued)  max_queued = f.write_queue_size();
+  }
+  _loop.run(UV_RUN_DEFAULT);
+  const double elapsed = (uv_hrtime() - start)/1e6;
+
+  uv::mapped_file m(f);
+  int bad = 0;
+  char expected[LINE + 1];
+  for (int i = 0; m and i < WRITES; ++i)
+  {
+    snprintf(expected, sizeof(expected), "%08i\n", i);
+    if (std::memcmp(m.data() + i*LINE, expected, LINE) != 0)  ++bad;
+  }
+
+  fprintf(stdout, "coalesce=%i: completed=%i failed=%i in order=%i max queued=%zu size=%zu bad lines=%i time=%.3fms\n",
+      _coalesce, completed, failed, ordered, max_queued, m.size(), bad, elapsed);
+  fflush(stdout);
+}
+
+
+int main(int _argc, char *_argv[])
+{
+  uv::loop &loop = uv::loop::Default();
+  const char *path = _argc > 1 ? _argv[1] : "write-queue.tmp";
+
+  pass(loop, path, false);
+  pass(loop, path, true);
+
+  uv::fs::unlink unlink;
+  unlink.run(loop, path);
+
+  return 0;
+}